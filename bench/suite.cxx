@@ -0,0 +1,469 @@
+//
+// ./bench-suite --shape 256 256 256 --threads 4 --output bench.json
+//
+// times the phases of CWX on synthetic segmentations and writes the results
+// as JSON. peak RSS is that of the process and never decreases. to measure
+// one volume in isolation, pass a single --volume. the target bench-suite is
+// compiled with NDEBUG. compile without NDEBUG to time testInvariant.
+//
+
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include "cwx/cwx.hxx"
+#include "cwx/generator.hxx"
+
+typedef unsigned int Label;
+typedef unsigned int Coordinate;
+typedef cwx::CWX<Label, Coordinate> CWX;
+typedef CWX::CellType Cell;
+typedef cwx::ByteLabeledCellgrid<Label, Coordinate> LinearCellgrid;
+typedef cwx::ByteLabeledCellgrid<Label, Coordinate, cwx::BrickedLayout<8> > BrickedCellgrid;
+typedef cwx::ByteLabeledCellgrid<Label, Coordinate, cwx::SparseLayout<16> > SparseCellgrid;
+
+struct Options {
+    Options()
+    :   numberOfThreads(1),
+        numberOfQueries(100000),
+        supervoxelSize(1000),
+        seed(42),
+        outputFileName()
+    {
+        shape[0] = shape[1] = shape[2] = 128;
+    }
+
+    size_t shape[3];
+    std::vector<std::string> volumes;
+    size_t numberOfThreads;
+    size_t numberOfQueries;
+    size_t supervoxelSize;
+    unsigned int seed;
+    std::string outputFileName;
+};
+
+struct Phase {
+    std::string name;
+    double seconds;
+    size_t operations;
+    size_t peakRSS;
+};
+
+// counts the cells of connected components
+struct CellCounter {
+    CellCounter()
+    :   numberOfCells(0)
+    {}
+    bool operator()(const Cell&) {
+        ++numberOfCells;
+        return true;
+    }
+    size_t numberOfCells;
+};
+
+// keeps the first cell of a connected component
+struct FirstCell {
+    bool operator()(const Cell& c) {
+        cell = c;
+        return false;
+    }
+    Cell cell;
+};
+
+// peak resident set size of the process in bytes
+inline size_t
+peakRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+}
+
+template<class FUNCTOR>
+inline Phase
+time(
+    const std::string& name,
+    FUNCTOR functor
+)
+{
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const size_t operations = functor();
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    Phase phase;
+    phase.name = name;
+    phase.seconds = std::chrono::duration<double>(end - begin).count();
+    phase.operations = operations;
+    phase.peakRSS = peakRSS();
+    return phase;
+}
+
+// slabs of 8 voxel slices orthogonal to dimension 2
+void
+slabs(
+    andres::Marray<Label>& seg
+)
+{
+    for(size_t z = 0; z < seg.shape(2); ++z)
+    for(size_t y = 0; y < seg.shape(1); ++y)
+    for(size_t x = 0; x < seg.shape(0); ++x) {
+        seg(x, y, z) = static_cast<Label>(z / 8 + 1);
+    }
+}
+
+// random balls, possibly overlapping, in a background that has label 1.
+// the balls cover about half of the volume.
+void
+blobs(
+    andres::Marray<Label>& seg,
+    std::mt19937& generator
+)
+{
+    for(size_t j = 0; j < seg.size(); ++j) {
+        seg(j) = 1;
+    }
+    const size_t maxRadius = std::max<size_t>(2, std::min(seg.shape(0), std::min(seg.shape(1), seg.shape(2))) / 8);
+    std::uniform_int_distribution<size_t> radiusDistribution(1, maxRadius);
+    std::uniform_int_distribution<size_t> x(0, seg.shape(0) - 1);
+    std::uniform_int_distribution<size_t> y(0, seg.shape(1) - 1);
+    std::uniform_int_distribution<size_t> z(0, seg.shape(2) - 1);
+    double covered = 0;
+    for(Label label = 2; covered < 0.5 * seg.size(); ++label) {
+        const long r = static_cast<long>(radiusDistribution(generator));
+        const long center[] = {static_cast<long>(x(generator)), static_cast<long>(y(generator)), static_cast<long>(z(generator))};
+        for(long c2 = std::max(0L, center[2] - r); c2 <= std::min<long>(seg.shape(2) - 1, center[2] + r); ++c2)
+        for(long c1 = std::max(0L, center[1] - r); c1 <= std::min<long>(seg.shape(1) - 1, center[1] + r); ++c1)
+        for(long c0 = std::max(0L, center[0] - r); c0 <= std::min<long>(seg.shape(0) - 1, center[0] + r); ++c0) {
+            const long d0 = c0 - center[0];
+            const long d1 = c1 - center[1];
+            const long d2 = c2 - center[2];
+            if(d0 * d0 + d1 * d1 + d2 * d2 <= r * r) {
+                seg(c0, c1, c2) = label;
+            }
+        }
+        covered += 4.0 / 3.0 * 3.14159265358979 * r * r * r;
+    }
+}
+
+// one label
+void
+single(
+    andres::Marray<Label>& seg
+)
+{
+    for(size_t j = 0; j < seg.size(); ++j) {
+        seg(j) = 1;
+    }
+}
+
+std::vector<Phase>
+benchmark(
+    const andres::Marray<Label>& seg,
+    const Options& options,
+    CWX& cwx
+)
+{
+    std::vector<Phase> phases;
+    const size_t numberOfVoxels = seg.size();
+
+    phases.push_back(time("build", [&]() {
+        cwx.build(seg, false, options.numberOfThreads);
+        return numberOfVoxels;
+    }));
+
+    // random cells of all orders. 0-cells that are not marked have no label.
+    std::mt19937 generator(options.seed);
+    std::vector<Cell> cells;
+    cells.reserve(options.numberOfQueries);
+    while(cells.size() < options.numberOfQueries) {
+        Cell cell;
+        for(unsigned char d = 0; d < 3; ++d) {
+            cell[d] = std::uniform_int_distribution<Coordinate>(0, 2 * cwx.shape(d) - 2)(generator);
+        }
+        if(cell.order() != 0 || cwx.isMarked(cell)) {
+            cells.push_back(cell);
+        }
+    }
+    phases.push_back(time("atCell", [&]() {
+        CWX::TraversalWorkspaceType workspace;
+        volatile Label label = 0; // keeps the queries from being optimized away
+        for(size_t j = 0; j < cells.size(); ++j) {
+            label = cwx.atCell(cells[j], workspace);
+        }
+        static_cast<void>(label);
+        return cells.size();
+    }));
+
+    phases.push_back(time("process", [&]() {
+        CWX::TraversalWorkspaceType workspace;
+        CellCounter counter;
+        for(unsigned char order = 0; order < 4; ++order) {
+            for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+                cwx.process(order, label, counter, workspace);
+            }
+        }
+        return counter.numberOfCells;
+    }));
+
+    // the same traversals as process, on copies of the grid with different
+    // layouts in memory
+    {
+        std::vector<Cell> firstCells;
+        for(unsigned char order = 1; order < 4; ++order) {
+            for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+                FirstCell first;
+                cwx.process(order, label, first);
+                firstCells.push_back(first.cell);
+            }
+        }
+        LinearCellgrid linear;
+        linear.assign(cwx.grid());
+        phases.push_back(time("traverseLinear", [&]() {
+            CWX::TraversalWorkspaceType workspace;
+            size_t numberOfCells = 0;
+            for(size_t j = 0; j < firstCells.size(); ++j) {
+                cwx::detail::traverseComponent(linear, firstCells[j], [&](const Cell&) {
+                    ++numberOfCells;
+                    return true;
+                }, workspace);
+            }
+            return numberOfCells;
+        }));
+        BrickedCellgrid bricked;
+        bricked.assign(cwx.grid());
+        phases.push_back(time("traverseBricked", [&]() {
+            CWX::TraversalWorkspaceType workspace;
+            size_t numberOfCells = 0;
+            for(size_t j = 0; j < firstCells.size(); ++j) {
+                cwx::detail::traverseComponent(bricked, firstCells[j], [&](const Cell&) {
+                    ++numberOfCells;
+                    return true;
+                }, workspace);
+            }
+            return numberOfCells;
+        }));
+        SparseCellgrid sparse;
+        sparse.assign(cwx.grid());
+        phases.push_back(time("traverseSparse", [&]() {
+            CWX::TraversalWorkspaceType workspace;
+            size_t numberOfCells = 0;
+            for(size_t j = 0; j < firstCells.size(); ++j) {
+                cwx::detail::traverseComponent(sparse, firstCells[j], [&](const Cell&) {
+                    ++numberOfCells;
+                    return true;
+                }, workspace);
+            }
+            return numberOfCells;
+        }));
+    }
+
+    {
+        andres::Marray<Label> out;
+        phases.push_back(time("labeledVoxelGrid", [&]() {
+            cwx.labeledVoxelGrid(out, options.numberOfThreads);
+            return numberOfVoxels;
+        }));
+    }
+    {
+        andres::Marray<Label> out;
+        phases.push_back(time("labeledCellGrid", [&]() {
+            cwx.labeledCellGrid(out, options.numberOfThreads);
+            return (2 * seg.shape(0) - 1) * (2 * seg.shape(1) - 1) * (2 * seg.shape(2) - 1);
+        }));
+    }
+    {
+        andres::Marray<Label> out;
+        phases.push_back(time("labeledVoxelSlice", [&]() {
+            size_t operations = 0;
+            for(unsigned char d = 0; d < 3; ++d) {
+                cwx.labeledVoxelSlice(d, cwx.shape(d) / 2, out);
+                operations += out.size();
+            }
+            return operations;
+        }));
+    }
+
+    // testInvariant does nothing if NDEBUG is defined. otherwise, it is also
+    // called by build and included in the time of build.
+#   ifndef NDEBUG
+    phases.push_back(time("testInvariant", [&]() {
+        cwx.testInvariant();
+        return numberOfVoxels;
+    }));
+#   endif
+
+    return phases;
+}
+
+void
+writeJSON(
+    std::ostream& out,
+    const Options& options,
+    const std::vector<std::string>& volumes,
+    const std::vector<cwx::BuildStats>& buildStats,
+    const std::vector<double>& generationSeconds,
+    const std::vector<std::vector<Phase> >& phases
+)
+{
+    const size_t numberOfVoxels = options.shape[0] * options.shape[1] * options.shape[2];
+    out << "{\n";
+    out << "  \"shape\": [" << options.shape[0] << ", " << options.shape[1] << ", " << options.shape[2] << "],\n";
+    out << "  \"voxels\": " << numberOfVoxels << ",\n";
+    out << "  \"threads\": " << options.numberOfThreads << ",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+#   ifdef NDEBUG
+    out << "  \"assertions\": false,\n";
+#   else
+    out << "  \"assertions\": true,\n";
+#   endif
+    out << "  \"volumes\": [\n";
+    for(size_t j = 0; j < volumes.size(); ++j) {
+        out << "    {\n";
+        out << "      \"name\": \"" << volumes[j] << "\",\n";
+        out << "      \"generationSeconds\": " << generationSeconds[j] << ",\n";
+        const cwx::BuildStats& stats = buildStats[j];
+        out << "      \"cells\": [" << stats.numberOfCells[0] << ", " << stats.numberOfCells[1]
+            << ", " << stats.numberOfCells[2] << ", " << stats.numberOfCells[3] << "],\n";
+        out << "      \"buildStats\": {"
+            << "\"markingTime\": " << stats.markingTime
+            << ", \"labelingTime\": [" << stats.labelingTime[0] << ", " << stats.labelingTime[1]
+            << ", " << stats.labelingTime[2] << ", " << stats.labelingTime[3] << "]"
+            << ", \"connectTime\": [" << stats.connectTime[0] << ", " << stats.connectTime[1]
+            << ", " << stats.connectTime[2] << "]"
+            << ", \"redundantAnchorTime\": " << stats.redundantAnchorTime
+            << ", \"invariantTestTime\": " << stats.invariantTestTime
+            << ", \"anchors\": " << stats.numberOfAnchors
+            << ", \"visitedCells\": " << stats.numberOfVisitedCells
+            << ", \"gridMemory\": " << stats.gridMemory
+            << ", \"complexMemory\": " << stats.complexMemory
+            << ", \"anchorageMemory\": " << stats.anchorageMemory
+            << ", \"peakMemory\": " << stats.peakMemory << "},\n";
+        out << "      \"phases\": [\n";
+        for(size_t k = 0; k < phases[j].size(); ++k) {
+            const Phase& phase = phases[j][k];
+            out << "        {\"name\": \"" << phase.name << "\""
+                << ", \"seconds\": " << phase.seconds
+                << ", \"operations\": " << phase.operations
+                << ", \"operationsPerSecond\": " << (phase.seconds > 0 ? phase.operations / phase.seconds : 0)
+                << ", \"voxelsPerSecond\": " << (phase.seconds > 0 ? numberOfVoxels / phase.seconds : 0)
+                << ", \"peakRSS\": " << phase.peakRSS << "}"
+                << (k + 1 < phases[j].size() ? ",\n" : "\n");
+        }
+        out << "      ]\n";
+        out << "    }" << (j + 1 < volumes.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for(int j = 1; j < argc; ++j) {
+        const std::string argument = argv[j];
+        if(argument == "--shape" && j + 3 < argc) {
+            for(size_t d = 0; d < 3; ++d) {
+                options.shape[d] = std::strtoul(argv[++j], 0, 10);
+            }
+        }
+        else if(argument == "--volume" && j + 1 < argc) {
+            options.volumes.push_back(argv[++j]);
+        }
+        else if(argument == "--threads" && j + 1 < argc) {
+            options.numberOfThreads = std::strtoul(argv[++j], 0, 10);
+        }
+        else if(argument == "--queries" && j + 1 < argc) {
+            options.numberOfQueries = std::strtoul(argv[++j], 0, 10);
+        }
+        else if(argument == "--supervoxel-size" && j + 1 < argc) {
+            options.supervoxelSize = std::strtoul(argv[++j], 0, 10);
+        }
+        else if(argument == "--seed" && j + 1 < argc) {
+            options.seed = static_cast<unsigned int>(std::strtoul(argv[++j], 0, 10));
+        }
+        else if(argument == "--output" && j + 1 < argc) {
+            options.outputFileName = argv[++j];
+        }
+        else {
+            std::cerr << "Parameters: [--shape <n0> <n1> <n2>] [--volume voronoi|shells|sheets|tunnels|fragments|slabs|blobs|single]..." << std::endl
+                << "    [--threads <n>] [--queries <n>] [--supervoxel-size <voxels>] [--seed <n>] [--output <json-file>]" << std::endl;
+            return 1;
+        }
+    }
+    if(options.shape[0] == 0 || options.shape[1] == 0 || options.shape[2] == 0) {
+        std::cerr << "shape must be positive." << std::endl;
+        return 1;
+    }
+    if(options.volumes.empty()) {
+        options.volumes.push_back("voronoi");
+        options.volumes.push_back("shells");
+        options.volumes.push_back("sheets");
+        options.volumes.push_back("tunnels");
+        options.volumes.push_back("fragments");
+        options.volumes.push_back("slabs");
+        options.volumes.push_back("blobs");
+        options.volumes.push_back("single");
+    }
+
+    std::vector<cwx::BuildStats> buildStats;
+    std::vector<double> generationSeconds;
+    std::vector<std::vector<Phase> > phases;
+    for(size_t j = 0; j < options.volumes.size(); ++j) {
+        const std::string& volume = options.volumes[j];
+        std::mt19937 generator(options.seed);
+        andres::Marray<Label> seg(options.shape, options.shape + 3);
+        const Phase generation = time("generate", [&]() {
+            if(volume == "voronoi") {
+                const size_t cellSize = std::max<size_t>(1, static_cast<size_t>(std::cbrt(static_cast<double>(options.supervoxelSize))));
+                cwx::generateVoronoi(seg, cellSize, options.seed, options.numberOfThreads);
+            }
+            else if(volume == "shells") {
+                cwx::generateShells(seg, 4, options.seed, options.numberOfThreads);
+            }
+            else if(volume == "sheets") {
+                cwx::generateSheets(seg, 8, options.seed, options.numberOfThreads);
+            }
+            else if(volume == "tunnels") {
+                cwx::generateTunnels(seg, 12, 2, options.seed, options.numberOfThreads);
+            }
+            else if(volume == "fragments") {
+                cwx::generateFragments(seg, 6, options.seed, options.numberOfThreads);
+            }
+            else if(volume == "slabs") {
+                slabs(seg);
+            }
+            else if(volume == "blobs") {
+                blobs(seg, generator);
+            }
+            else if(volume == "single") {
+                single(seg);
+            }
+            else {
+                throw std::runtime_error("unknown volume " + volume + ".");
+            }
+            return seg.size();
+        });
+
+        CWX cwx;
+        phases.push_back(benchmark(seg, options, cwx));
+        generationSeconds.push_back(generation.seconds);
+        buildStats.push_back(cwx.buildStats());
+    }
+
+    if(options.outputFileName.empty()) {
+        writeJSON(std::cout, options, options.volumes, buildStats, generationSeconds, phases);
+    }
+    else {
+        std::ofstream file(options.outputFileName.c_str());
+        writeJSON(file, options, options.volumes, buildStats, generationSeconds, phases);
+    }
+
+    return 0;
+}
@@ -1,9 +1,11 @@
 #include <string>
 #include <random>
 #include <fstream>
+#include <cstdlib>
 
 #include "andres/marray_hdf5.hxx"
 #include "cwx/cwx.hxx"
+#include "cwx/hdf5.hxx"
 #include "cwx/sketch.hxx"
 
 inline void test(const bool& pred) {
@@ -13,8 +15,8 @@ inline void test(const bool& pred) {
 int main(int argc, char **argv) {
     using namespace andres;
     
-    if(argc != 3) {
-        std::cerr << "Parameters: <input-hdf5-file> <input-dataset>" << std::endl;
+    if(argc != 3 && argc != 4) {
+        std::cerr << "Parameters: <input-hdf5-file> <input-dataset> [<memory-budget-in-MB>]" << std::endl;
         return 1;
     }
     std::string fileName = argv[1];
@@ -23,20 +25,27 @@ int main(int argc, char **argv) {
     typedef unsigned int Label;
     typedef unsigned int Coordinate;
 
-    // load volume labeling
-    Marray<Label> volumeLabeling;
-    hid_t file = hdf5::openFile(fileName);
-    hdf5::load(file, datasetName, volumeLabeling);
-    hdf5::closeFile(file);
-
-    // build CWX data structure
     cwx::CWX<Label, Coordinate> cwx;
-    cwx.build(volumeLabeling, true);
+    if(argc == 4) {
+        // build CWX data structure, reading the volume labeling in slabs
+        const size_t memoryBudget = std::strtoul(argv[3], 0, 10) * 1024 * 1024;
+        cwx::buildFromHDF5<Label>(cwx, fileName, datasetName, memoryBudget, true);
+    }
+    else {
+        // load volume labeling
+        Marray<Label> volumeLabeling;
+        hid_t file = hdf5::openFile(fileName);
+        hdf5::load(file, datasetName, volumeLabeling);
+        hdf5::closeFile(file);
+
+        // build CWX data structure
+        cwx.build(volumeLabeling, true);
+    }
     
     // TODO: add tests here
     
     hid_t outFile(hdf5::createFile("out.h5"));
-    hdf5::save(outFile, "cwx", cwx.grid());
+    ::cwx::save(outFile, "cwx", cwx);
     hdf5::closeFile(outFile);
 
     return 0;
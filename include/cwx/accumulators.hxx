@@ -0,0 +1,221 @@
+#pragma once
+#ifndef CWX_ACCUMULATORS_HXX
+#define CWX_ACCUMULATORS_HXX
+
+#include <cstddef>
+#include <limits>
+
+#include "cwx/cell.hxx"
+
+namespace cwx {
+
+// accumulators of geometric features of cells, for use with
+// CWX::accumulate. an accumulator is default-constructible and has the
+// member functions
+// - template<class C> void operator()(const Cell<C>&), called once for
+//   every grid cell of a cell of the CW-complex, in no particular order
+// - void merge(const ACCUMULATOR&), which adds the grid cells accumulated by
+//   another accumulator
+// coordinates are those of the cell grid, i.e. twice the voxel coordinates
+// for 3-cells.
+
+/// number of grid cells: the volume of a 3-cell in voxels, the area of a
+/// 2-cell in faces and the length of a 1-cell in edges.
+class Count {
+public:
+    Count();
+    template<class C> void operator()(const Cell<C>&);
+    void merge(const Count&);
+    size_t count() const;
+
+private:
+    size_t count_;
+};
+
+/// smallest box of cell coordinates that contains all grid cells.
+class BoundingBox {
+public:
+    BoundingBox();
+    template<class C> void operator()(const Cell<C>&);
+    void merge(const BoundingBox&);
+    size_t min(const size_t) const;
+    size_t max(const size_t) const;
+
+private:
+    size_t min_[3];
+    size_t max_[3]; // inclusive
+};
+
+/// mean cell coordinates of the grid cells.
+class Centroid {
+public:
+    Centroid();
+    template<class C> void operator()(const Cell<C>&);
+    void merge(const Centroid&);
+    double centroid(const size_t) const;
+
+private:
+    size_t count_;
+    double sum_[3];
+};
+
+/// accumulator that combines the given accumulators by deriving from all of
+/// them, e.g. Accumulators<Count, BoundingBox>.
+template<class... ACCUMULATORS>
+class Accumulators : public ACCUMULATORS... {
+public:
+    template<class C> void operator()(const Cell<C>&);
+    void merge(const Accumulators<ACCUMULATORS...>&);
+};
+
+inline
+Count::Count()
+:   count_(0)
+{}
+
+template<class C>
+inline void
+Count::operator()(
+    const Cell<C>&
+)
+{
+    ++count_;
+}
+
+inline void
+Count::merge(
+    const Count& other
+)
+{
+    count_ += other.count_;
+}
+
+inline size_t
+Count::count() const
+{
+    return count_;
+}
+
+inline
+BoundingBox::BoundingBox()
+{
+    for(size_t d = 0; d < 3; ++d) {
+        min_[d] = std::numeric_limits<size_t>::max();
+        max_[d] = 0;
+    }
+}
+
+template<class C>
+inline void
+BoundingBox::operator()(
+    const Cell<C>& cell
+)
+{
+    for(size_t d = 0; d < 3; ++d) {
+        const size_t c = static_cast<size_t>(cell[d]);
+        if(c < min_[d]) {
+            min_[d] = c;
+        }
+        if(c > max_[d]) {
+            max_[d] = c;
+        }
+    }
+}
+
+inline void
+BoundingBox::merge(
+    const BoundingBox& other
+)
+{
+    for(size_t d = 0; d < 3; ++d) {
+        if(other.min_[d] < min_[d]) {
+            min_[d] = other.min_[d];
+        }
+        if(other.max_[d] > max_[d]) {
+            max_[d] = other.max_[d];
+        }
+    }
+}
+
+// greatest size_t if no grid cell has been accumulated
+inline size_t
+BoundingBox::min(
+    const size_t d
+) const
+{
+    return min_[d];
+}
+
+inline size_t
+BoundingBox::max(
+    const size_t d
+) const
+{
+    return max_[d];
+}
+
+inline
+Centroid::Centroid()
+:   count_(0)
+{
+    for(size_t d = 0; d < 3; ++d) {
+        sum_[d] = 0;
+    }
+}
+
+template<class C>
+inline void
+Centroid::operator()(
+    const Cell<C>& cell
+)
+{
+    ++count_;
+    for(size_t d = 0; d < 3; ++d) {
+        sum_[d] += static_cast<double>(cell[d]);
+    }
+}
+
+inline void
+Centroid::merge(
+    const Centroid& other
+)
+{
+    count_ += other.count_;
+    for(size_t d = 0; d < 3; ++d) {
+        sum_[d] += other.sum_[d];
+    }
+}
+
+// 0 if no grid cell has been accumulated
+inline double
+Centroid::centroid(
+    const size_t d
+) const
+{
+    return count_ == 0 ? 0 : sum_[d] / static_cast<double>(count_);
+}
+
+template<class... ACCUMULATORS>
+template<class C>
+inline void
+Accumulators<ACCUMULATORS...>::operator()(
+    const Cell<C>& cell
+)
+{
+    const int expand[] = {0, (ACCUMULATORS::operator()(cell), 0)...};
+    static_cast<void>(expand);
+}
+
+template<class... ACCUMULATORS>
+inline void
+Accumulators<ACCUMULATORS...>::merge(
+    const Accumulators<ACCUMULATORS...>& other
+)
+{
+    const int expand[] = {0, (ACCUMULATORS::merge(static_cast<const ACCUMULATORS&>(other)), 0)...};
+    static_cast<void>(expand);
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_ACCUMULATORS_HXX
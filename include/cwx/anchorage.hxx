@@ -2,11 +2,12 @@
 #ifndef ANDRES_CWX_ANCHORAGE_HXX
 #define ANDRES_CWX_ANCHORAGE_HXX
 
+#include <cassert>
 #include <array>
 #include <vector>
-#include <map>
 
 #include "cwx/cell.hxx"
+#include "cwx/cell-map.hxx"
 
 namespace cwx {
 
@@ -23,23 +24,46 @@ public:
 
     // query
     Label numberOfCells(const Order) const;
+    size_t numberOfAnchors() const;
+    size_t memory() const;
     Label anchor(const CellType&) const;
+    Label anchor(const PackedCell&) const;
     void anchor(const Order, const Label, CellType&) const;
+    template<class FUNCTOR> void forEachAnchor(FUNCTOR) const;
 
     // manipulation
     void anchor(const CellType&, const Label);
+    void reanchor(const CellType&, const Label);
     Label push_back(const CellType&);
+    void reserve(const size_t);
+    void erase(const CellType&);
+    void merge(const Order, const Label, const Label);
+    void erase(const Order, const Label);
 
 private:
-    std::map<CellType, Label> labelAtCell_;
+    void indirect(const Order);
+
+    CellMap<Label, Coordinate> labelAtCell_;
     std::array<std::vector<CellType>, 4> cellForLabel_;
+    std::array<std::vector<Label>, 4> labelOfId_;
+    std::array<std::vector<Label>, 4> nextId_;
+    std::array<std::vector<Label>, 4> firstId_;
+    // labelAtCell_ maps every anchor to its label. once labels of an order
+    // have been merged or erased, it maps the anchors of this order to ids
+    // instead. labelOfId_[order][id] is the label of the id (0 for ids of
+    // erased labels), and the ids of a label form a linked list that starts
+    // at firstId_[order][label] and continues with nextId_[order][id]. thus,
+    // merging labels relabels all their anchors at once.
 };
 
 template<class T, class C>
 inline
 Anchorage<T, C>::Anchorage()
 :   labelAtCell_(),
-    cellForLabel_()
+    cellForLabel_(),
+    labelOfId_(),
+    nextId_(),
+    firstId_()
 {
     // inser zero labels
     cellForLabel_.fill(std::vector<CellType>(1));
@@ -59,6 +83,28 @@ Anchorage<T, C>::numberOfCells(
     return static_cast<Label>(cellForLabel_[order].size() - 1);
 }
 
+// returns the number of cells that have a label, including the anchors
+// added by push_back
+template<class T, class C>
+inline size_t
+Anchorage<T, C>::numberOfAnchors() const
+{
+    return labelAtCell_.size();
+}
+
+// bytes allocated for anchors
+template<class T, class C>
+inline size_t
+Anchorage<T, C>::memory() const
+{
+    size_t bytes = labelAtCell_.memory();
+    for(size_t order = 0; order < 4; ++order) {
+        bytes += cellForLabel_[order].capacity() * sizeof(CellType)
+            + (labelOfId_[order].capacity() + nextId_[order].capacity()
+            + firstId_[order].capacity()) * sizeof(Label);
+    }
+    return bytes;
+}
 
 template<class T, class C>
 inline typename Anchorage<T, C>::Label
@@ -66,14 +112,20 @@ Anchorage<T, C>::anchor(
     const CellType& cell
 ) const
 {
-    typename std::map<CellType, Label>::const_iterator it
-        = labelAtCell_.find(cell);
-    if(it == labelAtCell_.end()) { // if not found
-        return 0;
-    }
-    else {
-        return it->second;
+    return anchor(PackedCell(cell));
+}
+
+template<class T, class C>
+inline typename Anchorage<T, C>::Label
+Anchorage<T, C>::anchor(
+    const PackedCell& cell
+) const
+{
+    const Label label = labelAtCell_[cell]; // 0 if not found
+    if(label == 0 || labelOfId_[cell.order()].empty()) {
+        return label;
     }
+    return labelOfId_[cell.order()][label];
 }
 
 template<class T, class C>
@@ -89,6 +141,25 @@ Anchorage<T, C>::anchor(
     cell = cellForLabel_[order][label];
 }
 
+// calls functor(cell, label) for all anchors, in no particular order
+template<class T, class C>
+template<class FUNCTOR>
+inline void
+Anchorage<T, C>::forEachAnchor(
+    FUNCTOR functor
+) const
+{
+    labelAtCell_.forEach([&](const CellType& cell, const Label label) {
+        const std::vector<Label>& labelOfId = labelOfId_[cell.order()];
+        if(labelOfId.empty()) {
+            functor(cell, label);
+        }
+        else if(labelOfId[label] != 0) {
+            functor(cell, labelOfId[label]);
+        }
+    });
+}
+
 // add another anchor for a label that already has an anchor (precondition)
 template<class T, class C>
 inline void
@@ -98,15 +169,33 @@ Anchorage<T, C>::anchor(
 )
 {
     const Order order = cell.order();
-    assert(label <= numberOfCells(order));
-#   ifndef NDEBUG
-        typename std::map<CellType, Label>::const_iterator it;
-        it = labelAtCell_.find(cell);
-        if(it != labelAtCell_.end()) { // if this cell is already labeled
-            assert(it->second == label); // assert consistent with existing label
+    assert(label != 0 && label <= numberOfCells(order));
+    assert(anchor(cell) == 0 || anchor(cell) == label); // consistent with existing label
+    if(labelOfId_[order].empty()) {
+        labelAtCell_.insert(cell, label); // over-write or insert
+    }
+    else {
+        if(firstId_[order][label] == 0) { // all anchors of the label have been merged into another label
+            firstId_[order][label] = static_cast<Label>(labelOfId_[order].size());
+            labelOfId_[order].push_back(label);
+            nextId_[order].push_back(0);
         }
-#   endif
-    labelAtCell_[cell] = label; // over-write or insert
+        labelAtCell_.insert(cell, firstId_[order][label]);
+    }
+}
+
+// makes a cell the first cell of a label and anchors it, e.g. after the
+// former first cell has become part of another cell
+template<class T, class C>
+inline void
+Anchorage<T, C>::reanchor(
+    const CellType& cell,
+    const Label label
+)
+{
+    assert(label != 0 && label <= numberOfCells(cell.order()));
+    cellForLabel_[cell.order()][label] = cell;
+    anchor(cell, label);
 }
 
 template<class T, class C>
@@ -115,14 +204,126 @@ Anchorage<T, C>::push_back(
     const CellType& cell
 )
 {
-    assert(labelAtCell_.find(cell) == labelAtCell_.end()); // not already there
+    assert(anchor(cell) == 0); // not already there
     cellForLabel_[cell.order()].push_back(cell);
     const Label label = static_cast<Label>(cellForLabel_[cell.order()].size() - 1);
     assert(label != 0);
-    labelAtCell_[cell] = label; // insert
+    const Order order = cell.order();
+    if(labelOfId_[order].empty()) {
+        labelAtCell_.insert(cell, label);
+    }
+    else {
+        const Label id = static_cast<Label>(labelOfId_[order].size());
+        labelOfId_[order].push_back(label);
+        nextId_[order].push_back(0);
+        firstId_[order].push_back(id);
+        labelAtCell_.insert(cell, id);
+    }
     return label;
 }
 
+// prepares the index for the given total number of anchors such that no
+// rehashing is needed until this number is exceeded
+template<class T, class C>
+inline void
+Anchorage<T, C>::reserve(
+    const size_t numberOfAnchors
+)
+{
+    labelAtCell_.reserve(numberOfAnchors);
+}
+
+// removes an anchor. does nothing if the cell is not an anchor.
+template<class T, class C>
+inline void
+Anchorage<T, C>::erase(
+    const CellType& cell
+)
+{
+    labelAtCell_.erase(cell);
+}
+
+// assigns all anchors of a label to another label of the same order. the
+// first label keeps its first cell but has no anchors anymore and is
+// expected to be erased.
+// the cost is proportional to the number of labels merged into the first
+// label before.
+template<class T, class C>
+void
+Anchorage<T, C>::merge(
+    const Order order,
+    const Label label,
+    const Label into
+)
+{
+    assert(label != 0 && label <= numberOfCells(order));
+    assert(into != 0 && into <= numberOfCells(order));
+    assert(label != into);
+    indirect(order);
+    Label id = firstId_[order][label];
+    if(id == 0) {
+        return;
+    }
+    for(;;) {
+        labelOfId_[order][id] = into;
+        if(nextId_[order][id] == 0) {
+            break;
+        }
+        id = nextId_[order][id];
+    }
+    nextId_[order][id] = firstId_[order][into];
+    firstId_[order][into] = firstId_[order][label];
+    firstId_[order][label] = 0;
+}
+
+// removes a label. anchors that still refer to it are no longer found. the
+// last label of the order takes its place, with all its anchors, such that
+// labels remain contiguous.
+template<class T, class C>
+void
+Anchorage<T, C>::erase(
+    const Order order,
+    const Label label
+)
+{
+    assert(label != 0 && label <= numberOfCells(order));
+    indirect(order);
+    for(Label id = firstId_[order][label]; id != 0; id = nextId_[order][id]) {
+        labelOfId_[order][id] = 0;
+    }
+    const Label last = numberOfCells(order);
+    if(label != last) {
+        for(Label id = firstId_[order][last]; id != 0; id = nextId_[order][id]) {
+            labelOfId_[order][id] = label;
+        }
+        firstId_[order][label] = firstId_[order][last];
+        cellForLabel_[order][label] = cellForLabel_[order][last];
+    }
+    firstId_[order].pop_back();
+    cellForLabel_[order].pop_back();
+}
+
+// switches the anchors of the given order from labels to ids, with one id
+// per label
+template<class T, class C>
+void
+Anchorage<T, C>::indirect(
+    const Order order
+)
+{
+    if(!labelOfId_[order].empty()) {
+        return;
+    }
+    const Label n = numberOfCells(order);
+    labelOfId_[order].resize(n + 1);
+    firstId_[order].resize(n + 1);
+    nextId_[order].assign(n + 1, 0);
+    for(Label label = 0; label <= n; ++label) {
+        labelOfId_[order][label] = label;
+        firstId_[order][label] = label;
+    }
+}
+
 } // namespace cwx
 
 #endif // #ifndef ANDRES_CWX_ANCHORAGE_HXX
@@ -0,0 +1,141 @@
+#pragma once
+#ifndef CWX_BUILD_STATS_HXX
+#define CWX_BUILD_STATS_HXX
+
+#include <cstddef>
+#include <chrono>
+#include <ostream>
+
+namespace cwx {
+
+/// statistics of CWX::build and CWX::buildFromSlabs.
+///
+/// times are wall-clock seconds. memory is in bytes, as allocated by the
+/// data structures at the end of the build. collecting the statistics costs
+/// a few clock readings per phase and a pass over the CW-complex at the end.
+struct BuildStats {
+    BuildStats();
+
+    // times
+    double loadingTime; // loading slabs (buildFromSlabs only)
+    double markingTime; // marking cells, not including loadingTime
+    double labelingTime[4]; // labeling cells of order 0, 1, 2, 3
+    double connectTime[3]; // connecting cells of order 0, 1, 2 to those above
+    double redundantAnchorTime;
+    double invariantTestTime; // 0 if NDEBUG is defined
+    double totalTime;
+
+    // counts
+    size_t numberOfCells[4];
+    size_t numberOfAnchors;
+    size_t numberOfVisitedCells; // by traversals of components in slices, for redundant anchors
+
+    // memory
+    size_t gridMemory;
+    size_t complexMemory;
+    size_t anchorageMemory;
+    size_t labelCacheMemory;
+    size_t peakMemory; // estimated peak memory of the build, cf. CWX::buildMemory
+};
+
+std::ostream& operator<<(std::ostream&, const BuildStats&);
+
+namespace detail {
+
+// wall-clock time since construction or the last restart
+class Stopwatch {
+public:
+    Stopwatch();
+    double seconds() const;
+    double restart();
+
+private:
+    std::chrono::steady_clock::time_point begin_;
+};
+
+} // namespace detail
+
+inline
+BuildStats::BuildStats()
+:   loadingTime(0),
+    markingTime(0),
+    redundantAnchorTime(0),
+    invariantTestTime(0),
+    totalTime(0),
+    numberOfAnchors(0),
+    numberOfVisitedCells(0),
+    gridMemory(0),
+    complexMemory(0),
+    anchorageMemory(0),
+    labelCacheMemory(0),
+    peakMemory(0)
+{
+    for(size_t j = 0; j < 4; ++j) {
+        labelingTime[j] = 0;
+        numberOfCells[j] = 0;
+    }
+    for(size_t j = 0; j < 3; ++j) {
+        connectTime[j] = 0;
+    }
+}
+
+inline std::ostream&
+operator<<(
+    std::ostream& out,
+    const BuildStats& stats
+)
+{
+    out << "loading: " << stats.loadingTime << " s" << std::endl
+        << "marking: " << stats.markingTime << " s" << std::endl;
+    for(size_t order = 0; order < 4; ++order) {
+        out << "labeling " << order << "-cells: " << stats.labelingTime[order] << " s" << std::endl;
+    }
+    for(size_t order = 0; order < 3; ++order) {
+        out << "connecting " << order << "-cells: " << stats.connectTime[order] << " s" << std::endl;
+    }
+    out << "redundant anchors: " << stats.redundantAnchorTime << " s" << std::endl
+        << "invariant test: " << stats.invariantTestTime << " s" << std::endl
+        << "total: " << stats.totalTime << " s" << std::endl
+        << "cells:";
+    for(size_t order = 0; order < 4; ++order) {
+        out << " " << stats.numberOfCells[order];
+    }
+    out << std::endl
+        << "anchors: " << stats.numberOfAnchors << std::endl
+        << "visited cells: " << stats.numberOfVisitedCells << std::endl
+        << "memory: grid " << stats.gridMemory
+        << ", complex " << stats.complexMemory
+        << ", anchorage " << stats.anchorageMemory
+        << ", label cache " << stats.labelCacheMemory
+        << ", peak " << stats.peakMemory << " bytes" << std::endl;
+    return out;
+}
+
+namespace detail {
+
+inline
+Stopwatch::Stopwatch()
+:   begin_(std::chrono::steady_clock::now())
+{}
+
+inline double
+Stopwatch::seconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_).count();
+}
+
+// returns the seconds before the restart
+inline double
+Stopwatch::restart()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double elapsed = std::chrono::duration<double>(now - begin_).count();
+    begin_ = now;
+    return elapsed;
+}
+
+} // namespace detail
+
+} // namespace cwx
+
+#endif // #ifndef CWX_BUILD_STATS_HXX
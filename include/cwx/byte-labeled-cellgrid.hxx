@@ -5,13 +5,24 @@
 #include <cassert>
 #include <string>
 #include <sstream>
+#include <stdexcept>
+#include <algorithm>
 
 #include "marray.hxx"
 #include "cwx/cellgrid.hxx"
+#include "cwx/grid-layout.hxx"
 
 namespace cwx {
 
-template<class T, class C>
+namespace detail {
+    template<class T, class C, class LAYOUT> class Marker; // marking engine for INTERNAL use with CWX<T, C>::build
+}
+template<class T, class C> class ByteLabeledCellgridView;
+
+/// one byte per voxel that marks the cells of the voxel and anchors its
+/// 3-cell. LAYOUT determines how the bytes are arranged in memory, cf.
+/// grid-layout.hxx.
+template<class T, class C, class LAYOUT = LinearLayout>
 class ByteLabeledCellgrid 
 : public Cellgrid<T, C>
 {
@@ -22,8 +33,8 @@ public:
     typedef typename CellgridType::CellType CellType;
     typedef typename CellgridType::CellVector CellVector;
     typedef typename CellType::Order Order;
-    typedef andres::Marray<unsigned char> GridType;
-    typedef andres::View<unsigned char> GridViewType;
+    typedef LAYOUT LayoutType;
+    typedef typename LayoutType::ExportType GridViewType;
 
     // construction and assignment
     ByteLabeledCellgrid();
@@ -31,99 +42,209 @@ public:
 
     // query
     bool isMarked(const CellType&) const;
+    bool isMarked(const PackedCell&) const;
     bool isAnchored(const CellType&) const;
+    bool isAnchored(const PackedCell&) const;
+    unsigned char operator()(const Coordinate, const Coordinate, const Coordinate) const;
+    size_t memory() const;
     std::string asString() const;
 
     // manipulation
     void resize(const Coordinate, const Coordinate, const Coordinate);
+    template<bool B> void assign(const andres::View<unsigned char, B>&);
+    template<bool B> void assignSlices(const Coordinate, const andres::View<unsigned char, B>&);
     void mark(const CellType&, const bool);
     void anchor(const CellType&, const bool);
     
-    const GridViewType grid() const { return grid_; }
+    const GridViewType grid() const { return grid_.grid(); }
 
 private:
     unsigned char byte(const CellType&) const;
     Coordinate gc(const Coordinate) const;
 
-    GridType grid_;
+    LayoutType grid_;
     static const unsigned char byte_[2][2][2];
+
+friend class detail::Marker<T, C, LAYOUT>;
+friend class ByteLabeledCellgridView<T, C>;
 };
 
+/// read-only ByteLabeledCellgrid whose bytes are stored in external memory,
+/// e.g. in a memory-mapped file, with the first coordinate fastest.
 template<class T, class C>
-const unsigned char ByteLabeledCellgrid<T, C>::byte_[2][2][2] = {
+class ByteLabeledCellgridView
+: public Cellgrid<T, C>
+{
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef Cellgrid<Label, Coordinate> CellgridType;
+    typedef typename CellgridType::CellType CellType;
+    typedef typename CellgridType::CellVector CellVector;
+    typedef typename CellType::Order Order;
+
+    ByteLabeledCellgridView();
+    ByteLabeledCellgridView(const Coordinate, const Coordinate, const Coordinate, const unsigned char*);
+
+    // query
+    bool isMarked(const CellType&) const;
+    bool isMarked(const PackedCell&) const;
+    bool isAnchored(const CellType&) const;
+    bool isAnchored(const PackedCell&) const;
+    unsigned char operator()(const Coordinate, const Coordinate, const Coordinate) const;
+
+private:
+    size_t index(const CellType&) const;
+    size_t index(const PackedCell&) const;
+
+    const unsigned char* data_;
+};
+
+template<class T, class C, class LAYOUT>
+const unsigned char ByteLabeledCellgrid<T, C, LAYOUT>::byte_[2][2][2] = {
     { {128, 1}, {2, 4} },
     { {8, 16}, {32, 64} }
 };
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline
-ByteLabeledCellgrid<T, C>::ByteLabeledCellgrid()
+ByteLabeledCellgrid<T, C, LAYOUT>::ByteLabeledCellgrid()
 :   CellgridType(), 
     grid_()
 {}
 
-// Cartesian coordinates (not cell coordinates)
-template<class T, class C>
+// Cartesian coordinates (not cell coordinates). throws if the shape
+// exceeds detail::maximumShape along any axis.
+template<class T, class C, class LAYOUT>
 inline
-ByteLabeledCellgrid<T, C>::ByteLabeledCellgrid(
+ByteLabeledCellgrid<T, C, LAYOUT>::ByteLabeledCellgrid(
     const Coordinate n0,
     const Coordinate n1,
     const Coordinate n2
 )
-#ifndef _MSC_VER // MSVC does currently not support initializer lists
 :   CellgridType(n0, n1, n2), 
-    grid_({n0, n1, n2})
-#else
-:   CellgridType(n0, n1, n2)
-#endif
+    grid_()
 {
     assert(n0 > 0 && n1 > 0 && n2 > 0);
-#   ifdef _MSC_VER // MSVC does currently not support initializer lists
-        size_t shape[] = {n0, n1, n2};
-        grid_.resize(shape, shape + 3);
-#   endif
+    detail::testShape(n0, n1, n2);
+    grid_.resize(n0, n1, n2);
 }
 
-// voxel coordinates, not cell coordinates
-template<class T, class C>
+// voxel coordinates, not cell coordinates. throws if the shape exceeds
+// detail::maximumShape along any axis.
+template<class T, class C, class LAYOUT>
 inline void
-ByteLabeledCellgrid<T, C>::resize(
+ByteLabeledCellgrid<T, C, LAYOUT>::resize(
     const Coordinate n0,
     const Coordinate n1,
     const Coordinate n2
 )
 {
     assert(n0 > 0 && n1 > 0 && n2 > 0);
+    detail::testShape(n0, n1, n2);
     static_cast<CellgridType*>(this)->resize(n0, n1, n2);
-#   ifdef _MSC_VER // MSVC does currently not support initializer lists
-        size_t shape[] = {n0, n1, n2};
-        grid_.resize(shape, shape + 3);
-#   else
-        grid_.resize({n0, n1, n2});
-#   endif
+    grid_.resize(n0, n1, n2);
 }
 
-template<class T, class C>
+// copies all bytes from a 3-dimensional array of the shape of the volume,
+// e.g. from a grid that has been saved
+template<class T, class C, class LAYOUT>
+template<bool B>
+void
+ByteLabeledCellgrid<T, C, LAYOUT>::assign(
+    const andres::View<unsigned char, B>& grid
+)
+{
+    if(grid.dimension() != 3) {
+        throw std::runtime_error("grid is not 3-dimensional.");
+    }
+    resize(grid.shape(0), grid.shape(1), grid.shape(2));
+    grid_.assign(grid);
+}
+
+// copies the bytes of the voxel slices [sliceBegin, sliceBegin +
+// grid.shape(2)) of dimension 2 from a 3-dimensional array, e.g. from a
+// grid that is loaded in slabs. bytes that are 0 are written by set, such
+// that they do not allocate memory in a sparse layout.
+template<class T, class C, class LAYOUT>
+template<bool B>
+void
+ByteLabeledCellgrid<T, C, LAYOUT>::assignSlices(
+    const Coordinate sliceBegin,
+    const andres::View<unsigned char, B>& grid
+)
+{
+    if(grid.dimension() != 3 || grid.shape(0) != this->shape(0) || grid.shape(1) != this->shape(1)
+    || static_cast<size_t>(sliceBegin) + grid.shape(2) > this->shape(2)) {
+        throw std::runtime_error("slices do not fit into the grid.");
+    }
+    for(size_t z = 0; z < grid.shape(2); ++z)
+    for(size_t y = 0; y < grid.shape(1); ++y)
+    for(size_t x = 0; x < grid.shape(0); ++x) {
+        grid_.set(x, y, sliceBegin + z, grid(x, y, z));
+    }
+}
+
+template<class T, class C, class LAYOUT>
 inline bool
-ByteLabeledCellgrid<T, C>::isMarked(
+ByteLabeledCellgrid<T, C, LAYOUT>::isMarked(
     const CellType& cell
 ) const
 {
     return grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) & byte(cell);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
+inline bool
+ByteLabeledCellgrid<T, C, LAYOUT>::isMarked(
+    const PackedCell& cell
+) const
+{
+    return grid_(static_cast<Coordinate>(cell[0] >> 1), static_cast<Coordinate>(cell[1] >> 1), static_cast<Coordinate>(cell[2] >> 1))
+        & byte_[cell.isOdd(0)][cell.isOdd(1)][cell.isOdd(2)];
+}
+
+template<class T, class C, class LAYOUT>
 inline bool
-ByteLabeledCellgrid<T, C>::isAnchored(
+ByteLabeledCellgrid<T, C, LAYOUT>::isAnchored(
     const CellType& cell
 ) const
 {
     return grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) & 128;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
+inline bool
+ByteLabeledCellgrid<T, C, LAYOUT>::isAnchored(
+    const PackedCell& cell
+) const
+{
+    return grid_(static_cast<Coordinate>(cell[0] >> 1), static_cast<Coordinate>(cell[1] >> 1), static_cast<Coordinate>(cell[2] >> 1)) & 128;
+}
+
+// byte of a voxel, voxel coordinates
+template<class T, class C, class LAYOUT>
+inline unsigned char
+ByteLabeledCellgrid<T, C, LAYOUT>::operator()(
+    const Coordinate x,
+    const Coordinate y,
+    const Coordinate z
+) const
+{
+    return grid_(x, y, z);
+}
+
+// bytes allocated for the grid
+template<class T, class C, class LAYOUT>
+inline size_t
+ByteLabeledCellgrid<T, C, LAYOUT>::memory() const
+{
+    return grid_.memory();
+}
+
+template<class T, class C, class LAYOUT>
 std::string
-ByteLabeledCellgrid<T, C>::asString() const
+ByteLabeledCellgrid<T, C, LAYOUT>::asString() const
 {
     std::stringstream s;
     CellType c;
@@ -149,54 +270,146 @@ ByteLabeledCellgrid<T, C>::asString() const
     return s.str();
 }
 
-template<class T, class C>
+// the byte is written by set, such that unmarking a cell in a sparse layout
+// does not allocate memory
+template<class T, class C, class LAYOUT>
 inline void
-ByteLabeledCellgrid<T, C>::mark(
+ByteLabeledCellgrid<T, C, LAYOUT>::mark(
     const CellType& cell,
     const bool value
 )
 {
-    if(value) {
-        grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) |= byte(cell);
-    }
-    else {
-        grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) &= -byte(cell);
-    }
+    const Coordinate x = gc(cell[0]);
+    const Coordinate y = gc(cell[1]);
+    const Coordinate z = gc(cell[2]);
+    const unsigned char b = static_cast<const LayoutType&>(grid_)(x, y, z);
+    grid_.set(x, y, z, value ? b | byte(cell) : b & static_cast<unsigned char>(~byte(cell)));
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline void
-ByteLabeledCellgrid<T, C>::anchor(
+ByteLabeledCellgrid<T, C, LAYOUT>::anchor(
     const CellType& cell,
     const bool value
 )
 {
-    if(value) {
-        grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) |= 128;
-    }
-    else {
-        grid_(gc(cell[0]), gc(cell[1]), gc(cell[2])) &= 127;
-    }
+    const Coordinate x = gc(cell[0]);
+    const Coordinate y = gc(cell[1]);
+    const Coordinate z = gc(cell[2]);
+    const unsigned char b = static_cast<const LayoutType&>(grid_)(x, y, z);
+    grid_.set(x, y, z, value ? b | 128 : b & 127);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline unsigned char
-ByteLabeledCellgrid<T, C>::byte(
+ByteLabeledCellgrid<T, C, LAYOUT>::byte(
     const CellType& cell
 ) const
 {
-    return ByteLabeledCellgrid<T, C>::byte_[cell[0] % 2][cell[1] % 2][cell[2] % 2];
+    return ByteLabeledCellgrid<T, C, LAYOUT>::byte_[cell[0] % 2][cell[1] % 2][cell[2] % 2];
 }
 
-template<class T, class C>
-inline typename ByteLabeledCellgrid<T, C>::Coordinate
-ByteLabeledCellgrid<T, C>::gc(
+template<class T, class C, class LAYOUT>
+inline typename ByteLabeledCellgrid<T, C, LAYOUT>::Coordinate
+ByteLabeledCellgrid<T, C, LAYOUT>::gc(
     const Coordinate c
 ) const
 {
     return (c - (c % 2)) / 2;
 }
 
+template<class T, class C>
+inline
+ByteLabeledCellgridView<T, C>::ByteLabeledCellgridView()
+:   CellgridType(),
+    data_(0)
+{}
+
+// Cartesian coordinates (not cell coordinates). throws if the shape
+// exceeds detail::maximumShape along any axis.
+template<class T, class C>
+inline
+ByteLabeledCellgridView<T, C>::ByteLabeledCellgridView(
+    const Coordinate n0,
+    const Coordinate n1,
+    const Coordinate n2,
+    const unsigned char* data
+)
+:   CellgridType(n0, n1, n2),
+    data_(data)
+{
+    assert(n0 > 0 && n1 > 0 && n2 > 0);
+    detail::testShape(n0, n1, n2);
+}
+
+template<class T, class C>
+inline bool
+ByteLabeledCellgridView<T, C>::isMarked(
+    const CellType& cell
+) const
+{
+    return data_[index(cell)] & ByteLabeledCellgrid<T, C>::byte_[cell[0] % 2][cell[1] % 2][cell[2] % 2];
+}
+
+template<class T, class C>
+inline bool
+ByteLabeledCellgridView<T, C>::isMarked(
+    const PackedCell& cell
+) const
+{
+    return data_[index(cell)] & ByteLabeledCellgrid<T, C>::byte_[cell.isOdd(0)][cell.isOdd(1)][cell.isOdd(2)];
+}
+
+template<class T, class C>
+inline bool
+ByteLabeledCellgridView<T, C>::isAnchored(
+    const CellType& cell
+) const
+{
+    return data_[index(cell)] & 128;
+}
+
+template<class T, class C>
+inline bool
+ByteLabeledCellgridView<T, C>::isAnchored(
+    const PackedCell& cell
+) const
+{
+    return data_[index(cell)] & 128;
+}
+
+// byte of a voxel, voxel coordinates
+template<class T, class C>
+inline unsigned char
+ByteLabeledCellgridView<T, C>::operator()(
+    const Coordinate x,
+    const Coordinate y,
+    const Coordinate z
+) const
+{
+    return data_[x + static_cast<size_t>(this->shape(0)) * (y + static_cast<size_t>(this->shape(1)) * z)];
+}
+
+template<class T, class C>
+inline size_t
+ByteLabeledCellgridView<T, C>::index(
+    const CellType& cell
+) const
+{
+    return cell[0] / 2 + static_cast<size_t>(this->shape(0))
+        * (cell[1] / 2 + static_cast<size_t>(this->shape(1)) * (cell[2] / 2));
+}
+
+template<class T, class C>
+inline size_t
+ByteLabeledCellgridView<T, C>::index(
+    const PackedCell& cell
+) const
+{
+    return static_cast<size_t>(cell[0] >> 1) + static_cast<size_t>(this->shape(0))
+        * (static_cast<size_t>(cell[1] >> 1) + static_cast<size_t>(this->shape(1)) * static_cast<size_t>(cell[2] >> 1));
+}
+
 } // namespace cwx
 
 #endif // #ifndef CWX_BYTE_LABELED_CELLGRID_HXX
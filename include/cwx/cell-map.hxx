@@ -0,0 +1,229 @@
+#pragma once
+#ifndef CWX_CELL_MAP_HXX
+#define CWX_CELL_MAP_HXX
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "cwx/cell.hxx"
+#include "cwx/packed-cell.hxx"
+
+namespace cwx {
+
+/// map from cells to non-zero labels.
+///
+/// the map is an open-addressing hash table with linear probing, keyed by
+/// the packed coordinates of cells. slots with label 0 are empty.
+template<class T, class C>
+class CellMap {
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef Cell<Coordinate> CellType;
+
+    CellMap();
+
+    // query
+    size_t size() const;
+    size_t memory() const;
+    Label operator[](const CellType&) const;
+    Label operator[](const PackedCell&) const;
+    template<class FUNCTOR> void forEach(FUNCTOR) const;
+
+    // manipulation
+    void insert(const CellType&, const Label);
+    void erase(const CellType&);
+    void reserve(const size_t);
+    void clear();
+
+private:
+    typedef uint64_t Key;
+
+    size_t slot(const Key) const;
+    void rehash(const size_t);
+
+    std::vector<Key> keys_;
+    std::vector<Label> labels_;
+    size_t size_;
+};
+
+template<class T, class C>
+inline
+CellMap<T, C>::CellMap()
+:   keys_(),
+    labels_(),
+    size_(0)
+{}
+
+template<class T, class C>
+inline size_t
+CellMap<T, C>::size() const
+{
+    return size_;
+}
+
+// returns the number of bytes allocated for the table
+template<class T, class C>
+inline size_t
+CellMap<T, C>::memory() const
+{
+    return keys_.capacity() * sizeof(Key) + labels_.capacity() * sizeof(Label);
+}
+
+// returns 0 if the cell is not in the map
+template<class T, class C>
+inline typename CellMap<T, C>::Label
+CellMap<T, C>::operator[](
+    const CellType& cell
+) const
+{
+    return (*this)[PackedCell(cell)];
+}
+
+template<class T, class C>
+inline typename CellMap<T, C>::Label
+CellMap<T, C>::operator[](
+    const PackedCell& cell
+) const
+{
+    if(labels_.empty()) {
+        return 0;
+    }
+    return labels_[slot(cell.key())];
+}
+
+// calls functor(cell, label) for all cells in the map, in no particular order
+template<class T, class C>
+template<class FUNCTOR>
+inline void
+CellMap<T, C>::forEach(
+    FUNCTOR functor
+) const
+{
+    for(size_t j = 0; j < labels_.size(); ++j) {
+        if(labels_[j] != 0) {
+            functor(detail::unpackCell<Coordinate>(keys_[j]), labels_[j]);
+        }
+    }
+}
+
+// inserts or over-writes the label of a cell
+template<class T, class C>
+inline void
+CellMap<T, C>::insert(
+    const CellType& cell,
+    const Label label
+)
+{
+    assert(label != 0);
+    if((size_ + 1) * 4 > labels_.size() * 3) { // max. load factor 3/4
+        rehash(labels_.empty() ? 16 : 2 * labels_.size());
+    }
+    const Key key = detail::packCell(cell);
+    const size_t j = slot(key);
+    if(labels_[j] == 0) {
+        keys_[j] = key;
+        ++size_;
+    }
+    labels_[j] = label;
+}
+
+// removes a cell from the map. does nothing if the cell is not in the map.
+// the entries that follow in the probe sequence are shifted back into the
+// gap such that no tombstones are needed.
+template<class T, class C>
+inline void
+CellMap<T, C>::erase(
+    const CellType& cell
+)
+{
+    if(labels_.empty()) {
+        return;
+    }
+    size_t j = slot(detail::packCell(cell));
+    if(labels_[j] == 0) {
+        return;
+    }
+    labels_[j] = 0;
+    --size_;
+    const size_t mask = labels_.size() - 1;
+    for(size_t k = (j + 1) & mask; labels_[k] != 0; k = (k + 1) & mask) {
+        const size_t home = detail::hashPackedCell(keys_[k], mask);
+        // the entry at k can be moved to j if its home slot is not cyclically in (j, k]
+        const bool movable = j < k ? (home <= j || home > k) : (home <= j && home > k);
+        if(movable) {
+            keys_[j] = keys_[k];
+            labels_[j] = labels_[k];
+            labels_[k] = 0;
+            j = k;
+        }
+    }
+}
+
+// prepares the table for the given number of cells such that no rehashing
+// is needed until this number is exceeded
+template<class T, class C>
+inline void
+CellMap<T, C>::reserve(
+    const size_t size
+)
+{
+    size_t capacity = 16;
+    while(capacity / 4 * 3 < size) {
+        capacity *= 2;
+    }
+    if(capacity > labels_.size()) {
+        rehash(capacity);
+    }
+}
+
+template<class T, class C>
+inline void
+CellMap<T, C>::clear()
+{
+    std::vector<Key>().swap(keys_);
+    std::vector<Label>().swap(labels_);
+    size_ = 0;
+}
+
+// returns the slot that holds the key or, if the key is not in the table,
+// the empty slot where the key would be inserted
+template<class T, class C>
+inline size_t
+CellMap<T, C>::slot(
+    const Key key
+) const
+{
+    assert(!labels_.empty());
+    const size_t mask = labels_.size() - 1;
+    size_t j = detail::hashPackedCell(key, mask);
+    while(labels_[j] != 0 && keys_[j] != key) {
+        j = (j + 1) & mask;
+    }
+    return j;
+}
+
+template<class T, class C>
+void
+CellMap<T, C>::rehash(
+    const size_t capacity
+)
+{
+    assert((capacity & (capacity - 1)) == 0); // power of 2
+    std::vector<Key> keys(capacity);
+    std::vector<Label> labels(capacity, 0);
+    keys_.swap(keys);
+    labels_.swap(labels);
+    for(size_t j = 0; j < labels.size(); ++j) {
+        if(labels[j] != 0) {
+            const size_t k = slot(keys[j]);
+            keys_[k] = keys[j];
+            labels_[k] = labels[j];
+        }
+    }
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_CELL_MAP_HXX
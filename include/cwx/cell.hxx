@@ -4,9 +4,11 @@
 #ifndef CWX_CELL_HXX
 #define CWX_CELL_HXX
 
+#include <cstdint>
 #include <vector>
 #include <array>
 #include <cassert>
+#include <stdexcept>
 
 namespace cwx {
 
@@ -233,6 +235,72 @@ Cell<C>::corners(
     }
 }
 
+namespace detail {
+
+// the largest number of voxels along any axis for which all cell coordinates,
+// up to 2 * shape - 2, fit into the 21 bits of packCell
+const uint64_t maximumShape = uint64_t(1) << 20;
+
+// throws if a cell coordinate of a volume of the given shape does not fit
+// into the 21 bits of packCell. packed cells of larger volumes would alias.
+template<class C>
+inline void
+testShape(
+    const C shape0,
+    const C shape1,
+    const C shape2
+)
+{
+    if(static_cast<uint64_t>(shape0) > maximumShape
+    || static_cast<uint64_t>(shape1) > maximumShape
+    || static_cast<uint64_t>(shape2) > maximumShape) {
+        throw std::runtime_error("shape exceeds 2^20 voxels along an axis.");
+    }
+}
+
+// packs the coordinates of a cell into 21 bits each. the packed values of
+// cells are ordered like the cells.
+template<class C>
+inline uint64_t
+packCell(
+    const Cell<C>& cell
+)
+{
+    assert(static_cast<uint64_t>(cell[0]) < (uint64_t(1) << 21));
+    assert(static_cast<uint64_t>(cell[1]) < (uint64_t(1) << 21));
+    assert(static_cast<uint64_t>(cell[2]) < (uint64_t(1) << 21));
+    return (static_cast<uint64_t>(cell[2]) << 42)
+        | (static_cast<uint64_t>(cell[1]) << 21)
+        | static_cast<uint64_t>(cell[0]);
+}
+
+// inverse of packCell
+template<class C>
+inline Cell<C>
+unpackCell(
+    const uint64_t key
+)
+{
+    const uint64_t mask = (uint64_t(1) << 21) - 1;
+    return Cell<C>(
+        static_cast<C>(key & mask),
+        static_cast<C>((key >> 21) & mask),
+        static_cast<C>(key >> 42));
+}
+
+// hash of a packed cell for tables with 2^k slots, k <= 32. multiplicative
+// (fibonacci) hashing spreads neighboring cells over the table.
+inline size_t
+hashPackedCell(
+    const uint64_t key,
+    const size_t mask
+)
+{
+    return static_cast<size_t>((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & mask;
+}
+
+} // namespace detail
+
 } // namespace cwx
 
 #endif // #ifndef CWX_CELL_HXX
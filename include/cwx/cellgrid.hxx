@@ -6,6 +6,7 @@
 
 #include "stack-vector.hxx"
 #include "cwx/cell.hxx"
+#include "cwx/packed-cell.hxx"
 
 namespace cwx {
 
@@ -35,8 +36,15 @@ public:
     bool firstCell(const Order, const Order, const Coordinate, CellType&) const;
     bool orderPreservingIncrement(CellType&) const;
     bool orderPreservingIncrement(const Order, CellType&) const;
+    template<class FUNCTOR> bool forEachCell(const Order, FUNCTOR) const;
+    template<class FUNCTOR> bool forEachCell(const Order, const Order, const Coordinate, FUNCTOR) const;
+    template<class FUNCTOR> bool forEachCellInSlab(const Order, const Coordinate, const Coordinate, FUNCTOR) const;
     void above(const CellType&, CellVector&) const;
     void below(const CellType&, CellVector&) const;
+    template<Order ORDER, class FUNCTOR> void forEachAbove(const CellType&, FUNCTOR) const;
+    template<Order ORDER, class FUNCTOR> void forEachBelow(const CellType&, FUNCTOR) const;
+    template<Order ORDER, class FUNCTOR> void forEachAbove(const PackedCell&, FUNCTOR) const;
+    template<Order ORDER, class FUNCTOR> void forEachBelow(const PackedCell&, FUNCTOR) const;
 
     // query topology (subset of the interface of CWComplex)
     size_t sizeAbove(const Order, const Label) const;
@@ -51,6 +59,8 @@ public:
 private:
     unsigned char byte(const CellType&) const;
     Coordinate gc(const Coordinate) const;
+    static int rowParity(const Order, const Coordinate, const Coordinate);
+    bool seekRow(const Order, const Order, const Order, const Order, const bool, CellType&) const;
 
     Coordinate shape_[3];
 };
@@ -116,10 +126,15 @@ Cellgrid<T, C>::numberOfCells(
     }
 }
 
+// cells of order k are iterated in scan order (dimension 0 fastest) by
+// stepping along rows in dimension 0 with stride 2. in each row, the parity
+// of the coordinate in dimension 0 is determined by the order and the
+// parities of the other two coordinates. rows in which no parity fits are
+// skipped.
+
 // writes the first cell of the given order to the parameter cell
 // and returns true if such a cell exists. returns false and leaves
 // cell in an undefined state, otherwise.
-// TODO: implement this function more efficiently using the functions label and cell of Cellgrid
 template<class T, class C>
 inline bool
 Cellgrid<T, C>::firstCell(
@@ -128,31 +143,16 @@ Cellgrid<T, C>::firstCell(
 ) const
 {
     assert(order < 4);
-    cell.assign(0, 0, 0);
-    while(cell.order() != order) {
-        // increment cell
-        for(Order j = 0; j < 3; ++j) {
-            if(cell[j] < 2 * shape(j) - 2) {
-                ++cell[j];
-                break;
-            }
-            else {
-                if(j == 2) {
-                    return false;
-                }
-                else {
-                    cell[j] = 0;
-                }
-            }
-        }
+    if(shape(0) == 0 || shape(1) == 0 || shape(2) == 0) {
+        return false;
     }
-    return true;
+    cell.assign(0, 0, 0);
+    return seekRow(order, 0, 1, 2, false, cell);
 }
 
 // writes the first cell of the given order to the parameter cell
 // and returns true if such a cell exists. returns false and leaves
 // cell in an undefined state, otherwise.
-// TODO: implement this function more efficiently
 template<class T, class C>
 inline bool
 Cellgrid<T, C>::firstCell(
@@ -166,39 +166,13 @@ Cellgrid<T, C>::firstCell(
     assert(fixedValue < 2*shape(fixedDimension)-1);
     cell.assign(0, 0, 0);
     cell[fixedDimension] = fixedValue;
-    while(cell.order() != order) {
-        // increment cell
-        for(Order j = 0; j < 3; ++j) {
-            if(j == fixedDimension) {
-                if(j == 2) {
-                    return false;
-                }
-                else {
-                    continue;
-                }
-            }
-            else {
-                if(cell[j] < 2 * shape(j) - 2) {
-                    ++cell[j];
-                    break;
-                }
-                else {
-                    if(j == 2) {
-                        return false;
-                    }
-                    else {
-                        cell[j] = 0;
-                    }
-                }
-            }
-        }
-    }
-    return true;
+    const Order d0 = fixedDimension == 0 ? 1 : 0;
+    const Order d1 = fixedDimension == 2 ? 1 : 2;
+    return seekRow(order, d0, d1, fixedDimension, true, cell);
 }
 
 // returns true if a succeeding cell of the same order was
 // found and false if the end of the grid has been reached
-// TODO: implement this function more efficiently
 template<class T, class C>
 inline bool
 Cellgrid<T, C>::orderPreservingIncrement(
@@ -206,30 +180,23 @@ Cellgrid<T, C>::orderPreservingIncrement(
 ) const
 {
     const Order order = cell.order();
-    do {
-        // increment cell
-        for(Order j = 0; j < 3; ++j) {
-            if(cell[j] < 2 * shape(j) - 2) {
-                ++cell[j];
-                break;
-            }
-            else {
-                if(j == 2) {
-                    return false;
-                }
-                else {
-                    cell[j] = 0;
-                }
-            }
+    cell[0] += 2;
+    if(cell[0] < 2 * shape(0) - 1) {
+        return true;
+    }
+    // next row
+    if(++cell[1] == 2 * shape(1) - 1) {
+        cell[1] = 0;
+        if(++cell[2] == 2 * shape(2) - 1) {
+            return false;
         }
-    } while(cell.order() != order);
-    return true;
+    }
+    return seekRow(order, 0, 1, 2, false, cell);
 }
 
 // returns true if a succeeding cell of the same order was
 // found and false if the end of the grid has been reached.
 // one coordinate (fix) is fixed.
-// TODO: implement this function more efficiently
 template<class T, class C>
 inline bool
 Cellgrid<T, C>::orderPreservingIncrement(
@@ -238,33 +205,98 @@ Cellgrid<T, C>::orderPreservingIncrement(
 ) const
 {
     const Order order = cell.order();
-    do {
-        // increment cell
-        for(Order j = 0; j < 3; ++j) {
-            if(j == fixedDimension) {
-                if(j == 2) {
-                    return false;
-                }
-                else {
-                    continue;
-                }
+    const Order d0 = fixedDimension == 0 ? 1 : 0;
+    const Order d1 = fixedDimension == 2 ? 1 : 2;
+    cell[d0] += 2;
+    if(cell[d0] < 2 * shape(d0) - 1) {
+        return true;
+    }
+    // next row
+    if(++cell[d1] == 2 * shape(d1) - 1) {
+        return false;
+    }
+    return seekRow(order, d0, d1, fixedDimension, true, cell);
+}
+
+// calls functor(cell) for all cells of the given order in scan order.
+// if the functor returns false, the iteration is stopped and false is
+// returned.
+template<class T, class C>
+template<class FUNCTOR>
+inline bool
+Cellgrid<T, C>::forEachCell(
+    const Order order,
+    FUNCTOR functor
+) const
+{
+    if(shape(2) == 0) {
+        return true;
+    }
+    return forEachCellInSlab(order, 0, 2 * shape(2) - 1, functor);
+}
+
+// calls functor(cell) for all cells of the given order with
+// cell[fixedDimension] == fixedValue in scan order. if the functor returns
+// false, the iteration is stopped and false is returned.
+template<class T, class C>
+template<class FUNCTOR>
+bool
+Cellgrid<T, C>::forEachCell(
+    const Order order,
+    const Order fixedDimension,
+    const Coordinate fixedValue,
+    FUNCTOR functor
+) const
+{
+    assert(order < 4);
+    assert(fixedValue < 2*shape(fixedDimension)-1);
+    const Order d0 = fixedDimension == 0 ? 1 : 0;
+    const Order d1 = fixedDimension == 2 ? 1 : 2;
+    CellType cell;
+    cell[fixedDimension] = fixedValue;
+    for(cell[d1] = 0; cell[d1] < 2 * shape(d1) - 1; ++cell[d1]) {
+        const int parity = rowParity(order, cell[d1], fixedValue);
+        if(parity < 0 || parity > 1) {
+            continue;
+        }
+        for(cell[d0] = parity; cell[d0] < 2 * shape(d0) - 1; cell[d0] += 2) {
+            if(!functor(static_cast<const CellType&>(cell))) {
+                return false;
             }
-            else {
-                if(cell[j] < 2 * shape(j) - 2) {
-                    ++cell[j];
-                    break;
-                }
-                else {
-                    if(j == 2) {
-                        return false;
-                    }
-                    else {
-                        cell[j] = 0;
-                    }
+        }
+    }
+    return true;
+}
+
+// calls functor(cell) for all cells of the given order with
+// begin <= cell[2] < end in scan order. if the functor returns false, the
+// iteration is stopped and false is returned.
+template<class T, class C>
+template<class FUNCTOR>
+bool
+Cellgrid<T, C>::forEachCellInSlab(
+    const Order order,
+    const Coordinate begin,
+    const Coordinate end,
+    FUNCTOR functor
+) const
+{
+    assert(order < 4);
+    assert(end <= 2 * shape(2) - 1);
+    CellType cell;
+    for(cell[2] = begin; cell[2] < end; ++cell[2]) {
+        for(cell[1] = 0; cell[1] < 2 * shape(1) - 1; ++cell[1]) {
+            const int parity = rowParity(order, cell[1], cell[2]);
+            if(parity < 0 || parity > 1) {
+                continue;
+            }
+            for(cell[0] = parity; cell[0] < 2 * shape(0) - 1; cell[0] += 2) {
+                if(!functor(static_cast<const CellType&>(cell))) {
+                    return false;
                 }
             }
         }
-    } while(cell.order() != order);
+    }
     return true;
 }
 
@@ -439,6 +471,104 @@ Cellgrid<T, C>::below(
     }
 }
 
+// calls functor(c) for the cells c above a cell of order ORDER, in the
+// order of above(cell, cellsAbove). as the order is fixed at compile time,
+// the only decision left per cell is its orientation.
+template<class T, class C>
+template<typename Cellgrid<T, C>::Order ORDER, class FUNCTOR>
+inline void
+Cellgrid<T, C>::forEachAbove(
+    const CellType& cell,
+    FUNCTOR functor
+) const
+{
+    assert(cell.order() == ORDER);
+    for(Order j = 0; j < 3; ++j) {
+        if(ORDER == 0 || (ORDER < 3 && cell[j] % 2 == 1)) {
+            CellType c = cell;
+            --c[j];
+            functor(c);
+            c[j] += 2;
+            functor(c);
+        }
+    }
+}
+
+// calls functor(c) for the cells c below a cell of order ORDER, in the
+// order of below(cell, cellsBelow)
+template<class T, class C>
+template<typename Cellgrid<T, C>::Order ORDER, class FUNCTOR>
+inline void
+Cellgrid<T, C>::forEachBelow(
+    const CellType& cell,
+    FUNCTOR functor
+) const
+{
+    assert(cell.order() == ORDER);
+    for(Order j = 0; j < 3; ++j) {
+        if(ORDER == 3 || (ORDER > 0 && cell[j] % 2 == 0)) {
+            if(cell[j] > 0) {
+                CellType c = cell;
+                --c[j];
+                functor(c);
+            }
+            if(cell[j] < 2 * shape(j) - 2) {
+                CellType c = cell;
+                ++c[j];
+                functor(c);
+            }
+        }
+    }
+}
+
+// packed cells, see above
+template<class T, class C>
+template<typename Cellgrid<T, C>::Order ORDER, class FUNCTOR>
+inline void
+Cellgrid<T, C>::forEachAbove(
+    const PackedCell& cell,
+    FUNCTOR functor
+) const
+{
+    assert(cell.order() == ORDER);
+    for(Order j = 0; j < 3; ++j) {
+        if(ORDER == 0 || (ORDER < 3 && cell.isOdd(j))) {
+            PackedCell c = cell;
+            c.decrement(j);
+            functor(c);
+            c = cell;
+            c.increment(j);
+            functor(c);
+        }
+    }
+}
+
+// packed cells, see above
+template<class T, class C>
+template<typename Cellgrid<T, C>::Order ORDER, class FUNCTOR>
+inline void
+Cellgrid<T, C>::forEachBelow(
+    const PackedCell& cell,
+    FUNCTOR functor
+) const
+{
+    assert(cell.order() == ORDER);
+    for(Order j = 0; j < 3; ++j) {
+        if(ORDER == 3 || (ORDER > 0 && !cell.isOdd(j))) {
+            if(cell[j] > 0) {
+                PackedCell c = cell;
+                c.decrement(j);
+                functor(c);
+            }
+            if(cell[j] + 2 < 2 * static_cast<PackedCell::Key>(shape(j))) {
+                PackedCell c = cell;
+                c.increment(j);
+                functor(c);
+            }
+        }
+    }
+}
+
 // Cartesian coordinates (not cell coordinates)
 template<class T, class C>
 inline void
@@ -733,6 +863,53 @@ Cellgrid<T, C>::cell(
     assert(cell.order() == order);
 }
 
+// returns the parity that the coordinate in the dimension of a row must
+// have for a cell of the given order, given the other two coordinates.
+// returns a value other than 0 and 1 if no cell of this order is in the row.
+template<class T, class C>
+inline int
+Cellgrid<T, C>::rowParity(
+    const Order order,
+    const Coordinate c1,
+    const Coordinate c2
+)
+{
+    return 3 - static_cast<int>(order) - static_cast<int>(c1 % 2) - static_cast<int>(c2 % 2);
+}
+
+// moves cell to the first cell of the given order in scan order, starting
+// at the beginning of the row in dimension d0 at the current coordinates
+// in the dimensions d1 and d2. rows are advanced along d1 and then d2,
+// unless d2 is fixed.
+template<class T, class C>
+inline bool
+Cellgrid<T, C>::seekRow(
+    const Order order,
+    const Order d0,
+    const Order d1,
+    const Order d2,
+    const bool d2IsFixed,
+    CellType& cell
+) const
+{
+    for(;;) {
+        const int parity = rowParity(order, cell[d1], cell[d2]);
+        if((parity == 0 || parity == 1) && static_cast<Coordinate>(parity) < 2 * shape(d0) - 1) {
+            cell[d0] = parity;
+            return true;
+        }
+        if(++cell[d1] == 2 * shape(d1) - 1) {
+            if(d2IsFixed) {
+                return false;
+            }
+            cell[d1] = 0;
+            if(++cell[d2] == 2 * shape(d2) - 1) {
+                return false;
+            }
+        }
+    }
+}
+
 } // namespace cwx
 
 #endif // #ifndef CWX_CELLGRID_HXX
@@ -0,0 +1,622 @@
+#pragma once
+#ifndef CWX_COMPONENT_LABELING_HXX
+#define CWX_COMPONENT_LABELING_HXX
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "cwx/byte-labeled-cellgrid.hxx"
+#include "cwx/parallel.hxx"
+
+namespace cwx {
+namespace detail {
+
+/// labeling of the connected components of all cells of one order.
+///
+/// two k-cells are connected if they bound the same unmarked (k-1)-cell.
+/// all 3-cells are considered, and all marked k-cells for k = 1, 2.
+/// components are labeled 1, 2, ... in the scan order of their first cell
+/// (ascending by z, y, x as in Cell::operator<), which is the order in which
+/// CWX::process(order, functor) visits components.
+///
+/// the volume is labeled slice by slice, for slices of voxels orthogonal to
+/// dimension 2. the cells of one slice are united by union-find over the
+/// cells of this slice. every component of a slice is given an index, and
+/// indices are united across adjacent slices by union-find over indices.
+/// only the labels of indices are kept, such that memory is proportional to
+/// the size of a slice and to the number of components of all slices, not
+/// to the size of the volume. the labels of the cells of a slice are
+/// recomputed on demand, see Slice.
+///
+/// slabs of slices are processed in parallel, with indices that are unique
+/// within a slab. unions across slab borders are performed afterwards.
+template<class T, class C, class LAYOUT = LinearLayout>
+class ComponentLabeling {
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef ByteLabeledCellgrid<Label, Coordinate, LAYOUT> ByteLabeledCellgridType;
+    typedef typename ByteLabeledCellgridType::CellType CellType;
+    typedef typename ByteLabeledCellgridType::CellVector CellVector;
+    typedef typename ByteLabeledCellgridType::Order Order;
+    typedef uint32_t Index;
+    class Slice;
+
+    ComponentLabeling(const ByteLabeledCellgridType&, const Order, const size_t = 1);
+
+    Order order() const;
+    Label numberOfComponents() const;
+    size_t numberOfCells() const;
+    const CellType& firstCell(const Label) const;
+    template<class FUNCTOR> void forEachCell(FUNCTOR) const;
+    size_t memory() const;
+    size_t peakMemory() const;
+    static size_t sliceMemory(const Coordinate, const Coordinate, const Order);
+    void clearFirstCells();
+
+private:
+    static const Index none = 0xffffffff;
+
+    size_t sliceSize() const;
+    size_t index(const CellType&) const;
+    CellType cell(const Coordinate, const size_t) const;
+    Index labelSlice(const Coordinate, const Index, std::vector<Index>&,
+        std::vector<Index>&, std::vector<Index>*) const;
+    void uniteSlices(const Coordinate, const std::vector<Index>&,
+        const std::vector<Index>&, std::vector<Index>&) const;
+    template<Order ORDER>
+        Index labelSlice(const Coordinate, const Index, std::vector<Index>&,
+            std::vector<Index>&, std::vector<Index>*) const;
+    template<Order ORDER>
+        void uniteSlices(const Coordinate, const std::vector<Index>&,
+            const std::vector<Index>&, std::vector<Index>&) const;
+    static Index find(std::vector<Index>&, Index);
+    static void merge(std::vector<Index>&, const Index, const Index);
+
+    const ByteLabeledCellgridType& grid_;
+    Order order_;
+    Label numberOfComponents_;
+    size_t numberOfCells_;
+    std::vector<Index> sliceBegins_; // first index of every slice, and the number of indices
+    std::vector<Label> labels_; // indexed by index
+    std::vector<CellType> firstCells_; // indexed by label
+    size_t peakMemory_;
+};
+
+/// labels of the cells of one slice of a ComponentLabeling.
+///
+/// assign(z, buffer) recomputes the components of the cells of the slice z
+/// with the help of a buffer that can be shared by several slices. the cost
+/// is that of labeling one slice.
+template<class T, class C, class LAYOUT>
+class ComponentLabeling<T, C, LAYOUT>::Slice {
+public:
+    Slice(const ComponentLabeling<T, C, LAYOUT>&);
+
+    void assign(const Coordinate, std::vector<Index>&);
+    Coordinate z() const;
+    Label label(const CellType&) const;
+    template<class FUNCTOR> void forEachCell(FUNCTOR) const;
+    void swap(Slice&);
+
+private:
+    const ComponentLabeling<T, C, LAYOUT>* labeling_;
+    Coordinate z_;
+    std::vector<Index> indices_; // indexed by index(cell), none for cells that are not marked
+};
+
+template<class T, class C, class LAYOUT>
+const typename ComponentLabeling<T, C, LAYOUT>::Index ComponentLabeling<T, C, LAYOUT>::none;
+
+template<class T, class C, class LAYOUT>
+ComponentLabeling<T, C, LAYOUT>::ComponentLabeling(
+    const ByteLabeledCellgridType& grid,
+    const Order order,
+    const size_t numberOfThreads
+)
+:   grid_(grid),
+    order_(order),
+    numberOfComponents_(0),
+    numberOfCells_(0),
+    sliceBegins_(grid.shape(2) + 1),
+    labels_(),
+    firstCells_(1),
+    peakMemory_(0)
+{
+    assert(order > 0 && order < 4);
+    if(sliceSize() >= none) {
+        throw std::runtime_error("slices are too large to be labeled.");
+    }
+    const SlabPartition slabs(grid.shape(2), numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads);
+
+    // label the slices of every slab, with indices that are unique within
+    // the slab, and unite indices across the slices of the slab
+    std::vector<std::vector<Index> > slabParents(slabs.numberOfSlabs()); // union-find forests of indices
+    std::vector<std::vector<Index> > slabFirstCells(slabs.numberOfSlabs()); // index(cell) of the first cell, by index
+    std::vector<std::vector<Index> > lastSlices(slabs.numberOfSlabs()); // indices of the cells of the last slice
+    std::vector<size_t> slabNumbersOfCells(slabs.numberOfSlabs());
+    parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+        std::vector<Index> cellParents;
+        std::vector<Index> indices;
+        std::vector<Index>& parents = slabParents[j];
+        std::vector<Index>& previousIndices = lastSlices[j];
+        for(Coordinate z = slabs.begin(j); z < slabs.end(j); ++z) {
+            const Index begin = static_cast<Index>(parents.size());
+            sliceBegins_[z] = begin;
+            const Index size = labelSlice(z, begin, cellParents, indices, &slabFirstCells[j]);
+            for(Index k = begin; k < begin + size; ++k) {
+                parents.push_back(k);
+            }
+            if(z != slabs.begin(j)) {
+                uniteSlices(z, previousIndices, indices, parents);
+            }
+            for(size_t k = 0; k < indices.size(); ++k) {
+                slabNumbersOfCells[j] += (indices[k] != none);
+            }
+            previousIndices.swap(indices);
+        }
+    });
+
+    // offset the indices of every slab and concatenate the forests
+    size_t numberOfIndices = 0;
+    for(size_t j = 0; j < slabs.numberOfSlabs(); ++j) {
+        numberOfIndices += slabParents[j].size();
+        peakMemory_ += (slabParents[j].capacity() + slabFirstCells[j].capacity()) * sizeof(Index);
+    }
+    if(numberOfIndices >= none) {
+        throw std::runtime_error("slices have too many connected components.");
+    }
+    peakMemory_ += 2 * numberOfIndices * sizeof(Index);
+    std::vector<Index> parents;
+    std::vector<Index> firstCells;
+    parents.reserve(numberOfIndices);
+    firstCells.reserve(numberOfIndices);
+    for(size_t j = 0; j < slabs.numberOfSlabs(); ++j) {
+        const Index offset = static_cast<Index>(parents.size());
+        for(size_t k = 0; k < slabParents[j].size(); ++k) {
+            parents.push_back(slabParents[j][k] + offset);
+        }
+        firstCells.insert(firstCells.end(), slabFirstCells[j].begin(), slabFirstCells[j].end());
+        std::vector<Index>().swap(slabParents[j]);
+        std::vector<Index>().swap(slabFirstCells[j]);
+        for(size_t z = slabs.begin(j); z < slabs.end(j); ++z) {
+            sliceBegins_[z] += offset;
+        }
+        for(size_t k = 0; k < lastSlices[j].size(); ++k) {
+            if(lastSlices[j][k] != none) {
+                lastSlices[j][k] += offset;
+            }
+        }
+    }
+    sliceBegins_.back() = static_cast<Index>(numberOfIndices);
+
+    // unite indices across slab borders
+    {
+        std::vector<Index> cellParents;
+        std::vector<Index> indices;
+        for(size_t j = 0; j + 1 < slabs.numberOfSlabs(); ++j) {
+            const Coordinate z = static_cast<Coordinate>(slabs.begin(j + 1));
+            labelSlice(z, sliceBegins_[z], cellParents, indices, 0);
+            uniteSlices(z, lastSlices[j], indices, parents);
+            std::vector<Index>().swap(lastSlices[j]);
+        }
+    }
+
+    // label components in the order of their first indices. as the root of
+    // every tree is its smallest index, this is the scan order of the first
+    // cells of components.
+    labels_.resize(numberOfIndices);
+    Coordinate z = 0;
+    for(Index k = 0; k < numberOfIndices; ++k) {
+        while(sliceBegins_[z + 1] <= k) {
+            ++z;
+        }
+        const Index root = find(parents, k);
+        if(root == k) {
+            firstCells_.push_back(cell(z, firstCells[k]));
+            labels_[k] = static_cast<Label>(firstCells_.size() - 1);
+        }
+        else {
+            assert(root < k);
+            labels_[k] = labels_[root];
+        }
+    }
+    numberOfComponents_ = static_cast<Label>(firstCells_.size() - 1);
+    for(size_t j = 0; j < slabNumbersOfCells.size(); ++j) {
+        numberOfCells_ += slabNumbersOfCells[j];
+    }
+}
+
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Order
+ComponentLabeling<T, C, LAYOUT>::order() const
+{
+    return order_;
+}
+
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Label
+ComponentLabeling<T, C, LAYOUT>::numberOfComponents() const
+{
+    return numberOfComponents_;
+}
+
+// returns the number of labeled cells, i.e. of all 3-cells, or of all
+// marked 1- or 2-cells
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::numberOfCells() const
+{
+    return numberOfCells_;
+}
+
+template<class T, class C, class LAYOUT>
+inline const typename ComponentLabeling<T, C, LAYOUT>::CellType&
+ComponentLabeling<T, C, LAYOUT>::firstCell(
+    const Label label
+) const
+{
+    assert(label > 0 && label < firstCells_.size());
+    return firstCells_[label];
+}
+
+// calls functor(cell, label) for all cells of the order in scan order,
+// including cells that are not marked and thus have label 0
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+inline void
+ComponentLabeling<T, C, LAYOUT>::forEachCell(
+    FUNCTOR functor
+) const
+{
+    std::vector<Index> buffer;
+    Slice slice(*this);
+    for(Coordinate z = 0; z < grid_.shape(2); ++z) {
+        slice.assign(z, buffer);
+        slice.forEachCell(functor);
+    }
+}
+
+// returns the number of bytes allocated for the labeling
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::memory() const
+{
+    return sliceBegins_.capacity() * sizeof(Index) + labels_.capacity() * sizeof(Label)
+        + firstCells_.capacity() * sizeof(CellType);
+}
+
+// returns an upper bound on the number of bytes allocated for the forests
+// of indices and the first cells of indices during the construction, not
+// counting memory(), and not counting the per-thread buffers of slices
+// (see sliceMemory)
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::peakMemory() const
+{
+    return peakMemory_;
+}
+
+// returns the number of bytes of one buffer of the size of a slice. the
+// construction allocates three buffers per thread, plus one for every slab.
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::sliceMemory(
+    const Coordinate shape0,
+    const Coordinate shape1,
+    const Order order
+)
+{
+    return (order == 3 ? 1 : 3) * static_cast<size_t>(shape0) * shape1 * sizeof(Index);
+}
+
+// releases the first cells of components, e.g. once they are anchored.
+// the labels of cells remain available by Slice.
+template<class T, class C, class LAYOUT>
+inline void
+ComponentLabeling<T, C, LAYOUT>::clearFirstCells()
+{
+    firstCells_.resize(1);
+    firstCells_.shrink_to_fit();
+}
+
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::sliceSize() const
+{
+    return (order_ == 3 ? 1 : 3) * static_cast<size_t>(grid_.shape(0)) * grid_.shape(1);
+}
+
+// 3-cells are indexed by their voxel in the slice. 1- and 2-cells are
+// indexed by their voxel in the slice and the dimension in which they are
+// even (1-cells) or odd (2-cells)
+template<class T, class C, class LAYOUT>
+inline size_t
+ComponentLabeling<T, C, LAYOUT>::index(
+    const CellType& cell
+) const
+{
+    const size_t voxel = cell[0] / 2 + static_cast<size_t>(grid_.shape(0)) * (cell[1] / 2);
+    if(order_ == 3) {
+        return voxel;
+    }
+    else {
+        const unsigned char odd = (order_ == 2);
+        const size_t d = (cell[0] % 2 == odd) ? 0 : ((cell[1] % 2 == odd) ? 1 : 2);
+        return 3 * voxel + d;
+    }
+}
+
+// inverse of index(cell) for the cells of the slice z
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::CellType
+ComponentLabeling<T, C, LAYOUT>::cell(
+    const Coordinate z,
+    const size_t j
+) const
+{
+    const size_t voxel = order_ == 3 ? j : j / 3;
+    CellType cell;
+    cell[0] = static_cast<Coordinate>(2 * (voxel % grid_.shape(0)));
+    cell[1] = static_cast<Coordinate>(2 * (voxel / grid_.shape(0)));
+    cell[2] = 2 * z;
+    if(order_ != 3) {
+        for(size_t d = 0; d < 3; ++d) {
+            if((d == j % 3) == (order_ == 2)) {
+                ++cell[d];
+            }
+        }
+    }
+    return cell;
+}
+
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Index
+ComponentLabeling<T, C, LAYOUT>::labelSlice(
+    const Coordinate z,
+    const Index begin,
+    std::vector<Index>& cellParents,
+    std::vector<Index>& indices,
+    std::vector<Index>* firstCells
+) const
+{
+    switch(order_) {
+    case 1:
+        return labelSlice<1>(z, begin, cellParents, indices, firstCells);
+    case 2:
+        return labelSlice<2>(z, begin, cellParents, indices, firstCells);
+    default:
+        return labelSlice<3>(z, begin, cellParents, indices, firstCells);
+    }
+}
+
+template<class T, class C, class LAYOUT>
+inline void
+ComponentLabeling<T, C, LAYOUT>::uniteSlices(
+    const Coordinate z,
+    const std::vector<Index>& previousIndices,
+    const std::vector<Index>& indices,
+    std::vector<Index>& parents
+) const
+{
+    switch(order_) {
+    case 1:
+        uniteSlices<1>(z, previousIndices, indices, parents);
+        break;
+    case 2:
+        uniteSlices<2>(z, previousIndices, indices, parents);
+        break;
+    default:
+        uniteSlices<3>(z, previousIndices, indices, parents);
+    }
+}
+
+// indexes the components of the cells of the slice z, with indices from
+// begin on in the scan order of their first cells. the active cells that
+// bound the same unmarked (ORDER-1)-cell are united if both are in the
+// slice. indices[index(cell)] is the index of the component of the cell,
+// or none if the cell is not marked. if firstCells is not 0, index(cell) of
+// the first cell of every component is appended to it.
+// returns the number of components.
+template<class T, class C, class LAYOUT>
+template<typename ComponentLabeling<T, C, LAYOUT>::Order ORDER>
+typename ComponentLabeling<T, C, LAYOUT>::Index
+ComponentLabeling<T, C, LAYOUT>::labelSlice(
+    const Coordinate z,
+    const Index begin,
+    std::vector<Index>& cellParents,
+    std::vector<Index>& indices,
+    std::vector<Index>* firstCells
+) const
+{
+    const size_t n = sliceSize();
+    cellParents.resize(n);
+    for(size_t j = 0; j < n; ++j) {
+        cellParents[j] = static_cast<Index>(j);
+    }
+    const Coordinate end2 = std::min<Coordinate>(2 * z + 2, 2 * grid_.shape(2) - 1);
+    grid_.forEachCellInSlab(ORDER - 1, 2 * z, end2, [&](const CellType& cell) {
+        if(!grid_.isMarked(cell)) { // if not a boundary
+            Index first = none;
+            grid_.template forEachAbove<ORDER - 1>(cell, [&](const CellType& c) {
+                if(c[2] < 2 * z + 2 && (ORDER == 3 || grid_.isMarked(c))) {
+                    const Index j = static_cast<Index>(index(c));
+                    if(first == none) {
+                        first = j;
+                    }
+                    else {
+                        merge(cellParents, first, j);
+                    }
+                }
+            });
+        }
+        return true;
+    });
+
+    indices.assign(n, none);
+    Index next = begin;
+    grid_.forEachCellInSlab(ORDER, 2 * z, end2, [&](const CellType& cell) {
+        if(ORDER == 3 || grid_.isMarked(cell)) {
+            const Index j = static_cast<Index>(index(cell));
+            const Index root = find(cellParents, j);
+            if(indices[root] == none) {
+                if(next == none) {
+                    throw std::runtime_error("slices have too many connected components.");
+                }
+                indices[root] = next++;
+                if(firstCells != 0) {
+                    firstCells->push_back(j);
+                }
+            }
+            indices[j] = indices[root];
+        }
+        return true;
+    });
+    return next - begin;
+}
+
+// unites the indices of the active cells of the slices z-1 and z that bound
+// the same unmarked (ORDER-1)-cell
+template<class T, class C, class LAYOUT>
+template<typename ComponentLabeling<T, C, LAYOUT>::Order ORDER>
+void
+ComponentLabeling<T, C, LAYOUT>::uniteSlices(
+    const Coordinate z,
+    const std::vector<Index>& previousIndices,
+    const std::vector<Index>& indices,
+    std::vector<Index>& parents
+) const
+{
+    assert(z > 0);
+    grid_.forEachCellInSlab(ORDER - 1, 2 * z - 1, 2 * z, [&](const CellType& cell) {
+        if(!grid_.isMarked(cell)) { // if not a boundary
+            Index first = none;
+            grid_.template forEachAbove<ORDER - 1>(cell, [&](const CellType& c) {
+                if(ORDER == 3 || grid_.isMarked(c)) {
+                    const size_t j = index(c);
+                    const Index k = c[2] == 2 * z ? indices[j] : previousIndices[j];
+                    if(first == none) {
+                        first = k;
+                    }
+                    else {
+                        merge(parents, first, k);
+                    }
+                }
+            });
+        }
+        return true;
+    });
+}
+
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Index
+ComponentLabeling<T, C, LAYOUT>::find(
+    std::vector<Index>& parents,
+    Index j
+)
+{
+    while(parents[j] != j) {
+        parents[j] = parents[parents[j]]; // path halving
+        j = parents[j];
+    }
+    return j;
+}
+
+// the root with the larger index is attached to the root with the smaller
+// index such that the result does not depend on the order of unions
+template<class T, class C, class LAYOUT>
+inline void
+ComponentLabeling<T, C, LAYOUT>::merge(
+    std::vector<Index>& parents,
+    const Index j,
+    const Index k
+)
+{
+    const Index rj = find(parents, j);
+    const Index rk = find(parents, k);
+    if(rj < rk) {
+        parents[rk] = rj;
+    }
+    else if(rk < rj) {
+        parents[rj] = rk;
+    }
+}
+
+template<class T, class C, class LAYOUT>
+inline
+ComponentLabeling<T, C, LAYOUT>::Slice::Slice(
+    const ComponentLabeling<T, C, LAYOUT>& labeling
+)
+:   labeling_(&labeling),
+    z_(0),
+    indices_()
+{}
+
+template<class T, class C, class LAYOUT>
+inline void
+ComponentLabeling<T, C, LAYOUT>::Slice::assign(
+    const Coordinate z,
+    std::vector<Index>& buffer
+)
+{
+    assert(z < labeling_->grid_.shape(2));
+    z_ = z;
+    labeling_->labelSlice(z, labeling_->sliceBegins_[z], buffer, indices_, 0);
+}
+
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Coordinate
+ComponentLabeling<T, C, LAYOUT>::Slice::z() const
+{
+    return z_;
+}
+
+// returns 0 for 1- and 2-cells that are not marked.
+// precondition: the cell is in the slice.
+template<class T, class C, class LAYOUT>
+inline typename ComponentLabeling<T, C, LAYOUT>::Label
+ComponentLabeling<T, C, LAYOUT>::Slice::label(
+    const CellType& cell
+) const
+{
+    assert(cell.order() == labeling_->order_ && cell[2] / 2 == z_);
+    const Index k = indices_[labeling_->index(cell)];
+    return k == none ? 0 : labeling_->labels_[k];
+}
+
+// calls functor(cell, label) for all cells of the order in the slice in
+// scan order, including cells that are not marked and thus have label 0
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+inline void
+ComponentLabeling<T, C, LAYOUT>::Slice::forEachCell(
+    FUNCTOR functor
+) const
+{
+    const ByteLabeledCellgridType& grid = labeling_->grid_;
+    const Coordinate end2 = std::min<Coordinate>(2 * z_ + 2, 2 * grid.shape(2) - 1);
+    grid.forEachCellInSlab(labeling_->order_, 2 * z_, end2, [&](const CellType& cell) {
+        functor(cell, label(cell));
+        return true;
+    });
+}
+
+template<class T, class C, class LAYOUT>
+inline void
+ComponentLabeling<T, C, LAYOUT>::Slice::swap(
+    Slice& other
+)
+{
+    std::swap(labeling_, other.labeling_);
+    std::swap(z_, other.z_);
+    indices_.swap(other.indices_);
+}
+
+} // namespace detail
+} // namespace cwx
+
+#endif // #ifndef CWX_COMPONENT_LABELING_HXX
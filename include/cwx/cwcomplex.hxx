@@ -30,14 +30,25 @@ public:
     size_t sizeBelow(const Order, const Label) const;
     Label above(const Order, const Label, const size_t) const;
     Label below(const Order, const Label, const size_t) const;
+    size_t memory() const;
 
     // manipulation
     Label push_back(const Order);
     void connect(const Order, const Label, const Label);    
+    template<class ITERATOR> void connectPairs(const Order, ITERATOR, ITERATOR);
+    void disconnect(const Order, const Label, const Label);
+    void isolate(const Order, const Label);
+    void merge(const Order, const Label, const Label);
+    void erase(const Order, const Label);
 
 private:
+    void insertPair(const Order, const Label, const Label);
+    void removePair(const Order, const Label, const Label);
+    void neighbors(const Order, const Label, std::vector<Label>&, std::vector<Label>&) const;
     template<class CONTAINER> void insertHelper(CONTAINER&, const Label) const;
     template<class CONTAINER> void insertHelper2(CONTAINER&, const Label) const;
+    template<class CONTAINER> void removeHelper(CONTAINER&, const Label) const;
+    template<class CONTAINER> void removeHelper2(CONTAINER&, const Label) const;
     template<class CONTAINER> void testHelper(const CONTAINER&) const;
     template<class CONTAINER1, class CONTAINER2>
         void testHelper2(const CONTAINER1&, const CONTAINER2&) const;
@@ -141,6 +152,26 @@ CWComplex<T>::numberOfCells(
     }
 }
 
+// bytes allocated for the adjacency lists
+template<class T>
+inline size_t
+CWComplex<T>::memory() const
+{
+    size_t bytes = above0_.capacity() * sizeof(std::array<Label, 6>)
+        + above1_.capacity() * sizeof(std::array<Label, 4>)
+        + above2_.capacity() * sizeof(std::array<Label, 2>)
+        + below1_.capacity() * sizeof(std::array<Label, 2>)
+        + below2_.capacity() * sizeof(std::vector<Label>)
+        + below3_.capacity() * sizeof(std::vector<Label>);
+    for(size_t j = 0; j < below2_.size(); ++j) {
+        bytes += below2_[j].capacity() * sizeof(Label);
+    }
+    for(size_t j = 0; j < below3_.size(); ++j) {
+        bytes += below3_[j].capacity() * sizeof(Label);
+    }
+    return bytes;
+}
+
 template<class T>
 inline size_t
 CWComplex<T>::sizeAbove(
@@ -341,6 +372,231 @@ CWComplex<T>::connect(
     testInvariant();
 }
 
+// connects cells of the given order to cells of the next higher order
+// - the iterators refer to pairs (label, labelAbove)
+// - pairs sorted in ascending order are inserted in constant time each
+// - the invariant is tested only once, after all insertions
+template<class T>
+template<class ITERATOR>
+void
+CWComplex<T>::connectPairs(
+    const typename CWComplex<T>::Order order,
+    ITERATOR it,
+    ITERATOR end
+)
+{
+    assert(order < 3);
+    for(; it != end; ++it) {
+        const Label label = it->first;
+        const Label labelAbove = it->second;
+        assert(label > 0 && label <= numberOfCells(order));
+        assert(labelAbove > 0 && labelAbove <= numberOfCells(order + 1));
+        switch(order) {
+        case 0:
+            insertHelper(above0_[label], labelAbove);
+            insertHelper(below1_[labelAbove], label);
+            break;
+        case 1:
+            insertHelper(above1_[label], labelAbove);
+            insertHelper2(below2_[labelAbove], label);
+            break;
+        case 2:
+            insertHelper(above2_[label], labelAbove);
+            insertHelper2(below3_[labelAbove], label);
+            break;
+        default:
+            throw std::runtime_error("invalid order");
+        }
+    }
+    testInvariant();
+}
+
+// disconnects a cell from a cell of the next higher order
+template<class T>
+void
+CWComplex<T>::disconnect(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label,
+    const typename CWComplex<T>::Label labelAbove
+)
+{
+    assert(order < 3);
+    assert(label > 0 && label <= numberOfCells(order));
+    assert(labelAbove > 0 && labelAbove <= numberOfCells(order + 1));
+    removePair(order, label, labelAbove);
+    testInvariant();
+}
+
+// removes all connections of a cell
+template<class T>
+void
+CWComplex<T>::isolate(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label
+)
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    std::vector<Label> labelsBelow;
+    std::vector<Label> labelsAbove;
+    neighbors(order, label, labelsBelow, labelsAbove);
+    for(size_t j=0; j<labelsBelow.size(); ++j) {
+        removePair(order - 1, labelsBelow[j], label);
+    }
+    for(size_t j=0; j<labelsAbove.size(); ++j) {
+        removePair(order, label, labelsAbove[j]);
+    }
+    testInvariant();
+}
+
+// connects the cell into with all cells connected to the cell label and
+// isolates the cell label. the cell label is expected to be erased.
+template<class T>
+void
+CWComplex<T>::merge(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label,
+    const typename CWComplex<T>::Label into
+)
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    assert(into > 0 && into <= numberOfCells(order));
+    assert(label != into);
+    std::vector<Label> labelsBelow;
+    std::vector<Label> labelsAbove;
+    neighbors(order, label, labelsBelow, labelsAbove);
+    isolate(order, label);
+    for(size_t j=0; j<labelsBelow.size(); ++j) {
+        insertPair(order - 1, labelsBelow[j], into);
+    }
+    for(size_t j=0; j<labelsAbove.size(); ++j) {
+        insertPair(order, into, labelsAbove[j]);
+    }
+    testInvariant();
+}
+
+// removes a cell and its connections. the last cell of the same order takes
+// its label, such that labels remain contiguous.
+template<class T>
+void
+CWComplex<T>::erase(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label
+)
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    isolate(order, label);
+    const Label last = numberOfCells(order);
+    if(label != last) {
+        std::vector<Label> labelsBelow;
+        std::vector<Label> labelsAbove;
+        neighbors(order, last, labelsBelow, labelsAbove);
+        isolate(order, last);
+        for(size_t j=0; j<labelsBelow.size(); ++j) {
+            insertPair(order - 1, labelsBelow[j], label);
+        }
+        for(size_t j=0; j<labelsAbove.size(); ++j) {
+            insertPair(order, label, labelsAbove[j]);
+        }
+    }
+    switch(order) {
+    case 0:
+        above0_.pop_back();
+        break;
+    case 1:
+        above1_.pop_back();
+        below1_.pop_back();
+        break;
+    case 2:
+        above2_.pop_back();
+        below2_.pop_back();
+        break;
+    case 3:
+        below3_.pop_back();
+        break;
+    default:
+        throw std::runtime_error("invalid order");
+    }
+    testInvariant();
+}
+
+// connects a cell to a cell of the next higher order, without testing the
+// invariant
+template<class T>
+inline void
+CWComplex<T>::insertPair(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label,
+    const typename CWComplex<T>::Label labelAbove
+)
+{
+    switch(order) {
+    case 0:
+        insertHelper(above0_[label], labelAbove);
+        insertHelper(below1_[labelAbove], label);
+        break;
+    case 1:
+        insertHelper(above1_[label], labelAbove);
+        insertHelper2(below2_[labelAbove], label);
+        break;
+    case 2:
+        insertHelper(above2_[label], labelAbove);
+        insertHelper2(below3_[labelAbove], label);
+        break;
+    default:
+        throw std::runtime_error("invalid order");
+    }
+}
+
+// disconnects a cell from a cell of the next higher order, without testing
+// the invariant
+template<class T>
+inline void
+CWComplex<T>::removePair(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label,
+    const typename CWComplex<T>::Label labelAbove
+)
+{
+    switch(order) {
+    case 0:
+        removeHelper(above0_[label], labelAbove);
+        removeHelper(below1_[labelAbove], label);
+        break;
+    case 1:
+        removeHelper(above1_[label], labelAbove);
+        removeHelper2(below2_[labelAbove], label);
+        break;
+    case 2:
+        removeHelper(above2_[label], labelAbove);
+        removeHelper2(below3_[labelAbove], label);
+        break;
+    default:
+        throw std::runtime_error("invalid order");
+    }
+}
+
+// labels of the cells below and above a cell
+template<class T>
+void
+CWComplex<T>::neighbors(
+    const typename CWComplex<T>::Order order,
+    const typename CWComplex<T>::Label label,
+    std::vector<Label>& labelsBelow,
+    std::vector<Label>& labelsAbove
+) const
+{
+    labelsBelow.resize(sizeBelow(order, label));
+    for(size_t j=0; j<labelsBelow.size(); ++j) {
+        labelsBelow[j] = below(order, label, j);
+    }
+    labelsAbove.clear();
+    for(size_t j=0; j<sizeAbove(order, label); ++j) {
+        if(above(order, label, j) != 0) { // 2-cells have free spots, too
+            labelsAbove.push_back(above(order, label, j));
+        }
+    }
+}
+
 // insert into fixed-size container whose entries are and are supposed to remain
 // unique and in ascending order, except for, possibly, a terminal sequence of
 // zeros indicating free spots
@@ -384,6 +640,10 @@ CWComplex<T>::insertHelper2(
     const typename CWComplex<T>::Label label
 ) const
 {
+    if(container.empty() || container.back() < label) { // append, e.g. for sorted insertion
+        container.insert(container.end(), label);
+        return;
+    }
     typename CONTAINER::iterator it = container.begin();
     while(it != container.end() && *it != 0 && *it < label) {
         ++it;
@@ -393,6 +653,46 @@ CWComplex<T>::insertHelper2(
     }
 }
 
+// remove from fixed-size container whose entries are unique and in ascending
+// order, except for, possibly, a terminal sequence of zeros indicating free
+// spots. the entries beyond the removed one are shifted to the left.
+template<class T>
+template<class CONTAINER>
+inline void
+CWComplex<T>::removeHelper(
+    CONTAINER& container,
+    const typename CWComplex<T>::Label label
+) const
+{
+    for(size_t j=0; j<container.size(); ++j) {
+        if(container[j] == label) {
+            for(size_t k=j; k+1<container.size(); ++k) {
+                container[k] = container[k+1];
+            }
+            container[container.size()-1] = 0;
+            return;
+        }
+    }
+    throw std::runtime_error("remove failed. label is not in container.");
+}
+
+// remove from container with member functions begin, end and erase whose
+// entries are unique and in ascending order
+template<class T>
+template<class CONTAINER>
+inline void
+CWComplex<T>::removeHelper2(
+    CONTAINER& container,
+    const typename CWComplex<T>::Label label
+) const
+{
+    typename CONTAINER::iterator it = std::lower_bound(container.begin(), container.end(), label);
+    if(it == container.end() || *it != label) {
+        throw std::runtime_error("remove failed. label is not in container.");
+    }
+    container.erase(it);
+}
+
 // tests for a container with member functions size and operator[] if the
 // entries are in ascending order, except for, possibly, a terminal sequence of
 // zeros
@@ -3,49 +3,76 @@
 #define CWX_HXX
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <utility>
 #include <queue>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
+#include "cwx/build-stats.hxx"
 #include "cwx/byte-labeled-cellgrid.hxx"
 #include "cwx/cwcomplex.hxx"
 #include "cwx/anchorage.hxx"
+#include "cwx/component-labeling.hxx"
+#include "cwx/label-cache.hxx"
+#include "cwx/traversal-workspace.hxx"
+#include "cwx/marker.hxx"
+#include "cwx/parallel.hxx"
 
 namespace cwx {
 
 // forward declarations
 template<class T> class CWComplexLatex;
 namespace detail {
-    template<class T, class C> class Labeler; // functor for INTERNAL use with CWX<T, C>::process(const Order, FUNCTOR&)
-    template<class T, class C> class Anchorer; // functor for INTERNAL use with CWX<T, C>::process(const Order, const Order, const Coordinate, FUNCTOR&)
-    template<class T, class C> class AnchorTester; // functor for INTERNAL use with CWX<T, C>::process(const Order, const Order, const Coordinate, FUNCTOR&)
+    template<class T, class C, class LAYOUT> class Anchorer; // functor for INTERNAL use with CWX<T, C>::process(const Order, const Order, const Coordinate, FUNCTOR&)
+    template<class T, class C, class LAYOUT> class AnchorTester; // functor for INTERNAL use with CWX<T, C>::process(const Order, const Order, const Coordinate, FUNCTOR&)
+    template<class T, class C, class LAYOUT> class HDF5Serializer; // for INTERNAL use with save and load in cwx/hdf5.hxx
+    template<class T, class C, class LAYOUT, class U> class ExportSliceLabeler; // functor for INTERNAL use with CWX<T, C>::labeledCellSlice and CWX<T, C>::labeledVoxelSlice
+    template<class T, class C, class LAYOUT> class GridExporter; // engine for INTERNAL use with CWX<T, C>::labeledCellGrid, CWX<T, C>::labeledVoxelGrid and CWX<T, C>::accumulate
+    template<class T, class C, class LAYOUT> class MappedWriter; // for INTERNAL use with saveMapped in cwx/mapped-cwx.hxx
+    template<class T, class C, class LAYOUT> class Updater; // engine for INTERNAL use with CWX<T, C>::update
 }
 
-template<class T, class C>
+/// LAYOUT arranges the bytes of the grid of cells in memory, cf.
+/// grid-layout.hxx. with SparseLayout, only bricks of voxels with marked or
+/// anchored cells are stored, and cells are marked by one thread.
+template<class T, class C, class LAYOUT = LinearLayout>
 class CWX {
 public:
     typedef T Label;
     typedef C Coordinate;
 
 private:
-    typedef ByteLabeledCellgrid<Label, Coordinate> ByteLabeledCellgridType;
+    typedef ByteLabeledCellgrid<Label, Coordinate, LAYOUT> ByteLabeledCellgridType;
     typedef CWComplex<Label> CWComplexType;
     typedef Anchorage<Label, Coordinate> AnchorageType;
-    typedef detail::Labeler<T, C> Labeler;
-    typedef detail::Anchorer<T, C> Anchorer;
-    typedef detail::AnchorTester<T, C> AnchorTester;
+    typedef detail::Anchorer<T, C, LAYOUT> Anchorer;
+    typedef detail::AnchorTester<T, C, LAYOUT> AnchorTester;
 
 public:
     typedef typename ByteLabeledCellgridType::Order Order;
     typedef typename ByteLabeledCellgridType::CellType CellType;
     typedef typename ByteLabeledCellgridType::CellVector CellVector;
+    typedef TraversalWorkspace<Coordinate> TraversalWorkspaceType;
+    enum LabelCacheMode {NoLabelCache, VoxelLabelCache, CellLabelCache};
 
     // manipulation
-    CWX(const bool = true);
-    template<class U, bool B> void build(const andres::View<U, B>&, bool verbose=false);
+    CWX(const bool = true, const LabelCacheMode = NoLabelCache);
+    template<class U, bool B> void build(const andres::View<U, B>&, bool verbose=false, const size_t numberOfThreads=1);
+    template<class LOADER> void buildFromSlabs(LOADER&, const size_t, bool verbose=false, const size_t numberOfThreads=1);
+    Label merge(const Label, const Label);
+    template<class U, bool B> void update(const std::array<Coordinate, 3>&, const andres::View<U, B>&);
 
     // query
+    // the const member functions only read the object, except for workspaces
+    // and buffers of the calling thread. thus, they can be called
+    // concurrently from any number of threads, as long as no thread calls a
+    // non-const member function at the same time.
     Coordinate shape(const Order) const;
     Label numberOfCells(const Order) const;
     size_t sizeAbove(const Order, const Label) const;
@@ -56,32 +83,56 @@ public:
     void below(const CellType&, CellVector&) const;
     Label atVoxel(const Coordinate, const Coordinate, const Coordinate) const;
     Label atCell(const CellType&) const;
+    Label atCell(const CellType&, TraversalWorkspaceType&) const;
     bool isMarked(const CellType&) const;
+    size_t labelCacheMemory() const;
+    size_t buildMemory() const;
+    const BuildStats& buildStats() const;
+    void testInvariant() const;
 
     template<class FUNCTOR> void process(const Order, const Label, FUNCTOR&) const;
+    template<class FUNCTOR> void process(const Order, const Label, FUNCTOR&, TraversalWorkspaceType&) const;
     template<class FUNCTOR> void process(const Order, FUNCTOR&) const;
     template<class FUNCTOR> void process(const Order, const Order, const Coordinate, FUNCTOR&) const;
-
-    template<class U> void labeledCellGrid(andres::Marray<U>&) const; 
-    template<class U> void labeledCellGrid(andres::View<U>&) const; 
-    template<class U> void labeledCellSlice(const Order, const Coordinate, andres::Marray<U>&) const; // TODO: implement
-    template<class U> void labeledCellSlice(const Order, const Coordinate, andres::View<U>&) const; // TODO: implement
-
-    template<class U> void labeledVoxelGrid(andres::Marray<U>&) const; 
-    template<class U> void labeledVoxelGrid(andres::View<U>&) const; 
-    template<class U> void labeledVoxelSlice(const Order, const Coordinate, andres::Marray<U>&) const; // TODO: implement
-    template<class U> void labeledVoxelSlice(const Order, const Coordinate, andres::View<U>&) const; // TODO: implement
+    template<class FUNCTOR> void process(const Order, const Order, const Coordinate, FUNCTOR&, TraversalWorkspaceType&) const;
+    template<Order ORDER, class FUNCTOR> void process(const Label, FUNCTOR&) const;
+    template<Order ORDER, class FUNCTOR> void process(const Label, FUNCTOR&, TraversalWorkspaceType&) const;
+    template<Order ORDER, class FUNCTOR> void process(FUNCTOR&) const;
+    template<class FACTORY, class FUNCTOR> void parallelProcess(const Order, const Label, const Label, FACTORY, std::vector<FUNCTOR>&, const size_t numberOfThreads = 1) const;
+
+    template<class U> void labeledCellGrid(andres::Marray<U>&, const size_t numberOfThreads = 1) const;
+    template<class U> void labeledCellGrid(andres::View<U>&, const size_t numberOfThreads = 1) const;
+    template<class U> void labeledCellSlice(const Order, const Coordinate, andres::Marray<U>&) const;
+    template<class U> void labeledCellSlice(const Order, const Coordinate, andres::View<U>&) const;
+
+    template<class U> void labeledVoxelGrid(andres::Marray<U>&, const size_t numberOfThreads = 1) const;
+    template<class U> void labeledVoxelGrid(andres::View<U>&, const size_t numberOfThreads = 1) const;
+    template<class U> void labeledVoxelSlice(const Order, const Coordinate, andres::Marray<U>&) const;
+    template<class U> void labeledVoxelSlice(const Order, const Coordinate, andres::View<U>&) const;
+
+    template<class ACCUMULATOR> void accumulate(std::array<std::vector<ACCUMULATOR>, 4>&, const size_t numberOfThreads = 1) const;
     
     const typename ByteLabeledCellgridType::GridViewType grid() const { return byteLabeledCellgrid_.grid(); }
 
 private:
-    void connect(const CellType&, const Label&);
-    void testInvariant() const;
+    template<class U, bool B>
+        void markCells(const andres::View<U, B>&, const Coordinate, const Order, const Coordinate, const Coordinate, const size_t, std::vector<CellType>&);
+    template<class U, bool B>
+        void markSlices(const andres::View<U, B>&, const Coordinate, const Order, const Coordinate, const Coordinate, std::vector<CellType>&);
+    void buildComplex(const std::vector<CellType>&, bool, const size_t);
+    size_t labelingMemory(const Coordinate, const Coordinate, const Coordinate, const size_t) const;
+    void connect(const detail::ComponentLabeling<T, C, LAYOUT>&, const detail::ComponentLabeling<T, C, LAYOUT>&, const size_t);
+    void connectZeroCells(const detail::ComponentLabeling<T, C, LAYOUT>&);
+    void cacheLabels(const Order, const Label, TraversalWorkspaceType&);
 
     ByteLabeledCellgridType byteLabeledCellgrid_;
     CWComplexType cwcomplex_;
     AnchorageType anchorage_;
+    LabelCache<Label, Coordinate> labelCache_;
     bool redundantAnchors_;
+    LabelCacheMode labelCacheMode_;
+    size_t buildMemory_;
+    BuildStats buildStats_;
     // anchorage_  is a data structure for labeling a subset of cells which are
     //             called anchors
     // byteLabeledCellgrid_   also has a concept called anchors which is different. an
@@ -95,10 +146,25 @@ private:
     // connect component of cells is created but so many such that each
     // connected component in each slice of the volume contains at least one
     // anchor
-
-friend class detail::Labeler<T, C>;
-friend class detail::Anchorer<T, C>;
-friend class detail::AnchorTester<T, C>;
+    //
+    // labelCacheMode_: if not NoLabelCache, build stores the label of every
+    // 3-cell in labelCache_ and, for CellLabelCache, also the label of
+    // every marked 1- and 2-cell. atCell and atVoxel then look labels up
+    // instead of searching for an anchor.
+    //
+    // buildMemory_: estimate of the peak number of bytes allocated by the
+    // last build, see buildMemory()
+    //
+    // buildStats_: times, counts and memory of the last build, see
+    // buildStats()
+
+friend class detail::Anchorer<T, C, LAYOUT>;
+friend class detail::AnchorTester<T, C, LAYOUT>;
+friend class detail::HDF5Serializer<T, C, LAYOUT>;
+friend class detail::MappedWriter<T, C, LAYOUT>;
+friend class detail::GridExporter<T, C, LAYOUT>;
+friend class detail::Updater<T, C, LAYOUT>;
+template<class, class, class, class> friend class detail::ExportSliceLabeler;
 friend class CWComplexLatex<Label>;
 };
 
@@ -125,33 +191,12 @@ private:
 namespace detail {
 
 // functor for INTERNAL use with CWX::process
-template<class T, class C>
-class Labeler {
-public:
-    typedef T Label;
-    typedef C Coordinate;
-    typedef CWX<T, C> CWXType;
-    typedef typename CWXType::Order Order;
-    typedef typename CWXType::CellType CellType;
-
-    Labeler(CWXType&, const Order);
-    bool preprocess(const CellType&);
-    bool operator()(const CellType&);
-    bool postprocess();
-
-private:
-    CWXType& cwx_;
-    Label label_;
-    const Order order_;
-};
-
-// functor for INTERNAL use with CWX::process
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 class Anchorer {
 public:
     typedef T Label;
     typedef C Coordinate;
-    typedef CWX<T, C> CWXType;
+    typedef CWX<T, C, LAYOUT> CWXType;
     typedef typename CWXType::Order Order;
     typedef typename CWXType::CellType CellType;
 
@@ -168,12 +213,12 @@ private:
 };
 
 // functor for INTERNAL use with CWX::process
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 class AnchorTester {
 public:
     typedef T Label;
     typedef C Coordinate;
-    typedef CWX<T, C> CWXType;
+    typedef CWX<T, C, LAYOUT> CWXType;
     typedef typename CWXType::Order Order;
     typedef typename CWXType::CellType CellType;
 
@@ -187,84 +232,228 @@ private:
     bool labeledAnchorFound_;
 };
 
-// functor for INTERNAL use with CWX::process
-template<class T, class C, class U>
-class ExportLabeler {
+// engine for INTERNAL use with CWX::labeledCellGrid, CWX::labeledVoxelGrid
+// and CWX::accumulate
+//
+// the connected components of the cells of one order are labeled slice by
+// slice by a ComponentLabeling, and the label of every component in the
+// CWX is looked up once, at its first cell. the volume is then partitioned
+// into slabs of voxel slices orthogonal to dimension 2 that are processed
+// in parallel. within a slab, the labels of the cells of every slice are
+// recomputed and written in scan order. thus, every cell is visited a
+// constant number of times, independent of the number of labels, and the
+// memory is proportional to the size of a slice and to the number of
+// components of slices, not to the size of the volume.
+template<class T, class C, class LAYOUT>
+class GridExporter {
 public:
-    typedef T Label;
-    typedef C Coordinate;
-    typedef U ExportLabel;
-    typedef CWX<T, C> CWXType;
+    typedef CWX<T, C, LAYOUT> CWXType;
+    typedef typename CWXType::Label Label;
+    typedef typename CWXType::Coordinate Coordinate;
     typedef typename CWXType::Order Order;
     typedef typename CWXType::CellType CellType;
-    typedef andres::View<U> ViewType;
+    typedef typename CWXType::CellVector CellVector;
+    typedef typename CWXType::TraversalWorkspaceType TraversalWorkspaceType;
+    typedef ByteLabeledCellgrid<Label, Coordinate, LAYOUT> ByteLabeledCellgridType;
 
-    ExportLabeler(const CWXType&, ViewType&);
-    void setLabel(const ExportLabel);
-    bool operator()(const CellType&);
+    GridExporter(const CWXType&, const size_t = 1);
+    template<class U> void labeledCellGrid(andres::View<U>&) const;
+    template<class U> void labeledVoxelGrid(andres::View<U>&) const;
+    template<class ACCUMULATOR> void accumulate(std::array<std::vector<ACCUMULATOR>, 4>&) const;
 
 private:
+    template<class WRITER> void sweep(const Order, WRITER) const;
+    Coordinate begin2(const size_t) const;
+    Coordinate end2(const size_t) const;
+
     const CWXType& cwx_;
-    ViewType& view_;
-    ExportLabel label_;
+    SlabPartition slabs_;
 };
 
-// functor for INTERNAL use with CWX::process
-template<class T, class C, class U>
-class ExportVoxelLabeler {
+// functor for INTERNAL use with CWX::process(const Order, const Order, const Coordinate, FUNCTOR&, TraversalWorkspaceType&)
+// writes the labels of the cells in a slice x_d = v into a 2-dimensional
+// view whose dimensions are the remaining dimensions in ascending order.
+// if voxels is true, the view is indexed by voxel coordinates.
+// the label of a component is taken from an anchor among its cells in the
+// slice. with redundant anchors, every component of a slice contains one.
+// only components without an anchor in the slice are labeled by CWX::atCell.
+template<class T, class C, class LAYOUT, class U>
+class ExportSliceLabeler {
 public:
     typedef T Label;
     typedef C Coordinate;
     typedef U ExportLabel;
-    typedef CWX<T, C> CWXType;
+    typedef CWX<T, C, LAYOUT> CWXType;
     typedef typename CWXType::Order Order;
     typedef typename CWXType::CellType CellType;
+    typedef typename CWXType::TraversalWorkspaceType TraversalWorkspaceType;
     typedef andres::View<U> ViewType;
 
-    ExportVoxelLabeler(const CWXType&, ViewType&);
-    void setLabel(const ExportLabel);
+    ExportSliceLabeler(const CWXType&, ViewType&, const Order, const bool, TraversalWorkspaceType&);
+    bool preprocess(const CellType&);
     bool operator()(const CellType&);
+    bool postprocess();
 
 private:
     const CWXType& cwx_;
     ViewType& view_;
-    ExportLabel label_;
+    Order d0_;
+    Order d1_;
+    Coordinate divisor_;
+    TraversalWorkspaceType& workspace_; // for atCell, distinct from the workspace of the slice traversal
+    std::vector<CellType> cells_; // cells of the current component in the slice
+    Label label_;
+};
+
+// engine for INTERNAL use with CWX::update
+//
+// marks of cells can change only in the box of cells around the edited
+// voxels. a component can change only if it contains a cell of the window
+// that extends this box by one cell in every direction. such components are
+// called affected. outside of the window, cells and their connections are
+// unchanged.
+// - affected components of 1- and 2-cells are traced completely, before and
+//   after the box is marked anew.
+// - the part of an affected 3-cell outside of the window can fall apart into
+//   pieces that are connected only through the window. these are found by
+//   breadth-first searches from the 3-cells at the border of the window.
+//   searches that meet are united, and searches take turns until all but one
+//   have terminated. the piece of the remaining search is not traced
+//   completely. it keeps its label and its anchors. thus, the cost for a
+//   3-cell is proportional to the size of its smaller pieces.
+// components that are not affected keep their labels, except for the last
+// labels of an order whose number of cells decreases. affected components
+// take the old label of which they contain most cells, if possible.
+template<class T, class C, class LAYOUT>
+class Updater {
+public:
+    typedef CWX<T, C, LAYOUT> CWXType;
+    typedef typename CWXType::Label Label;
+    typedef typename CWXType::Coordinate Coordinate;
+    typedef typename CWXType::Order Order;
+    typedef typename CWXType::CellType CellType;
+    typedef typename CWXType::CellVector CellVector;
+    typedef typename CWXType::TraversalWorkspaceType TraversalWorkspaceType;
+    typedef ByteLabeledCellgrid<Label, Coordinate, LAYOUT> ByteLabeledCellgridType;
+
+    Updater(CWXType&, const std::array<Coordinate, 3>&, const std::array<Coordinate, 3>&);
+    template<class U, bool B> void operator()(const std::array<Coordinate, 3>&, const andres::View<U, B>&);
+
+private:
+    typedef uint64_t Key;
+    typedef std::unordered_map<Key, size_t> IndexMap;
+
+    // affected component after the update
+    struct Component {
+        Component();
+
+        CellType first; // a cell in the window
+        std::vector<CellType> cells; // for 3-cells, only those outside of the window in pieces that are traced completely
+        std::map<Label, size_t> oldLabels; // number of cells per old label
+        std::vector<Label> keptLabels; // old labels of 3-cells with a piece that is not traced completely
+        Label label; // 0 until assigned
+    };
+
+    // search for a piece of a 3-cell outside of the window
+    struct Search {
+        Label label; // old label of the 3-cell
+        std::vector<CellType> cells; // visited 3-cells
+        std::vector<CellType> queue;
+        size_t next; // index of the next 3-cell in queue
+    };
+
+    bool inWindow(const CellType&) const;
+    template<class FUNCTOR> void forEachCell(const Order, const Coordinate*, const Coordinate*, FUNCTOR) const;
+    template<class FUNCTOR> void trace(const CellType&, const size_t, const Coordinate, FUNCTOR, TraversalWorkspaceType&) const;
+    void traceOld(const Order);
+    void labelOldVoxels();
+    template<class U, bool B> void mark(const std::array<Coordinate, 3>&, const andres::View<U, B>&);
+    void traceNew(const Order);
+    void searchVoxels();
+    void search(const std::vector<std::pair<CellType, CellType> >&, const Label);
+    size_t unite(const size_t, const size_t);
+    void chooseLabels(const Order);
+    void relabel(const std::vector<std::pair<CellType, Label> >&);
+    void anchorSlices(const Order);
+    void cacheLabels();
+    void connect();
+    Label labelOf(const CellType&, TraversalWorkspaceType&) const;
+    static size_t find(std::vector<size_t>&, size_t);
+
+    CWXType& cwx_;
+    ByteLabeledCellgridType& grid_;
+    Coordinate boxBegin_[3];
+    Coordinate boxEnd_[3];
+    Coordinate windowBegin_[3];
+    Coordinate windowEnd_[3];
+    std::unordered_map<Key, Label> oldLabels_[4];
+    std::vector<Label> touchedLabels_[4];
+    std::vector<Label> movedLabels_[4];
+    std::vector<Component> components_[4];
+    IndexMap componentOf_[4];
+    std::vector<Search> searches_;
+    std::vector<size_t> searchParents_;
+    IndexMap searchOf_;
+    // boxBegin_, boxEnd_: first and last coordinates of the cells that are
+    // marked anew, windowBegin_, windowEnd_: those of the window
+    //
+    // oldLabels_[order]: labels before the update of the cells of affected
+    // components of order 1 and 2, and of the 3-cells in the window
+    //
+    // touchedLabels_[order]: labels before the update of the affected
+    // components, possibly with duplicates
+    //
+    // movedLabels_[order]: labels taken by the last components of an order
+    // that are not affected, see relabel
+    //
+    // componentOf_[order]: index in components_[order] of every cell of
+    // order 1 and 2 in components_[order], of every 3-cell in the window and
+    // of every 3-cell visited by a search
+    //
+    // searchParents_: union-find forest of searches that have met
+    //
+    // searchOf_: search that has visited a 3-cell
 };
 
 } // namespace detail
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline
-CWX<T,C>::CWX(
-    const bool redundantAnchors
+CWX<T,C,LAYOUT>::CWX(
+    const bool redundantAnchors,
+    const LabelCacheMode labelCacheMode
 )
 :   byteLabeledCellgrid_(),
     cwcomplex_(),
     anchorage_(),
-    redundantAnchors_(redundantAnchors)
+    labelCache_(),
+    redundantAnchors_(redundantAnchors),
+    labelCacheMode_(labelCacheMode),
+    buildMemory_(0),
+    buildStats_()
 {}
 
-template<class T, class C>
-inline typename CWX<T,C>::Coordinate
-CWX<T,C>::shape(
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Coordinate
+CWX<T,C,LAYOUT>::shape(
     const Order dimension
 ) const
 {
     return byteLabeledCellgrid_.shape(dimension);
 }
 
-template<class T, class C>
-inline typename CWX<T,C>::Label
-CWX<T,C>::numberOfCells(
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::numberOfCells(
     const Order order
 ) const
 {
     return cwcomplex_.numberOfCells(order);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline size_t
-CWX<T,C>::sizeAbove(
+CWX<T,C,LAYOUT>::sizeAbove(
     const Order order,
     const Label label
 ) const
@@ -272,9 +461,9 @@ CWX<T,C>::sizeAbove(
     return cwcomplex_.sizeAbove(order, label);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline size_t
-CWX<T,C>::sizeBelow(
+CWX<T,C,LAYOUT>::sizeBelow(
     const Order order,
     const Label label
 ) const
@@ -282,9 +471,9 @@ CWX<T,C>::sizeBelow(
     return cwcomplex_.sizeBelow(order, label);
 }
 
-template<class T, class C>
-inline typename CWX<T,C>::Label
-CWX<T,C>::above(
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::above(
     const Order order,
     const Label label,
     const size_t j
@@ -293,9 +482,9 @@ CWX<T,C>::above(
     return cwcomplex_.above(order, label, j);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline void
-CWX<T,C>::above(
+CWX<T,C,LAYOUT>::above(
     const CellType& cell,
     CellVector& above
 ) const
@@ -303,9 +492,9 @@ CWX<T,C>::above(
     byteLabeledCellgrid_.above(cell, above);
 }
 
-template<class T, class C>
-inline typename CWX<T,C>::Label
-CWX<T,C>::below(
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::below(
     const Order order,
     const Label label,
     const size_t j
@@ -314,9 +503,9 @@ CWX<T,C>::below(
     return cwcomplex_.below(order, label, j);
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline void
-CWX<T,C>::below(
+CWX<T,C,LAYOUT>::below(
     const CellType& cell,
     CellVector& below
 ) const
@@ -324,23 +513,38 @@ CWX<T,C>::below(
     byteLabeledCellgrid_.below(cell, below);
 }
 
-template<class T, class C>
-inline typename CWX<T,C>::Label
-CWX<T,C>::atVoxel(
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::atVoxel(
     const Coordinate x,
     const Coordinate y,
     const Coordinate z
 ) const
 {
+    if(!labelCache_.empty()) {
+        return labelCache_.atVoxel(x, y, z);
+    }
     CellType cell(2*x, 2*y, 2*z);
     return atCell(cell);
 }
 
-template<class T, class C>
-typename CWX<T,C>::Label
-CWX<T,C>::atCell(
+// uses a workspace of the calling thread
+template<class T, class C, class LAYOUT>
+inline typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::atCell(
     const CellType& cell
 ) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    return atCell(cell, lease.workspace());
+}
+
+template<class T, class C, class LAYOUT>
+typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::atCell(
+    const CellType& cell,
+    TraversalWorkspaceType& workspace
+) const
 {
     // TODO: assert that inside bounds
     const Order order = cell.order();
@@ -348,102 +552,137 @@ CWX<T,C>::atCell(
         assert(byteLabeledCellgrid_.isAnchored(cell));
         return anchorage_.anchor(cell);
     }
+    else if(!labelCache_.empty() && (order == 3 || labelCache_.hasBoundaryCells())) {
+        return labelCache_.atCell(cell);
+    }
     else if(order == 3 || byteLabeledCellgrid_.isMarked(cell)) {
-        CellVector below;
-        CellVector above;
-        std::queue<CellType> queue;
-        ByteLabeledCellgridType visited(byteLabeledCellgrid_.shape(0), byteLabeledCellgrid_.shape(1), byteLabeledCellgrid_.shape(2));
-        // TODO: improve this, it's a waste of RAM
-        visited.mark(cell, true);
-        queue.push(cell);
-        while(!queue.empty()) {
-            if(byteLabeledCellgrid_.isAnchored(queue.front())) { // if anchor found
-                const Label label = anchorage_.anchor(queue.front());
-                if(label != 0) { // if anchor has a label for this cell
-                    return label;
-                }
-            }
-            byteLabeledCellgrid_.below(queue.front(), below);
-            queue.pop();
-            for(size_t j=0; j<below.size(); ++j) {
-                assert(below[j].order() == order - 1);
-                if(!byteLabeledCellgrid_.isMarked(below[j])) { // if not a boundary
-                    byteLabeledCellgrid_.above(below[j], above);
-                    for(size_t k=0; k<above.size(); ++k) {
-                        assert(above[k].order() == order);
-                        if((order == 3 || byteLabeledCellgrid_.isMarked(above[k])) && !visited.isMarked(above[k])) {
-                            visited.mark(above[k], true);
-                            queue.push(above[k]);
-                        }
-                    }
-                }
+        Label label = 0;
+        detail::traverseComponent(byteLabeledCellgrid_, cell, [&](const CellType& c) {
+            if(byteLabeledCellgrid_.isAnchored(c)) { // if anchor found
+                label = anchorage_.anchor(c); // 0 if the anchor has no label for this cell
             }
+            return label == 0;
+        }, workspace);
+        if(label == 0) {
+            throw std::runtime_error("no anchor found.");
         }
-        throw std::runtime_error("no anchor found.");
+        return label;
     }
     else {
         return 0;
     }
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-CWX<T,C>::isMarked(
+CWX<T,C,LAYOUT>::isMarked(
     const CellType& cell
 ) const
 {
     return byteLabeledCellgrid_.isMarked(cell);
 }
 
+// returns the number of bytes allocated for cached labels
+template<class T, class C, class LAYOUT>
+inline size_t
+CWX<T,C,LAYOUT>::labelCacheMemory() const
+{
+    return labelCache_.memory();
+}
+
+// returns an estimate of the peak number of bytes allocated by the last
+// build, computed from the bytes allocated for the grid, the buffers of
+// voxel slices and the component labelings. neither the segmentation passed
+// to build(view) nor the CW-complex and the anchorage are counted.
+template<class T, class C, class LAYOUT>
+inline size_t
+CWX<T,C,LAYOUT>::buildMemory() const
+{
+    return buildMemory_;
+}
+
+// statistics of the last build
+template<class T, class C, class LAYOUT>
+inline const BuildStats&
+CWX<T,C,LAYOUT>::buildStats() const
+{
+    return buildStats_;
+}
+
+// process one connected component, using a workspace of the calling thread
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+inline void
+CWX<T,C,LAYOUT>::process(
+    const Order order,
+    const Label label,
+    FUNCTOR& functor
+) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    process(order, label, functor, lease.workspace());
+}
+
 // process one connected component
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 template<class FUNCTOR>
 void
-CWX<T,C>::process(
+CWX<T,C,LAYOUT>::process(
     const Order order,
     const Label label,
-    FUNCTOR& functor
+    FUNCTOR& functor,
+    TraversalWorkspaceType& workspace
 ) const
 {
-    assert(label > 0 && label <= numberOfCells(order));
-    if(order == 0) {
-        CellType cell;
-        anchorage_.anchor(order, label, cell);
-        functor(cell);
-    }
-    else {
-        CellType cell;
-        anchorage_.anchor(order, label, cell);
-        CellVector below;
-        CellVector above;
-        std::queue<CellType> queue;
-        ByteLabeledCellgridType visited(byteLabeledCellgrid_.shape(0), byteLabeledCellgrid_.shape(1), byteLabeledCellgrid_.shape(2)); // TODO: improve this, it's a waste of RAM
-        visited.mark(cell, true);
-        queue.push(cell);
-        while(!queue.empty()) {
-            const bool proceed = functor(queue.front());
-            if(!proceed) {
-                return;
-            }
-            byteLabeledCellgrid_.below(queue.front(), below);
-            queue.pop();
-            for(size_t j=0; j<below.size(); ++j) {
-                assert(below[j].order() == order - 1);
-                if(!byteLabeledCellgrid_.isMarked(below[j])) { // if not a boundary
-                    byteLabeledCellgrid_.above(below[j], above);
-                    for(size_t k=0; k<above.size(); ++k) {
-                        assert(above[k].order() == order);
-                        if((order == 3 || byteLabeledCellgrid_.isMarked(above[k])) && !visited.isMarked(above[k])) {
-                            visited.mark(above[k], true);
-                            queue.push(above[k]);
-                        }
-                    }
-                }
-            }
-        }
+    switch(order) {
+    case 0:
+        process<0>(label, functor, workspace);
+        break;
+    case 1:
+        process<1>(label, functor, workspace);
+        break;
+    case 2:
+        process<2>(label, functor, workspace);
+        break;
+    default:
+        assert(order == 3);
+        process<3>(label, functor, workspace);
     }
 }
 
+// process one connected component of order ORDER, using a workspace of the
+// calling thread
+template<class T, class C, class LAYOUT>
+template<typename CWX<T,C,LAYOUT>::Order ORDER, class FUNCTOR>
+inline void
+CWX<T,C,LAYOUT>::process(
+    const Label label,
+    FUNCTOR& functor
+) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    process<ORDER>(label, functor, lease.workspace());
+}
+
+// process one connected component of order ORDER. the order is fixed at
+// compile time such that the traversal is specialized for it.
+template<class T, class C, class LAYOUT>
+template<typename CWX<T,C,LAYOUT>::Order ORDER, class FUNCTOR>
+void
+CWX<T,C,LAYOUT>::process(
+    const Label label,
+    FUNCTOR& functor,
+    TraversalWorkspaceType& workspace
+) const
+{
+    assert(label > 0 && label <= numberOfCells(ORDER));
+    CellType cell;
+    anchorage_.anchor(ORDER, label, cell);
+    detail::traverseComponent<ORDER>(byteLabeledCellgrid_, cell, [&](const CellType& c) {
+        return functor(c);
+    }, workspace);
+}
+
 // process all connected components of the given order
 // - the functor is expected to have three functions
 //   - bool operator(const CellType&)
@@ -454,17 +693,42 @@ CWX<T,C>::process(
 // - internally, this function iterates over all cells. 
 //   if you prefer to iterate over all labels of connected components, use
 //   the function process(order, label, functor) within a loop over all labels
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 template<class FUNCTOR>
 void
-CWX<T,C>::process(
+CWX<T,C,LAYOUT>::process(
     const Order order,
     FUNCTOR& functor
 ) const
+{
+    switch(order) {
+    case 0:
+        process<0>(functor);
+        break;
+    case 1:
+        process<1>(functor);
+        break;
+    case 2:
+        process<2>(functor);
+        break;
+    default:
+        assert(order == 3);
+        process<3>(functor);
+    }
+}
+
+// process all connected components of order ORDER, see above. the order is
+// fixed at compile time such that the traversal is specialized for it.
+template<class T, class C, class LAYOUT>
+template<typename CWX<T,C,LAYOUT>::Order ORDER, class FUNCTOR>
+void
+CWX<T,C,LAYOUT>::process(
+    FUNCTOR& functor
+) const
 {
     CellType cell;
-    if(order == 0) {
-        if(byteLabeledCellgrid_.firstCell(order, cell)) {
+    if(ORDER == 0) {
+        if(byteLabeledCellgrid_.firstCell(ORDER, cell)) {
             do {
                 const bool proceed = functor.preprocess(cell);
                 if(!proceed) {
@@ -475,13 +739,11 @@ CWX<T,C>::process(
     }
     else {
         ByteLabeledCellgridType visited(byteLabeledCellgrid_.shape(0), byteLabeledCellgrid_.shape(1), byteLabeledCellgrid_.shape(2));
-        CellVector above;
-        CellVector below;
         std::queue<CellType> queue;
-        if(byteLabeledCellgrid_.firstCell(order, cell)) {
+        if(byteLabeledCellgrid_.firstCell(ORDER, cell)) {
             do {
-                assert(cell.order() == order);
-                if((order == 3 || byteLabeledCellgrid_.isMarked(cell)) && !visited.isMarked(cell)) {
+                assert(cell.order() == ORDER);
+                if((ORDER == 3 || byteLabeledCellgrid_.isMarked(cell)) && !visited.isMarked(cell)) {
                     {
                         const bool proceed = functor.preprocess(cell);
                         if(!proceed) {
@@ -497,21 +759,14 @@ CWX<T,C>::process(
                                 return;
                             }
                         }
-                        byteLabeledCellgrid_.below(queue.front(), below);
+                        const CellType c = queue.front();
                         queue.pop();
-                        for(size_t j=0; j<below.size(); ++j) {
-                            assert(below[j].order() == order - 1);
-                            if(!byteLabeledCellgrid_.isMarked(below[j])) { // if not a boundary
-                                byteLabeledCellgrid_.above(below[j], above);
-                                for(size_t k=0; k<above.size(); ++k) {
-                                    assert(above[k].order() == order);
-                                    if((order == 3 || byteLabeledCellgrid_.isMarked(above[k])) && !visited.isMarked(above[k])) {
-                                        visited.mark(above[k], true);
-                                        queue.push(above[k]);
-                                    }
-                                }
+                        detail::forEachNeighbor<ORDER>(byteLabeledCellgrid_, c, [&](const CellType& neighbor) {
+                            if(!visited.isMarked(neighbor)) {
+                                visited.mark(neighbor, true);
+                                queue.push(neighbor);
                             }
-                        }
+                        });
                     }
                     {
                         const bool proceed = functor.postprocess();
@@ -525,6 +780,22 @@ CWX<T,C>::process(
     }
 }
 
+// process all connected components of the given order in the slice x_d = v,
+// using a workspace of the calling thread
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+inline void
+CWX<T,C,LAYOUT>::process(
+    const Order order,
+    const Order d,
+    const Coordinate v,
+    FUNCTOR& functor
+) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    process(order, d, v, functor, lease.workspace());
+}
+
 // process all connected components of the given order in the slice x_d = v
 // the functor is expected to have three functions
 // - bool operator(const CellType&)
@@ -532,55 +803,60 @@ CWX<T,C>::process(
 // - bool postprocess()
 // if the return value is false, the connected component analysis is stopped
 // completely.
-template<class T, class C>
+// the workspace holds the cells visited in the slice, i.e. its memory is
+// bounded by the size of the slice.
+template<class T, class C, class LAYOUT>
 template<class FUNCTOR>
 void
-CWX<T,C>::process(
+CWX<T,C,LAYOUT>::process(
     const Order order,
     const Order d,
     const Coordinate v,
-    FUNCTOR& functor
+    FUNCTOR& functor,
+    TraversalWorkspaceType& workspace
 ) const
 {
     // TODO: implement special case for 0-cells
     CellType cell;
-    ByteLabeledCellgridType visited(byteLabeledCellgrid_.shape(0), byteLabeledCellgrid_.shape(1), byteLabeledCellgrid_.shape(2)); // TODO: need RAM only for slice. also needs allocator.
     CellVector above;
     CellVector below;
-    std::queue<CellType> queue;
+    workspace.begin();
     if(byteLabeledCellgrid_.firstCell(order, d, v, cell)) {
         do { // trace connected component
             assert(cell.order() == order);
             assert(cell[d] == v);
-            if((order == 3 || byteLabeledCellgrid_.isMarked(cell)) && !visited.isMarked(cell)) {
+            if((order == 3 || byteLabeledCellgrid_.isMarked(cell)) && !workspace.isVisited(cell)) {
                 {
                     const bool proceed = functor.preprocess(cell);
                     if(!proceed) {
                         return;
                     }
                 }
-                visited.mark(cell, true);
-                queue.push(cell);
-                while(!queue.empty()) {
+                workspace.visit(cell);
+                workspace.push(cell);
+                while(!workspace.empty()) {
                     assert(cell.order() == order);
                     assert(cell[d] == v);
+                    const CellType front = workspace.front();
+                    workspace.pop();
                     {
-                        const bool proceed = functor(queue.front());
+                        const bool proceed = functor(front);
                         if(!proceed) {
                             return;
                         }
                     }
-                    byteLabeledCellgrid_.below(queue.front(), below);
-                    queue.pop();
+                    byteLabeledCellgrid_.below(front, below);
                     for(size_t j=0; j<below.size(); ++j) {
                         assert(below[j].order() == order - 1);
                         if(!byteLabeledCellgrid_.isMarked(below[j]) && below[j][d] == v) { // if not a boundary and in the same slice
                             byteLabeledCellgrid_.above(below[j], above);
                             for(size_t k=0; k<above.size(); ++k) {
                                 assert(above[k].order() == order);
-                                if((order == 3 || byteLabeledCellgrid_.isMarked(above[k])) && above[k][d] == v && !visited.isMarked(above[k])) {
-                                    visited.mark(above[k], true);
-                                    queue.push(above[k]);
+                                if((order == 3 || byteLabeledCellgrid_.isMarked(above[k])) && above[k][d] == v) {
+                                    const PackedCell packed(above[k]);
+                                    if(workspace.visit(packed)) {
+                                        workspace.push(packed);
+                                    }
                                 }
                             }
                         }
@@ -597,199 +873,962 @@ CWX<T,C>::process(
     }
 }
 
-template<class T, class C>
+// process the connected components of the given order with labels in the
+// range [labelBegin, labelEnd), in parallel
+// - factory() is called once per thread and returns the functor of this
+//   thread. the functors are returned in functors, such that their results
+//   can be merged by the caller.
+// - the functor is expected to have the function
+//   - bool operator()(const Label, const CellType&)
+//   which is called with the label and each cell of the component.
+//   if the return value is false, the processing of this component is
+//   stopped.
+// - threads take labels one at a time, such that large components do not
+//   hold up the other threads. which thread processes a label is
+//   unspecified.
+// - each thread traverses components with its own workspace, whose memory
+//   is bounded by the size of the largest component it processes
+// - if numberOfThreads is 0, the number of hardware threads is used
+template<class T, class C, class LAYOUT>
+template<class FACTORY, class FUNCTOR>
+void
+CWX<T,C,LAYOUT>::parallelProcess(
+    const Order order,
+    const Label labelBegin,
+    const Label labelEnd,
+    FACTORY factory,
+    std::vector<FUNCTOR>& functors,
+    const size_t numberOfThreads
+) const
+{
+    if(labelBegin == 0 || labelBegin > labelEnd || labelEnd > numberOfCells(order) + 1) {
+        throw std::runtime_error("label range out of bounds.");
+    }
+    const size_t numberOfLabels = labelEnd - labelBegin;
+    const size_t threads = numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads;
+    const size_t n = numberOfLabels < threads ? numberOfLabels : threads;
+    functors.clear();
+    functors.reserve(n);
+    for(size_t j = 0; j < n; ++j) {
+        functors.push_back(factory());
+    }
+    std::atomic<size_t> next(0);
+    parallelFor(n, [&](const size_t thread) {
+        FUNCTOR& functor = functors[thread];
+        detail::WorkspaceLease<Coordinate> lease;
+        for(size_t j = next++; j < numberOfLabels; j = next++) {
+            const Label label = static_cast<Label>(labelBegin + j);
+            auto labeled = [&](const CellType& cell) {
+                return functor(label, cell);
+            };
+            process(order, label, labeled, lease.workspace());
+        }
+    });
+}
+
+template<class T, class C, class LAYOUT>
 template<class U, bool B>
 void
-CWX<T,C>::build(
+CWX<T,C,LAYOUT>::build(
     const andres::View<U, B>& volumeLabeling,
-    bool verbose
+    bool verbose,
+    const size_t numberOfThreads
 )
 {
-    // TODO: define anchors in every connected component in every slice
     using std::cout; using std::endl; using std::flush;
     
     if(volumeLabeling.dimension() != 3) {
         throw std::runtime_error("segmentation is not 3-dimensional.");
     }
+    const detail::Stopwatch totalStopwatch;
+    buildStats_ = BuildStats();
     byteLabeledCellgrid_ = ByteLabeledCellgridType(
         volumeLabeling.shape(0),
         volumeLabeling.shape(1),
         volumeLabeling.shape(2));
+    buildMemory_ = byteLabeledCellgrid_.memory();
 
     // mark cells
+    // all cells of order k are marked before any cell of order k-1 because
+    // the latter depend on the marks of the former.
     if(verbose) cout << "mark cells" << flush;
+    const detail::Stopwatch markingStopwatch;
+    std::vector<CellType> zeroCells;
+    for(int order = 2; order >= 0; --order) {
+        if(verbose) cout << " " << order << "-cells" << flush;
+        markCells(volumeLabeling, 0, order, 0, shape(2), numberOfThreads, zeroCells);
+    }
+    buildStats_.markingTime = markingStopwatch.seconds();
+    buildMemory_ = std::max(buildMemory_, byteLabeledCellgrid_.memory());
+    if(verbose) cout << endl;
+
+    buildComplex(zeroCells, verbose, numberOfThreads);
+    buildStats_.peakMemory = buildMemory_;
+    buildStats_.totalTime = totalStopwatch.seconds();
+    if(verbose) cout << buildStats_;
+}
+
+// builds the data structure from a segmentation that is loaded in slabs of
+// voxel slices orthogonal to dimension 2, such that the segmentation need
+// not fit into memory.
+// - the loader is expected to have
+//   - a type value_type (the type of the labels of voxels)
+//   - size_t shape(const size_t) const
+//   - void operator()(const size_t, const size_t, andres::Marray<value_type>&)
+//     that loads the voxel slices [sliceBegin, sliceEnd) into a 3-dimensional
+//     array, e.g. HDF5SlabLoader in cwx/hdf5.hxx
+// - the slabs are as thick as the memory budget (in bytes) permits next to
+//   the grid of bytes. every slab is loaded together with the next slice (a
+//   one-voxel halo) because the 2-cells in its last slice separate voxels of
+//   both slices.
+// - connected components are labeled slice by slice, such that the memory
+//   for labeling is proportional to the size of a slice, not to the size of
+//   the volume. the labels of the components of slices are kept in tables
+//   whose size depends on the segmentation and is not foreseen, as is the
+//   growth of grids whose layout allocates memory for marked cells.
+// - an exception is thrown if the budget is smaller than the estimated
+//   peak memory of the build with slabs of one slice, or than the memory of
+//   the grid and the buffers for labeling. buildMemory() returns the peak
+//   memory of the build, including the tables of components of slices.
+template<class T, class C, class LAYOUT>
+template<class LOADER>
+void
+CWX<T,C,LAYOUT>::buildFromSlabs(
+    LOADER& loader,
+    const size_t memoryBudget,
+    bool verbose,
+    const size_t numberOfThreads
+)
+{
+    typedef typename LOADER::value_type Value;
+    using std::cout; using std::endl; using std::flush;
+
+    const detail::Stopwatch totalStopwatch;
+    byteLabeledCellgrid_ = ByteLabeledCellgridType(
+        loader.shape(0),
+        loader.shape(1),
+        loader.shape(2));
+    const size_t gridMemory = byteLabeledCellgrid_.memory();
+    const size_t sliceMemory = static_cast<size_t>(loader.shape(0))
+        * loader.shape(1) * sizeof(Value);
+    if(gridMemory + 2 * sliceMemory > memoryBudget
+    || gridMemory + labelingMemory(shape(0), shape(1), shape(2), numberOfThreads) > memoryBudget) {
+        throw std::runtime_error("memory budget is too small.");
+    }
+    const Coordinate slabSize = static_cast<Coordinate>(std::min<size_t>(
+        loader.shape(2), (memoryBudget - gridMemory) / sliceMemory - 1));
+
+    buildStats_ = BuildStats();
+    buildMemory_ = gridMemory;
+
+    // mark cells slab by slab
+    // 1-cells (0-cells) in a slice depend on the marks of 2-cells (1-cells)
+    // in the same and in the next slice. thus, 1-cells (0-cells) are marked
+    // one slice (two slices) behind the 2-cells, and the cells of lower order
+    // in the last slab are marked when this slab is loaded.
+    if(verbose) cout << "mark cells in slabs of " << slabSize << " slices" << endl;
+    const detail::Stopwatch markingStopwatch;
+    std::vector<CellType> zeroCells;
     {
-        CellVector cells;
-        CellType cell;
-        if(verbose) cout << " 2-cells" << flush;
-        // 2-cells
-        if(byteLabeledCellgrid_.firstCell(2, cell)) {
-            do {
-                byteLabeledCellgrid_.above(cell, cells);
-                assert(cells.size() == 2);
-                if(volumeLabeling(cells[0][0]/2, cells[0][1]/2, cells[0][2]/2)
-                != volumeLabeling(cells[1][0]/2, cells[1][1]/2, cells[1][2]/2)) {
-                    byteLabeledCellgrid_.mark(cell, true);
-                }
-            } while(byteLabeledCellgrid_.orderPreservingIncrement(cell));
-        }
-        // 1-cells
-        if(verbose) cout << " 1-cells" << flush;
-        if(byteLabeledCellgrid_.firstCell(1, cell)) {
-           do {
-                unsigned char marked = 0;
-                byteLabeledCellgrid_.above(cell, cells);
-                for(size_t j=0; j<cells.size(); ++j) {
-                    if(byteLabeledCellgrid_.isMarked(cells[j])) {
-                        ++marked;
-                        if(marked > 2) {
-                            byteLabeledCellgrid_.mark(cell, true);
-                            break;
-                        }
-                    }
-                }
-            } while(byteLabeledCellgrid_.orderPreservingIncrement(cell));
-        }
-        // 0-cells
-        if(verbose) cout << " 0-cells" << flush;
-        if(byteLabeledCellgrid_.firstCell(0, cell)) {
-           do {
-                byteLabeledCellgrid_.above(cell, cells);
-                unsigned char marked = 0;
-                for(size_t j=0; j<cells.size(); ++j) {
-                    if(byteLabeledCellgrid_.isMarked(cells[j])) {
-                        ++marked;
-                        if(marked > 2) {
-                            byteLabeledCellgrid_.mark(cell, true);
-                            const Label label = cwcomplex_.push_back(0);
-                            byteLabeledCellgrid_.anchor(cell, true);
-                            const Label sameLabel = anchorage_.push_back(cell);
-                            assert(label == sameLabel);
-                            break;
-                        }
-                    }
-                }
-                // TODO: check if the following treatment is consistent
-                // with the axioms of topology
-                if(marked == 1) { // the weird case
-                    byteLabeledCellgrid_.mark(cell, true);
-                    const Label label = cwcomplex_.push_back(0);
-                    byteLabeledCellgrid_.anchor(cell, true);
-                    const Label sameLabel = anchorage_.push_back(cell);
-                    assert(label == sameLabel);
-                }
-            } while(byteLabeledCellgrid_.orderPreservingIncrement(cell));
+        andres::Marray<Value> slab;
+        Coordinate end1 = 0; // 1-cells are marked in the slices [0, end1)
+        Coordinate end0 = 0; // 0-cells are marked in the slices [0, end0)
+        for(Coordinate sliceBegin = 0; sliceBegin < shape(2); sliceBegin += slabSize) {
+            const Coordinate sliceEnd = std::min<Coordinate>(sliceBegin + slabSize, shape(2));
+            const detail::Stopwatch loadingStopwatch;
+            loader(sliceBegin, std::min<Coordinate>(sliceEnd + 1, shape(2)), slab);
+            buildStats_.loadingTime += loadingStopwatch.seconds();
+            if(slab.dimension() != 3 || slab.shape(0) != shape(0) || slab.shape(1) != shape(1)
+            || slab.shape(2) != std::min<Coordinate>(sliceEnd + 1, shape(2)) - sliceBegin) {
+                throw std::runtime_error("slab has an incorrect shape.");
+            }
+
+            markCells(slab, sliceBegin, 2, sliceBegin, sliceEnd, numberOfThreads, zeroCells);
+            const Coordinate newEnd1 = sliceEnd == shape(2) ? sliceEnd : sliceEnd - 1;
+            markCells(slab, sliceBegin, 1, end1, newEnd1, numberOfThreads, zeroCells);
+            end1 = newEnd1;
+            const Coordinate newEnd0 = end1 == shape(2) || end1 == 0 ? end1 : end1 - 1;
+            markCells(slab, sliceBegin, 0, end0, newEnd0, numberOfThreads, zeroCells);
+            end0 = newEnd0;
+            buildMemory_ = std::max(buildMemory_,
+                byteLabeledCellgrid_.memory() + slab.size() * sizeof(Value));
         }
+        assert(end1 == shape(2) && end0 == shape(2));
+    }
+    buildStats_.markingTime = markingStopwatch.seconds() - buildStats_.loadingTime;
+
+    buildComplex(zeroCells, verbose, numberOfThreads);
+    buildStats_.peakMemory = buildMemory_;
+    buildStats_.totalTime = totalStopwatch.seconds();
+    if(verbose) {
+        cout << buildStats_;
+        cout << "peak memory: " << buildMemory_ << " bytes (budget "
+            << memoryBudget << " bytes)" << endl;
+    }
+}
+
+// labels the connected components of all orders, given the marked cells
+// and the marked 0-cells in scan order. fills all statistics except the
+// times of loading and marking, the total time and the peak memory.
+template<class T, class C, class LAYOUT>
+void
+CWX<T,C,LAYOUT>::buildComplex(
+    const std::vector<CellType>& zeroCells,
+    bool verbose,
+    const size_t numberOfThreads
+)
+{
+    // TODO: define anchors in every connected component in every slice
+    using std::cout; using std::endl;
+
+    // label 0-cells in scan order
+    detail::Stopwatch stopwatch;
+    for(size_t j = 0; j < zeroCells.size(); ++j) {
+        const Label label = cwcomplex_.push_back(0);
+        const Label sameLabel = anchorage_.push_back(zeroCells[j]);
+        assert(label == sameLabel);
     }
+    buildStats_.labelingTime[0] = stopwatch.restart();
 
     // label connected components of 3-cells, 2-cells and 1-cells
-    if(verbose) cout << endl;
+    if(labelCacheMode_ == NoLabelCache) {
+        labelCache_.clear();
+    }
+    else {
+        labelCache_.assign(shape(0), shape(1), shape(2), labelCacheMode_ == CellLabelCache);
+    }
+    // the grid is counted by the bytes allocated for its layout, which grow
+    // with the anchors in sparse layouts
+    const size_t buffersMemory = labelingMemory(shape(0), shape(1), shape(2), numberOfThreads);
+    buildMemory_ = std::max(buildMemory_, byteLabeledCellgrid_.memory() + buffersMemory);
+    // the labeling of order k is kept until the cells of order k-1 have been
+    // connected to those of order k. only the labels of the components of
+    // slices are kept, as the first cells of components are anchored.
+    std::unique_ptr<detail::ComponentLabeling<T, C, LAYOUT> > upperLabeling;
     for(Order order = 3; order > 0; --order) {
         if(verbose) cout << "label connected components of " << (int)order << "-cells" << endl;
-        Labeler labeler(*this, order);
-        process(order, labeler);
+        std::unique_ptr<detail::ComponentLabeling<T, C, LAYOUT> > labelingPointer(
+            new detail::ComponentLabeling<T, C, LAYOUT>(byteLabeledCellgrid_, order, numberOfThreads));
+        const detail::ComponentLabeling<T, C, LAYOUT>& labeling = *labelingPointer;
+        for(Label label = 1; label <= labeling.numberOfComponents(); ++label) {
+            const CellType& cell = labeling.firstCell(label);
+            const Label newLabel = cwcomplex_.push_back(order);
+            assert(newLabel == label);
+            byteLabeledCellgrid_.anchor(cell, true);
+            const Label sameLabel = anchorage_.push_back(cell);
+            assert(sameLabel == label);
+        }
+        buildMemory_ = std::max(buildMemory_, byteLabeledCellgrid_.memory() + buffersMemory
+            + labeling.peakMemory() + labeling.memory() + (upperLabeling ? upperLabeling->memory() : 0));
+        labelingPointer->clearFirstCells();
+        if(!labelCache_.empty() && (order == 3 || labelCache_.hasBoundaryCells())) {
+            labeling.forEachCell([&](const CellType& cell, const Label label) {
+                if(label != 0) {
+                    labelCache_.insert(cell, label);
+                }
+            });
+        }
+        buildStats_.labelingTime[order] = stopwatch.restart();
+        if(redundantAnchors_ && order == 1) {
+            // every 1-cell of a connected component of 1-cells becomes an anchor
+            anchorage_.reserve(anchorage_.numberOfAnchors() + labeling.numberOfCells());
+            labeling.forEachCell([&](const CellType& cell, const Label label) {
+                if(label != 0) {
+                    byteLabeledCellgrid_.anchor(cell, true);
+                    anchorage_.anchor(cell, label);
+                }
+            });
+            buildStats_.redundantAnchorTime += stopwatch.restart();
+        }
+        if(order < 3) {
+            if(verbose) cout << "connect " << (int)order << "-cells" << endl;
+            connect(labeling, *upperLabeling, numberOfThreads);
+            upperLabeling.reset();
+            buildStats_.connectTime[order] = stopwatch.restart();
+        }
+        if(order == 1) {
+            if(verbose) cout << "connect 0-cells" << endl;
+            connectZeroCells(labeling);
+            buildStats_.connectTime[0] = stopwatch.restart();
+        }
+        upperLabeling = std::move(labelingPointer);
     }
+    upperLabeling.reset();
 
     if(redundantAnchors_) {
         Anchorer anchorer(*this);
+        detail::WorkspaceLease<Coordinate> lease;
         for(Order d=0; d<3; ++d) { // dimension orthogonal to the slice
             if(verbose) cout << "redundant anchors normal " << (int)d << endl;
             for(Coordinate v=0; v<2*shape(d)-1; ++v) { // coordinate in that dimension
                 for(Order order = 2; order < 4; ++order) { // increasing order results in less anchors
-                    process(order, d, v, anchorer);
+                    process(order, d, v, anchorer, lease.workspace());
+                    buildStats_.numberOfVisitedCells += lease.workspace().numberOfVisitedCells();
                 }
             }
         }
+        buildStats_.redundantAnchorTime += stopwatch.restart();
     }
-
-    // update cwcomplex_ for 0-cells
-    if(verbose) cout << "update cwcomplex_ for 0-cells" << endl;
-    CellType cell;
-    for(Label label = 1; label <= numberOfCells(0); ++label) {
-        anchorage_.anchor(0, label, cell);
-        connect(cell, label);
-    }
+    buildMemory_ = std::max(buildMemory_, byteLabeledCellgrid_.memory());
 
     // TODO: collect labels of connected components of *all orders* in *each* anchor
 
     if(verbose) cout << "test invariant" << endl;
     testInvariant();
+    buildStats_.invariantTestTime = stopwatch.restart();
+
+    for(Order order = 0; order < 4; ++order) {
+        buildStats_.numberOfCells[order] = numberOfCells(order);
+    }
+    buildStats_.numberOfAnchors = anchorage_.numberOfAnchors();
+    buildStats_.gridMemory = byteLabeledCellgrid_.memory();
+    buildStats_.complexMemory = cwcomplex_.memory();
+    buildStats_.anchorageMemory = anchorage_.memory();
+    buildStats_.labelCacheMemory = labelCache_.memory();
 }
 
-// inserts connections into cwcomplex_
-template<class T, class C>
-inline void
-CWX<T,C>::connect(
-    const CellType& cell,
-    const Label& label
+// returns an upper bound on the number of bytes allocated by buildComplex for
+// the buffers of slices of the component labelings and for the label cache
+// of a volume with the given shape, not counting the tables of components
+// of slices (see ComponentLabeling::memory and peakMemory) and the boundary
+// cells in the label cache. every thread holds up to four buffers of the
+// size of a slice of 1- or 2-cells.
+template<class T, class C, class LAYOUT>
+inline size_t
+CWX<T,C,LAYOUT>::labelingMemory(
+    const Coordinate shape0,
+    const Coordinate shape1,
+    const Coordinate shape2,
+    const size_t numberOfThreads
+) const
+{
+    const size_t numberOfSlabs = std::min<size_t>(shape2,
+        numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads);
+    size_t memory = 4 * numberOfSlabs
+        * detail::ComponentLabeling<T, C, LAYOUT>::sliceMemory(shape0, shape1, 1);
+    if(labelCacheMode_ != NoLabelCache) {
+        memory += static_cast<size_t>(shape0) * shape1 * shape2 * sizeof(Label);
+    }
+    return memory;
+}
+
+// marks all cells of the given order whose voxel coordinate in dimension 2 is
+// in [sliceBegin, sliceEnd), in parallel. the view holds the voxel slices of
+// dimension 2 from offset on. marked 0-cells are appended to zeroCells in
+// scan order.
+// the slices are partitioned into slabs, one per thread. marking a 1- or
+// 0-cell reads bytes of the same and of the next slice. therefore, the last
+// slice of every slab is marked after all other slices such that no thread
+// writes to a byte that another thread reads. this requires every slab to
+// consist of at least two slices. layouts that allocate memory when bytes
+// are written are marked by one thread.
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+void
+CWX<T,C,LAYOUT>::markCells(
+    const andres::View<U, B>& volumeLabeling,
+    const Coordinate offset,
+    const Order order,
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    const size_t numberOfThreads,
+    std::vector<CellType>& zeroCells
 )
 {
-    CellVector above;
-    byteLabeledCellgrid_.above(cell, above);
-    std::set<Label> labelsAbove; // TODO: max size is 6, need not heap alloc
-    for(size_t j=0; j<above.size(); ++j) {
-        const Label labelAbove = atCell(above[j]);
-        if(labelAbove != 0) {
-            labelsAbove.insert(labelAbove);
-        }
+    assert(order < 3 && sliceBegin <= sliceEnd);
+    if(sliceBegin == sliceEnd) {
+        return;
+    }
+    const size_t numberOfSlabs = !LAYOUT::concurrentWrites ? 1 : std::max<size_t>(1, std::min<size_t>(
+        numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads,
+        (sliceEnd - sliceBegin) / 2));
+    const SlabPartition slabs(sliceEnd - sliceBegin, numberOfSlabs);
+    std::vector<std::vector<CellType> > slabZeroCells(slabs.numberOfSlabs());
+    if(order == 2) {
+        parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+            markSlices(volumeLabeling, offset, order, sliceBegin + slabs.begin(j),
+                sliceBegin + slabs.end(j), slabZeroCells[j]);
+        });
     }
-    for(typename std::set<Label>::const_iterator it = labelsAbove.begin(); it != labelsAbove.end(); ++it) {
-        cwcomplex_.connect(cell.order(), label, *it);
+    else {
+        parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+            markSlices(volumeLabeling, offset, order, sliceBegin + slabs.begin(j),
+                sliceBegin + slabs.end(j) - 1, slabZeroCells[j]);
+        });
+        parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+            markSlices(volumeLabeling, offset, order, sliceBegin + slabs.end(j) - 1,
+                sliceBegin + slabs.end(j), slabZeroCells[j]);
+        });
+    }
+    for(size_t j = 0; j < slabZeroCells.size(); ++j) {
+        std::sort(slabZeroCells[j].begin(), slabZeroCells[j].end());
+        zeroCells.insert(zeroCells.end(), slabZeroCells[j].begin(), slabZeroCells[j].end());
     }
 }
 
-template<class T, class C>
-inline void
-CWX<T,C>::testInvariant() const
+// marks all cells of the given order whose voxel coordinate in dimension 2 is
+// in [sliceBegin, sliceEnd). the view holds the voxel slices of dimension 2
+// from offset on. marked 0-cells are anchored in byteLabeledCellgrid_ and
+// appended to zeroCells.
+// whole rows of voxels are marked at once if the memory layout permits.
+// otherwise, the cells are marked one by one.
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+void
+CWX<T,C,LAYOUT>::markSlices(
+    const andres::View<U, B>& volumeLabeling,
+    const Coordinate offset,
+    const Order order,
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    std::vector<CellType>& zeroCells
+)
 {
-#   ifndef NDEBUG
-    for(Order order = 0; order < 4; ++order) {
-        assert(cwcomplex_.numberOfCells(order) == anchorage_.numberOfCells(order));
+    assert(order < 3);
+    {
+        detail::Marker<T, C, LAYOUT> marker(byteLabeledCellgrid_);
+        if(order == 2 ? marker.markBoundaries(volumeLabeling, sliceBegin, sliceEnd, offset)
+                      : marker.mark(order, sliceBegin, sliceEnd, zeroCells)) {
+            return;
+        }
     }
+    CellVector cells;
+    const Coordinate cellEnd = std::min<Coordinate>(2 * sliceEnd, 2 * shape(2) - 1);
+    byteLabeledCellgrid_.forEachCellInSlab(order, 2 * sliceBegin, cellEnd, [&](const CellType& cell) {
+        byteLabeledCellgrid_.above(cell, cells);
+        if(order == 2) {
+            assert(cells.size() == 2);
+            if(volumeLabeling(cells[0][0]/2, cells[0][1]/2, cells[0][2]/2 - offset)
+            != volumeLabeling(cells[1][0]/2, cells[1][1]/2, cells[1][2]/2 - offset)) {
+                byteLabeledCellgrid_.mark(cell, true);
+            }
+        }
+        else {
+            unsigned char marked = 0;
+            for(size_t j=0; j<cells.size(); ++j) {
+                if(byteLabeledCellgrid_.isMarked(cells[j])) {
+                    ++marked;
+                }
+            }
+            if(order == 1) {
+                if(marked > 2) {
+                    byteLabeledCellgrid_.mark(cell, true);
+                }
+            }
+            // TODO: check if the treatment of the weird case
+            // (marked == 1) is consistent with the axioms of topology
+            else if(marked > 2 || marked == 1) {
+                byteLabeledCellgrid_.mark(cell, true);
+                byteLabeledCellgrid_.anchor(cell, true);
+                zeroCells.push_back(cell);
+            }
+        }
+        return true;
+    });
+}
 
-    CellType cell;
-    CellVector above;
-
-    for(cell[2] = 0; cell[2] < 2*shape(2)-1; ++cell[2]) {
-        for(cell[1] = 0; cell[1] < 2*shape(1)-1; ++cell[1]) {
-            for(cell[0] = 0; cell[0] < 2*shape(0)-1; ++cell[0]) {
-                if(byteLabeledCellgrid_.isMarked(cell)) {
-                    const Label label = atCell(cell);
-                    assert(label != 0);
-
-                    std::set<Label> labelsAbove;
+// inserts the connections between all cells of the order of lowerLabeling
+// and the cells of the next higher order into cwcomplex_, in one pass over
+// the slices, in parallel. the cells above a cell in the slice z are in the
+// slices z and z+1. thus, every thread holds the labels of one slice of the
+// lower order and of two slices of the upper order.
+template<class T, class C, class LAYOUT>
+void
+CWX<T,C,LAYOUT>::connect(
+    const detail::ComponentLabeling<T, C, LAYOUT>& lowerLabeling,
+    const detail::ComponentLabeling<T, C, LAYOUT>& upperLabeling,
+    const size_t numberOfThreads
+)
+{
+    typedef detail::ComponentLabeling<T, C, LAYOUT> ComponentLabelingType;
+    typedef std::vector<std::pair<Label, Label> > Pairs;
+
+    assert(lowerLabeling.order() + 1 == upperLabeling.order());
+    const SlabPartition slabs(shape(2), numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads);
+    std::vector<Pairs> slabPairs(slabs.numberOfSlabs());
+    parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+        Pairs& pairs = slabPairs[j];
+        std::vector<typename ComponentLabelingType::Index> buffer;
+        typename ComponentLabelingType::Slice lowerSlice(lowerLabeling);
+        typename ComponentLabelingType::Slice upperSlice(upperLabeling);
+        typename ComponentLabelingType::Slice nextUpperSlice(upperLabeling);
+        CellVector above;
+        for(Coordinate z = slabs.begin(j); z < slabs.end(j); ++z) {
+            lowerSlice.assign(z, buffer);
+            if(z == slabs.begin(j)) {
+                upperSlice.assign(z, buffer);
+            }
+            else {
+                upperSlice.swap(nextUpperSlice);
+            }
+            if(z + 1 < shape(2)) {
+                nextUpperSlice.assign(z + 1, buffer);
+            }
+            const size_t begin = pairs.size();
+            lowerSlice.forEachCell([&](const CellType& cell, const Label label) {
+                if(label != 0) {
                     byteLabeledCellgrid_.above(cell, above);
-                    for(size_t j=0; j<above.size(); ++j) {
-                        const Label labelAbove = atCell(above[j]);
+                    for(size_t k=0; k<above.size(); ++k) {
+                        const Label labelAbove = above[k][2] / 2 == z
+                            ? upperSlice.label(above[k]) : nextUpperSlice.label(above[k]);
                         if(labelAbove != 0) {
-                            labelsAbove.insert(labelAbove);
+                            const std::pair<Label, Label> pair(label, labelAbove);
+                            if(pairs.size() == begin || pairs.back() != pair) { // cheap deduplication
+                                pairs.push_back(pair);
+                            }
                         }
                     }
-                    assert(labelsAbove.size() == sizeAbove(cell.order(), label));
-                    typename std::set<Label>::const_iterator it = labelsAbove.begin();
-                    for(size_t j=0; j<labelsAbove.size(); ++j, ++it) {
-                        assert((CWX<T, C>::above(cell.order(), label, j)) == *it);
+                }
+            });
+            std::sort(pairs.begin() + begin, pairs.end());
+            pairs.erase(std::unique(pairs.begin() + begin, pairs.end()), pairs.end());
+        }
+    });
+
+    Pairs pairs;
+    for(size_t j = 0; j < slabPairs.size(); ++j) {
+        pairs.insert(pairs.end(), slabPairs[j].begin(), slabPairs[j].end());
+        Pairs().swap(slabPairs[j]);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    cwcomplex_.connectPairs(lowerLabeling.order(), pairs.begin(), pairs.end());
+}
+
+// inserts the connections between all 0-cells and 1-cells into cwcomplex_.
+// the 0-cells are labeled in scan order, such that the labels of the slices
+// of 1-cells are computed once.
+template<class T, class C, class LAYOUT>
+void
+CWX<T,C,LAYOUT>::connectZeroCells(
+    const detail::ComponentLabeling<T, C, LAYOUT>& oneCellLabeling
+)
+{
+    typedef detail::ComponentLabeling<T, C, LAYOUT> ComponentLabelingType;
+
+    assert(oneCellLabeling.order() == 1);
+    std::vector<std::pair<Label, Label> > pairs;
+    std::vector<typename ComponentLabelingType::Index> buffer;
+    typename ComponentLabelingType::Slice slice(oneCellLabeling);
+    typename ComponentLabelingType::Slice nextSlice(oneCellLabeling);
+    bool assigned = false;
+    CellType cell;
+    CellVector above;
+    for(Label label = 1; label <= numberOfCells(0); ++label) {
+        anchorage_.anchor(0, label, cell);
+        const Coordinate z = cell[2] / 2; // cells above are in the slices z and z+1
+        if(!assigned || z != slice.z()) {
+            if(assigned && z == slice.z() + 1) {
+                slice.swap(nextSlice);
+            }
+            else {
+                slice.assign(z, buffer);
+            }
+            if(z + 1 < shape(2)) {
+                nextSlice.assign(z + 1, buffer);
+            }
+            assigned = true;
+        }
+        byteLabeledCellgrid_.above(cell, above);
+        const size_t begin = pairs.size();
+        for(size_t j=0; j<above.size(); ++j) {
+            const Label labelAbove = above[j][2] / 2 == z
+                ? slice.label(above[j]) : nextSlice.label(above[j]);
+            if(labelAbove != 0) {
+                pairs.push_back(std::pair<Label, Label>(label, labelAbove));
+            }
+        }
+        std::sort(pairs.begin() + begin, pairs.end());
+        pairs.erase(std::unique(pairs.begin() + begin, pairs.end()), pairs.end());
+    }
+    cwcomplex_.connectPairs(0, pairs.begin(), pairs.end());
+}
+
+// stores the label of all cells of a connected component in the label
+// cache, by a traversal from its anchor. does nothing if the cells of this
+// order are not cached.
+template<class T, class C, class LAYOUT>
+void
+CWX<T,C,LAYOUT>::cacheLabels(
+    const Order order,
+    const Label label,
+    TraversalWorkspaceType& workspace
+)
+{
+    if(labelCache_.empty() || order == 0 || (order != 3 && !labelCache_.hasBoundaryCells())) {
+        return;
+    }
+    CellType cell;
+    anchorage_.anchor(order, label, cell);
+    detail::traverseComponent(byteLabeledCellgrid_, cell, [&](const CellType& c) {
+        labelCache_.insert(c, label);
+        return true;
+    }, workspace);
+}
+
+// merges two adjacent 3-cells, with the same result as a build from a
+// segmentation in which the voxels of both 3-cells have the same label, up
+// to the labels of cells:
+// - the 2-cells between the 3-cells are removed.
+// - 1-cells that bound less than three 2-cells afterwards are removed. the
+//   2-cells they separated are merged.
+// - 0-cells are removed or added according to the 1-cells they bound, and
+//   the 1-cells at the changed 0-cells are labeled anew.
+// the cost is proportional to the size of the 2-cells between the 3-cells
+// and of the 1-cells at their boundary, plus one label lookup per 2-cell
+// that bounds such a 1-cell, not to the size of the volume. with a label
+// cache, the cells of the merged 3-cell and of the 3-cell that takes the
+// label label1 are labeled anew in the cache, as are those of the 1- and
+// 2-cells whose label changes if boundary cells are cached.
+//
+// labels are kept contiguous: the merged 3-cell has the label label0 unless
+// label0 is the last label, in which case it takes label1. apart from that,
+// the last 3-cell takes the label label1. labels of cells of lower order at
+// the boundary of the merged 3-cells can change.
+// returns the label of the merged 3-cell. throws if the 3-cells are not
+// adjacent.
+template<class T, class C, class LAYOUT>
+typename CWX<T,C,LAYOUT>::Label
+CWX<T,C,LAYOUT>::merge(
+    const Label label0,
+    const Label label1
+)
+{
+    if(label0 == 0 || label0 > numberOfCells(3) || label1 == 0 || label1 > numberOfCells(3) || label0 == label1) {
+        throw std::runtime_error("invalid labels of 3-cells.");
+    }
+
+    // 2-cells between the 3-cells
+    std::vector<Label> removedLabels[4];
+    for(size_t j=0; j<sizeBelow(3, label1); ++j) {
+        const Label label = below(3, label1, j);
+        if(above(2, label, 0) == std::min(label0, label1) && above(2, label, 1) == std::max(label0, label1)) {
+            removedLabels[2].push_back(label);
+        }
+    }
+    if(removedLabels[2].empty()) {
+        throw std::runtime_error("3-cells are not adjacent.");
+    }
+    removedLabels[3].push_back(label1);
+
+    // unmark the 2-cells between the 3-cells
+    detail::WorkspaceLease<Coordinate> lease;
+    CellType cell;
+    CellVector cells;
+    std::vector<CellType> faces;
+    for(size_t j=0; j<removedLabels[2].size(); ++j) {
+        anchorage_.anchor(2, removedLabels[2][j], cell);
+        detail::traverseComponent(byteLabeledCellgrid_, cell, [&](const CellType& c) {
+            faces.push_back(c);
+            return true;
+        }, lease.workspace());
+    }
+    std::vector<CellType> edges; // marked 1-cells that bound these 2-cells
+    for(size_t j=0; j<faces.size(); ++j) {
+        byteLabeledCellgrid_.mark(faces[j], false);
+        anchorage_.erase(faces[j]);
+        byteLabeledCellgrid_.below(faces[j], cells);
+        for(size_t k=0; k<cells.size(); ++k) {
+            if(byteLabeledCellgrid_.isMarked(cells[k])) {
+                edges.push_back(cells[k]);
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // 1-cells that bound less than three 2-cells and the pairs of 2-cells
+    // they separate. the labels of 2-cells are taken before any 1-cell is
+    // unmarked.
+    std::vector<CellType> removedEdges;
+    std::map<Label, Label> parents; // union-find forest of labels of 2-cells
+    for(size_t j=0; j<edges.size(); ++j) {
+        byteLabeledCellgrid_.above(edges[j], cells);
+        CellVector markedFaces;
+        for(size_t k=0; k<cells.size(); ++k) {
+            if(byteLabeledCellgrid_.isMarked(cells[k])) {
+                markedFaces.push_back(cells[k]);
+            }
+        }
+        if(markedFaces.size() <= 2) {
+            removedEdges.push_back(edges[j]);
+            if(markedFaces.size() == 2) {
+                Label roots[2];
+                for(size_t k=0; k<2; ++k) {
+                    roots[k] = atCell(markedFaces[k], lease.workspace());
+                    parents.insert(std::make_pair(roots[k], roots[k]));
+                    while(parents[roots[k]] != roots[k]) {
+                        roots[k] = parents[roots[k]];
                     }
+                }
+                parents[std::max(roots[0], roots[1])] = std::min(roots[0], roots[1]);
+            }
+        }
+    }
 
-                    const Label anchorLabel = anchorage_.anchor(cell);
-                    if(anchorLabel == 0) {
-                        assert(cell.order() != 0);
-                        if(redundantAnchors_) {
-                            assert(cell.order() != 1);
-                        }
+    // 1-cells that contain an edge at a 0-cell of these edges. only they
+    // can change.
+    std::vector<CellType> vertices;
+    for(size_t j=0; j<edges.size(); ++j) {
+        byteLabeledCellgrid_.below(edges[j], cells);
+        vertices.insert(vertices.end(), cells.begin(), cells.end());
+    }
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    std::set<CellType> oldEdges;
+    for(size_t j=0; j<vertices.size(); ++j) {
+        byteLabeledCellgrid_.above(vertices[j], cells);
+        for(size_t k=0; k<cells.size(); ++k) {
+            if(byteLabeledCellgrid_.isMarked(cells[k]) && oldEdges.count(cells[k]) == 0) {
+                Label label = 0;
+                detail::traverseComponent(byteLabeledCellgrid_, cells[k], [&](const CellType& c) {
+                    oldEdges.insert(c);
+                    if(label == 0 && byteLabeledCellgrid_.isAnchored(c)) {
+                        label = anchorage_.anchor(c);
                     }
-                    else {
-                        assert(anchorLabel == label);
+                    return true;
+                }, lease.workspace());
+                assert(label != 0);
+                removedLabels[1].push_back(label);
+            }
+        }
+    }
+
+    // unmark 1-cells, remove all anchors of the 1-cells that can change, and
+    // mark or unmark 0-cells
+    for(size_t j=0; j<removedEdges.size(); ++j) {
+        byteLabeledCellgrid_.mark(removedEdges[j], false);
+    }
+    for(typename std::set<CellType>::const_iterator it = oldEdges.begin(); it != oldEdges.end(); ++it) {
+        anchorage_.erase(*it);
+    }
+    std::vector<CellType> addedVertices;
+    for(size_t j=0; j<vertices.size(); ++j) {
+        byteLabeledCellgrid_.above(vertices[j], cells);
+        unsigned char marked = 0;
+        for(size_t k=0; k<cells.size(); ++k) {
+            if(byteLabeledCellgrid_.isMarked(cells[k])) {
+                ++marked;
+            }
+        }
+        const bool isZeroCell = marked > 2 || marked == 1; // as in markSlices
+        if(byteLabeledCellgrid_.isMarked(vertices[j]) && !isZeroCell) {
+            removedLabels[0].push_back(anchorage_.anchor(vertices[j]));
+            byteLabeledCellgrid_.mark(vertices[j], false);
+            anchorage_.erase(vertices[j]);
+        }
+        else if(!byteLabeledCellgrid_.isMarked(vertices[j]) && isZeroCell) {
+            byteLabeledCellgrid_.mark(vertices[j], true);
+            addedVertices.push_back(vertices[j]);
+        }
+    }
+
+    // merge and remove labels. cells are merged before labels are erased
+    // because erasing a label changes the label of the last cell.
+    for(size_t j=0; j<removedLabels[1].size(); ++j) {
+        cwcomplex_.isolate(1, removedLabels[1][j]);
+    }
+    for(size_t j=0; j<removedLabels[2].size(); ++j) {
+        cwcomplex_.isolate(2, removedLabels[2][j]);
+    }
+    cwcomplex_.merge(3, label1, label0);
+    anchorage_.merge(3, label1, label0);
+    std::vector<Label> changedLabels[4]; // labels of components whose cells are labeled anew in the label cache
+    for(typename std::map<Label, Label>::const_iterator it = parents.begin(); it != parents.end(); ++it) {
+        Label root = it->second;
+        while(parents[root] != root) {
+            root = parents[root];
+        }
+        if(root != it->first) {
+            cwcomplex_.merge(2, it->first, root);
+            anchorage_.merge(2, it->first, root);
+            removedLabels[2].push_back(it->first);
+            changedLabels[2].push_back(root);
+        }
+    }
+    const Label mergedLabel = label0 == numberOfCells(3) ? label1 : label0;
+    for(Order order = 0; order < 4; ++order) {
+        std::sort(removedLabels[order].rbegin(), removedLabels[order].rend());
+        for(size_t j=0; j<removedLabels[order].size(); ++j) {
+            cwcomplex_.erase(order, removedLabels[order][j]);
+            anchorage_.erase(order, removedLabels[order][j]);
+        }
+    }
+
+    // update the label cache. removed 1- and 2-cells and those 1-cells that
+    // are labeled anew below are dropped. components that have taken the
+    // label of another component or have been merged are labeled anew: the
+    // merged 3-cell and the 2-cells into which 2-cells have been merged, and
+    // the last cells of an order that have taken removed labels.
+    if(!labelCache_.empty()) {
+        if(labelCache_.hasBoundaryCells()) {
+            for(size_t j=0; j<faces.size(); ++j) {
+                labelCache_.erase(faces[j]);
+            }
+            for(typename std::set<CellType>::const_iterator it = oldEdges.begin(); it != oldEdges.end(); ++it) {
+                labelCache_.erase(*it);
+            }
+        }
+        changedLabels[3].push_back(mergedLabel);
+        for(Order order = 1; order < 4; ++order) {
+            changedLabels[order].insert(changedLabels[order].end(), removedLabels[order].begin(), removedLabels[order].end());
+            std::sort(changedLabels[order].begin(), changedLabels[order].end());
+            changedLabels[order].erase(std::unique(changedLabels[order].begin(), changedLabels[order].end()), changedLabels[order].end());
+            for(size_t j=0; j<changedLabels[order].size() && changedLabels[order][j] <= numberOfCells(order); ++j) {
+                cacheLabels(order, changedLabels[order][j], lease.workspace());
+            }
+        }
+    }
+
+    // label new 0-cells and all 1-cells that can have changed
+    for(size_t j=0; j<addedVertices.size(); ++j) {
+        cwcomplex_.push_back(0);
+        anchorage_.push_back(addedVertices[j]);
+        byteLabeledCellgrid_.anchor(addedVertices[j], true);
+    }
+    std::vector<std::pair<Label, Label> > pairs[2];
+    CellVector cellsAbove;
+    CellVector cellsBelow;
+    std::set<CellType> newEdges;
+    for(typename std::set<CellType>::const_iterator it = oldEdges.begin(); it != oldEdges.end(); ++it) {
+        if(byteLabeledCellgrid_.isMarked(*it) && newEdges.count(*it) == 0) {
+            const Label label = cwcomplex_.push_back(1);
+            byteLabeledCellgrid_.anchor(*it, true);
+            const Label sameLabel = anchorage_.push_back(*it);
+            assert(label == sameLabel);
+            detail::traverseComponent(byteLabeledCellgrid_, *it, [&](const CellType& c) {
+                newEdges.insert(c);
+                if(!labelCache_.empty() && labelCache_.hasBoundaryCells()) {
+                    labelCache_.insert(c, label);
+                }
+                if(redundantAnchors_ && c != *it) {
+                    byteLabeledCellgrid_.anchor(c, true);
+                    anchorage_.anchor(c, label);
+                }
+                byteLabeledCellgrid_.below(c, cellsBelow);
+                for(size_t k=0; k<cellsBelow.size(); ++k) {
+                    if(byteLabeledCellgrid_.isMarked(cellsBelow[k])) {
+                        pairs[0].push_back(std::make_pair(anchorage_.anchor(cellsBelow[k]), label));
                     }
                 }
-                else {
-                    if(cell.order() != 3) {
-                        assert(anchorage_.anchor(cell) == 0);
+                byteLabeledCellgrid_.above(c, cellsAbove);
+                for(size_t k=0; k<cellsAbove.size(); ++k) {
+                    if(byteLabeledCellgrid_.isMarked(cellsAbove[k])) {
+                        pairs[1].push_back(std::make_pair(label, atCell(cellsAbove[k])));
                     }
                 }
-            }
+                return true;
+            }, lease.workspace());
         }
     }
+    for(Order order = 0; order < 2; ++order) {
+        std::sort(pairs[order].begin(), pairs[order].end());
+        pairs[order].erase(std::unique(pairs[order].begin(), pairs[order].end()), pairs[order].end());
+        cwcomplex_.connectPairs(order, pairs[order].begin(), pairs[order].end());
+    }
+    return mergedLabel;
+}
+
+// updates the complex after the labels of a box of voxels have changed.
+// labels is the block of the segmentation whose first voxel is at offset.
+// it consists of the changed box and a margin of one voxel at each side of
+// the box that is not at the border of the volume. the margin is not
+// changed. it determines the 2-cells at the border of the box.
+// cells in the box and a margin of one cell are marked anew, and only the
+// components of cells that contain a cell in the box or next to it are
+// labeled anew. the cost is proportional to the volume of the box, to the
+// size of these components of 1- and 2-cells and to the size of those
+// pieces of 3-cells that are disconnected from the larger part of their
+// 3-cell by the change, not to the size of the volume.
+// other components keep their labels, except that labels are kept
+// contiguous: if the number of cells of an order decreases, the last cells
+// of this order take the free labels. a label cache is updated for the
+// cells of the components labeled anew. components that take another label
+// or are merged without being traced completely are labeled anew in the
+// cache by a traversal.
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+void
+CWX<T,C,LAYOUT>::update(
+    const std::array<Coordinate, 3>& offset,
+    const andres::View<U, B>& labels
+)
+{
+    if(labels.dimension() != 3) {
+        throw std::runtime_error("labels must be 3-dimensional.");
+    }
+    std::array<Coordinate, 3> begin;
+    std::array<Coordinate, 3> end;
+    for(size_t d = 0; d < 3; ++d) {
+        const size_t blockEnd = static_cast<size_t>(offset[d]) + labels.shape(d);
+        if(blockEnd > shape(d)) {
+            throw std::runtime_error("labels exceed the volume.");
+        }
+        const size_t boxBegin = offset[d] == 0 ? 0 : static_cast<size_t>(offset[d]) + 1;
+        const size_t boxEnd = blockEnd == shape(d) ? blockEnd : blockEnd - 1;
+        if(labels.shape(d) == 0 || boxBegin >= boxEnd) {
+            return; // labels of the margin only
+        }
+        begin[d] = static_cast<Coordinate>(boxBegin);
+        end[d] = static_cast<Coordinate>(boxEnd);
+    }
+    detail::Updater<T, C, LAYOUT> updater(*this, begin, end);
+    updater(offset, labels);
+}
+
+// asserts that the CW-complex, the anchors and the cell grid are
+// consistent. called at the end of build. does nothing if NDEBUG is defined.
+template<class T, class C, class LAYOUT>
+inline void
+CWX<T,C,LAYOUT>::testInvariant() const
+{
+#   ifndef NDEBUG
+    for(Order order = 0; order < 4; ++order) {
+        assert(cwcomplex_.numberOfCells(order) == anchorage_.numberOfCells(order));
+    }
+
+    CellType cell;
+    CellVector above;
+
+    for(Order order = 0; order < 4; ++order) {
+        byteLabeledCellgrid_.forEachCell(order, [&](const CellType& cell) {
+            if(byteLabeledCellgrid_.isMarked(cell)) {
+                const Label label = atCell(cell);
+                assert(label != 0);
+
+                std::set<Label> labelsAbove;
+                byteLabeledCellgrid_.above(cell, above);
+                for(size_t j=0; j<above.size(); ++j) {
+                    const Label labelAbove = atCell(above[j]);
+                    if(labelAbove != 0) {
+                        labelsAbove.insert(labelAbove);
+                    }
+                }
+                assert(labelsAbove.size() == sizeAbove(cell.order(), label));
+                typename std::set<Label>::const_iterator it = labelsAbove.begin();
+                for(size_t j=0; j<labelsAbove.size(); ++j, ++it) {
+                    assert((CWX<T, C, LAYOUT>::above(cell.order(), label, j)) == *it);
+                }
+
+                const Label anchorLabel = anchorage_.anchor(cell);
+                if(anchorLabel == 0) {
+                    assert(cell.order() != 0);
+                    if(redundantAnchors_) {
+                        assert(cell.order() != 1);
+                    }
+                }
+                else {
+                    assert(anchorLabel == label);
+                }
+            }
+            else {
+                if(cell.order() != 3) {
+                    assert(anchorage_.anchor(cell) == 0);
+                }
+            }
+            return true;
+        });
+    }
 
     for(Order order = 0; order < 4; ++order) {
         for(Label label = 1; label <= numberOfCells(order); ++label) {
@@ -812,11 +1851,13 @@ CWX<T,C>::testInvariant() const
 #   endif
 }
 
-template<class T, class C>
+// labels of all cells
+template<class T, class C, class LAYOUT>
 template<class U>
 inline void
-CWX<T,C>::labeledCellGrid(
-    andres::Marray<U>& out
+CWX<T,C,LAYOUT>::labeledCellGrid(
+    andres::Marray<U>& out,
+    const size_t numberOfThreads
 ) const
 {
     const size_t arrayShape[] = {
@@ -825,138 +1866,170 @@ CWX<T,C>::labeledCellGrid(
         2 * shape(2) - 1
     };
     out.resize(arrayShape, arrayShape + 3);
-    labeledCellGrid(static_cast<andres::View<U>&>(out));
+    labeledCellGrid(static_cast<andres::View<U>&>(out), numberOfThreads);
 }
 
-template<class T, class C>
+// labels of all cells. cells that are not marked are labeled 0.
+template<class T, class C, class LAYOUT>
 template<class U>
 void
-CWX<T,C>::labeledCellGrid(
-    andres::View<U>& out
+CWX<T,C,LAYOUT>::labeledCellGrid(
+    andres::View<U>& out,
+    const size_t numberOfThreads
 ) const
 {
-    assert(out.dimension() == 3);
-    assert(out.shape(0) == shape(0) * 2 - 1);
-    assert(out.shape(1) == shape(0) * 2 - 1);
-    assert(out.shape(2) == shape(0) * 2 - 1);
-    detail::ExportLabeler<Label, Coordinate, U> exportLabeler(*this, out);
-    for(Order order = 0; order <= 3; ++order) {
-        for(Label label = 1; label <= numberOfCells(order); ++label) {
-            exportLabeler.setLabel(label);
-            process(order, label, exportLabeler);
-        }
-    }
+    detail::GridExporter<T, C, LAYOUT>(*this, numberOfThreads).labeledCellGrid(out);
 }
 
-template<class T, class C>
+// labels of all cells in the slice x_d = v (cell coordinates). the
+// dimensions of the output are the remaining dimensions in ascending order.
+template<class T, class C, class LAYOUT>
 template<class U>
-void
-CWX<T,C>::labeledCellSlice(
+inline void
+CWX<T,C,LAYOUT>::labeledCellSlice(
     const Order d,
     const Coordinate v,
     andres::Marray<U>& out
 ) const
 {
-    // TODO: implement
+    assert(d < 3);
+    const Order d0 = d == 0 ? 1 : 0;
+    const Order d1 = d == 2 ? 1 : 2;
+    const size_t arrayShape[] = {
+        2 * shape(d0) - 1,
+        2 * shape(d1) - 1
+    };
+    out.resize(arrayShape, arrayShape + 2);
+    labeledCellSlice(d, v, static_cast<andres::View<U>&>(out));
 }
 
-template<class T, class C>
+// labels of all cells in the slice x_d = v (cell coordinates). components
+// are traced within the slice and labeled by an anchor they contain in the
+// slice. only components without such an anchor are labeled by a search in
+// the volume (or a lookup in the label cache). with redundant anchors, the
+// memory and time are proportional to the area of the slice.
+template<class T, class C, class LAYOUT>
 template<class U>
 void
-CWX<T,C>::labeledCellSlice(
+CWX<T,C,LAYOUT>::labeledCellSlice(
     const Order d,
     const Coordinate v,
     andres::View<U>& out
 ) const
 {
-    // TODO: implement
+    assert(d < 3);
+    assert(v < 2 * shape(d) - 1);
+    const Order d0 = d == 0 ? 1 : 0;
+    const Order d1 = d == 2 ? 1 : 2;
+    assert(out.dimension() == 2);
+    assert(out.shape(0) == shape(d0) * 2 - 1);
+    assert(out.shape(1) == shape(d1) * 2 - 1);
+    for(size_t j = 0; j < out.shape(1); ++j)
+    for(size_t k = 0; k < out.shape(0); ++k) {
+        out(k, j) = U();
+    }
+    byteLabeledCellgrid_.forEachCell(0, d, v, [&](const CellType& cell) {
+        if(byteLabeledCellgrid_.isMarked(cell)) {
+            out(cell[d0], cell[d1]) = anchorage_.anchor(cell);
+        }
+        return true;
+    });
+    detail::WorkspaceLease<Coordinate> sliceLease;
+    detail::WorkspaceLease<Coordinate> labelLease;
+    detail::ExportSliceLabeler<Label, Coordinate, LAYOUT, U> exportSliceLabeler(*this, out, d, false, labelLease.workspace());
+    for(Order order = 1; order <= 3; ++order) {
+        process(order, d, v, exportSliceLabeler, sliceLease.workspace());
+    }
 }
 
-template<class T, class C>
+// labels of all voxels
+template<class T, class C, class LAYOUT>
 template<class U>
 inline void
-CWX<T,C>::labeledVoxelGrid(
-    andres::Marray<U>& out
+CWX<T,C,LAYOUT>::labeledVoxelGrid(
+    andres::Marray<U>& out,
+    const size_t numberOfThreads
 ) const
 {
     const size_t arrayShape[] = {shape(0), shape(1), shape(2)};
     out.resize(arrayShape, arrayShape + 3);
-    labeledVoxelGrid(static_cast<andres::View<U>&>(out));
+    labeledVoxelGrid(static_cast<andres::View<U>&>(out), numberOfThreads);
 }
 
-template<class T, class C>
+// labels of all voxels
+template<class T, class C, class LAYOUT>
 template<class U>
 void
-CWX<T,C>::labeledVoxelGrid(
-    andres::View<U>& out
+CWX<T,C,LAYOUT>::labeledVoxelGrid(
+    andres::View<U>& out,
+    const size_t numberOfThreads
 ) const
 {
-    assert(out.dimension() == 3);
-    assert(out.shape(0) == shape(0));
-    assert(out.shape(1) == shape(0));
-    assert(out.shape(2) == shape(0));
-    detail::ExportVoxelLabeler<Label, Coordinate, U> exportVoxelLabeler(*this, out);
-    for(Label label = 1; label <= numberOfCells(3); ++label) {
-        exportVoxelLabeler.setLabel(label);
-        process(3, label, exportVoxelLabeler);
-    }
+    detail::GridExporter<T, C, LAYOUT>(*this, numberOfThreads).labeledVoxelGrid(out);
 }
 
-namespace detail {
-
-template<class T, class C>
-inline
-Labeler<T, C>::Labeler(
-    CWXType& cwx,
-    const Order order
-)
-:   cwx_(cwx),
-    order_(order)
+// labels of all voxels in the slice x_d = v (voxel coordinates). the
+// dimensions of the output are the remaining dimensions in ascending order.
+template<class T, class C, class LAYOUT>
+template<class U>
+inline void
+CWX<T,C,LAYOUT>::labeledVoxelSlice(
+    const Order d,
+    const Coordinate v,
+    andres::Marray<U>& out
+) const
 {
-    assert(order != 0); // this labeler is not suitable for 0-cells
+    assert(d < 3);
+    const Order d0 = d == 0 ? 1 : 0;
+    const Order d1 = d == 2 ? 1 : 2;
+    const size_t arrayShape[] = {shape(d0), shape(d1)};
+    out.resize(arrayShape, arrayShape + 2);
+    labeledVoxelSlice(d, v, static_cast<andres::View<U>&>(out));
 }
 
-template<class T, class C>
-inline bool
-Labeler<T, C>::preprocess(
-    const CellType& cell
-)
+// labels of all voxels in the slice x_d = v (voxel coordinates), cf.
+// labeledCellSlice
+template<class T, class C, class LAYOUT>
+template<class U>
+void
+CWX<T,C,LAYOUT>::labeledVoxelSlice(
+    const Order d,
+    const Coordinate v,
+    andres::View<U>& out
+) const
 {
-    assert(cell.order() == order_);
-    label_ = cwx_.cwcomplex_.push_back(order_);
-    cwx_.connect(cell, label_);
-    cwx_.byteLabeledCellgrid_.anchor(cell, true);
-    const Label sameLabel = cwx_.anchorage_.push_back(cell);
-    assert(label_ == sameLabel);
-    return true;
+    assert(d < 3);
+    assert(v < shape(d));
+    assert(out.dimension() == 2);
+    assert(out.shape(0) == shape(d == 0 ? 1 : 0));
+    assert(out.shape(1) == shape(d == 2 ? 1 : 2));
+    detail::WorkspaceLease<Coordinate> sliceLease;
+    detail::WorkspaceLease<Coordinate> labelLease;
+    detail::ExportSliceLabeler<Label, Coordinate, LAYOUT, U> exportSliceLabeler(*this, out, d, true, labelLease.workspace());
+    process(3, d, 2 * v, exportSliceLabeler, sliceLease.workspace());
 }
 
-template<class T, class C>
-inline bool
-Labeler<T, C>::operator()(
-    const CellType& cell
-)
+// accumulates features of all cells of all orders, with one sweep over the
+// cell grid per order, in parallel. features[order][label] is the
+// accumulator of the cell of the given order and label. features[order][0]
+// has accumulated nothing. accumulators are defined in cwx/accumulators.hxx.
+// the memory required is that of one accumulator per cell and thread.
+template<class T, class C, class LAYOUT>
+template<class ACCUMULATOR>
+void
+CWX<T,C,LAYOUT>::accumulate(
+    std::array<std::vector<ACCUMULATOR>, 4>& features,
+    const size_t numberOfThreads
+) const
 {
-    assert(cell.order() == order_);
-    if(cwx_.redundantAnchors_ && order_ == 1) {
-        // every 1-cell of a connected component of 1-cells becomes an anchor
-        cwx_.byteLabeledCellgrid_.anchor(cell, true);
-        cwx_.anchorage_.anchor(cell, label_);
-        // TODO: collect surrounding 2-cell labels at this anchor
-    }
-    return true;
+    detail::GridExporter<T, C, LAYOUT>(*this, numberOfThreads).accumulate(features);
 }
 
-template<class T, class C>
-inline bool
-Labeler<T, C>::postprocess()
-{
-    return true;
-}
+namespace detail {
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline
-Anchorer<T, C>::Anchorer(
+Anchorer<T, C, LAYOUT>::Anchorer(
     CWXType& cwx
 )
 :   cwx_(cwx),
@@ -965,9 +2038,9 @@ Anchorer<T, C>::Anchorer(
     anchorFound_(false)
 {}
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-Anchorer<T, C>::preprocess(
+Anchorer<T, C, LAYOUT>::preprocess(
     const CellType& cell
 )
 {
@@ -977,9 +2050,9 @@ Anchorer<T, C>::preprocess(
     return true;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-Anchorer<T, C>::operator()(
+Anchorer<T, C, LAYOUT>::operator()(
     const CellType& cell
 )
 {
@@ -999,9 +2072,9 @@ Anchorer<T, C>::operator()(
     return true;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-Anchorer<T, C>::postprocess()
+Anchorer<T, C, LAYOUT>::postprocess()
 {
     // add anchor if necessary
     if(label_ == 0) { // if no labeled anchor exists in this slice
@@ -1032,18 +2105,18 @@ Anchorer<T, C>::postprocess()
     return true;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline
-AnchorTester<T, C>::AnchorTester(
+AnchorTester<T, C, LAYOUT>::AnchorTester(
     const CWXType& cwx
 )
 :   cwx_(cwx),
     labeledAnchorFound_(false)
 {}
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-AnchorTester<T, C>::preprocess(
+AnchorTester<T, C, LAYOUT>::preprocess(
     const CellType& cell
 )
 {
@@ -1051,9 +2124,9 @@ AnchorTester<T, C>::preprocess(
     return true;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-AnchorTester<T, C>::operator()(
+AnchorTester<T, C, LAYOUT>::operator()(
     const CellType& cell
 )
 {
@@ -1063,87 +2136,1062 @@ AnchorTester<T, C>::operator()(
     return true;
 }
 
-template<class T, class C>
+template<class T, class C, class LAYOUT>
 inline bool
-AnchorTester<T, C>::postprocess()
+AnchorTester<T, C, LAYOUT>::postprocess()
 {
     assert(labeledAnchorFound_);
     return true;
 }
 
-template<class T, class C, class U>
-inline 
-ExportLabeler<T, C, U>::ExportLabeler(
-    const CWXType& cwx, 
-    ViewType& view
+template<class T, class C, class LAYOUT>
+inline
+GridExporter<T, C, LAYOUT>::GridExporter(
+    const CWXType& cwx,
+    const size_t numberOfThreads
+)
+:   cwx_(cwx),
+    slabs_(cwx.shape(2), numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads)
+{}
+
+template<class T, class C, class LAYOUT>
+template<class U>
+void
+GridExporter<T, C, LAYOUT>::labeledCellGrid(
+    andres::View<U>& out
+) const
+{
+    assert(out.dimension() == 3);
+    assert(out.shape(0) == cwx_.shape(0) * 2 - 1);
+    assert(out.shape(1) == cwx_.shape(1) * 2 - 1);
+    assert(out.shape(2) == cwx_.shape(2) * 2 - 1);
+    for(Order order = 0; order <= 3; ++order) {
+        sweep(order, [&](const CellType& cell, const Label label, const size_t) {
+            out(cell[0], cell[1], cell[2]) = label;
+        });
+    }
+}
+
+template<class T, class C, class LAYOUT>
+template<class U>
+void
+GridExporter<T, C, LAYOUT>::labeledVoxelGrid(
+    andres::View<U>& out
+) const
+{
+    assert(out.dimension() == 3);
+    assert(out.shape(0) == cwx_.shape(0));
+    assert(out.shape(1) == cwx_.shape(1));
+    assert(out.shape(2) == cwx_.shape(2));
+    sweep(3, [&](const CellType& cell, const Label label, const size_t) {
+        out(cell[0] / 2, cell[1] / 2, cell[2] / 2) = label;
+    });
+}
+
+// accumulates the cells of each slab separately and merges the
+// accumulators of the slabs afterwards
+template<class T, class C, class LAYOUT>
+template<class ACCUMULATOR>
+void
+GridExporter<T, C, LAYOUT>::accumulate(
+    std::array<std::vector<ACCUMULATOR>, 4>& features
+) const
+{
+    for(Order order = 0; order <= 3; ++order) {
+        const size_t numberOfLabels = static_cast<size_t>(cwx_.numberOfCells(order)) + 1;
+        std::vector<std::vector<ACCUMULATOR> > slabFeatures(slabs_.numberOfSlabs(), std::vector<ACCUMULATOR>(numberOfLabels));
+        sweep(order, [&](const CellType& cell, const Label label, const size_t slab) {
+            if(label != 0) {
+                slabFeatures[slab][label](cell);
+            }
+        });
+        features[order].assign(numberOfLabels, ACCUMULATOR());
+        parallelFor(slabs_.numberOfSlabs(), [&](const size_t j) {
+            const size_t begin = numberOfLabels * j / slabs_.numberOfSlabs();
+            const size_t end = numberOfLabels * (j + 1) / slabs_.numberOfSlabs();
+            for(size_t label = begin; label < end; ++label) {
+                for(size_t k = 0; k < slabFeatures.size(); ++k) {
+                    features[order][label].merge(slabFeatures[k][label]);
+                }
+            }
+        });
+    }
+}
+
+// calls writer(cell, label, slab) exactly once for every cell of the given
+// order. calls for cells in different slabs are made from different threads.
+template<class T, class C, class LAYOUT>
+template<class WRITER>
+void
+GridExporter<T, C, LAYOUT>::sweep(
+    const Order order,
+    WRITER writer
+) const
+{
+    const ByteLabeledCellgridType& grid = cwx_.byteLabeledCellgrid_;
+    if(order == 0) {
+        parallelFor(slabs_.numberOfSlabs(), [&](const size_t j) {
+            grid.forEachCellInSlab(0, begin2(j), end2(j), [&](const CellType& cell) {
+                writer(cell, grid.isMarked(cell) ? cwx_.anchorage_.anchor(cell) : Label(), j);
+                return true;
+            });
+        });
+        return;
+    }
+
+    // labels of the components in the CWX
+    typedef ComponentLabeling<Label, Coordinate, LAYOUT> ComponentLabelingType;
+    ComponentLabelingType labeling(grid, order, slabs_.numberOfSlabs());
+    const size_t numberOfComponents = labeling.numberOfComponents();
+    std::vector<Label> labels(numberOfComponents + 1, 0);
+    parallelFor(slabs_.numberOfSlabs(), [&](const size_t j) {
+        WorkspaceLease<Coordinate> lease;
+        const size_t begin = 1 + numberOfComponents * j / slabs_.numberOfSlabs();
+        const size_t end = 1 + numberOfComponents * (j + 1) / slabs_.numberOfSlabs();
+        for(size_t label = begin; label < end; ++label) {
+            labels[label] = cwx_.atCell(labeling.firstCell(static_cast<Label>(label)), lease.workspace());
+        }
+    });
+    labeling.clearFirstCells();
+
+    // write the labels of the cells slice by slice
+    parallelFor(slabs_.numberOfSlabs(), [&](const size_t j) {
+        std::vector<typename ComponentLabelingType::Index> buffer;
+        typename ComponentLabelingType::Slice slice(labeling);
+        for(size_t z = slabs_.begin(j); z < slabs_.end(j); ++z) {
+            slice.assign(static_cast<Coordinate>(z), buffer);
+            slice.forEachCell([&](const CellType& cell, const Label label) {
+                writer(cell, labels[label], j);
+            });
+        }
+    });
+}
+
+// the cells of slab j are those with begin2(j) <= cell[2] < end2(j), i.e.
+// the cells of its voxels
+template<class T, class C, class LAYOUT>
+inline typename GridExporter<T, C, LAYOUT>::Coordinate
+GridExporter<T, C, LAYOUT>::begin2(
+    const size_t j
+) const
+{
+    return static_cast<Coordinate>(2 * slabs_.begin(j));
+}
+
+template<class T, class C, class LAYOUT>
+inline typename GridExporter<T, C, LAYOUT>::Coordinate
+GridExporter<T, C, LAYOUT>::end2(
+    const size_t j
+) const
+{
+    return static_cast<Coordinate>(std::min<size_t>(2 * slabs_.end(j), 2 * cwx_.shape(2) - 1));
+}
+
+template<class T, class C, class LAYOUT, class U>
+inline
+ExportSliceLabeler<T, C, LAYOUT, U>::ExportSliceLabeler(
+    const CWXType& cwx,
+    ViewType& view,
+    const Order d,
+    const bool voxels,
+    TraversalWorkspaceType& workspace
 )
 :   cwx_(cwx),
     view_(view),
-    label_(ExportLabel())
+    d0_(d == 0 ? 1 : 0),
+    d1_(d == 2 ? 1 : 2),
+    divisor_(voxels ? 2 : 1),
+    workspace_(workspace),
+    cells_(),
+    label_(0)
 {
-    assert(view.dimension() == 3);
-    assert(view.shape(0) == cwx.shape(0) * 2 - 1);
-    assert(view.shape(1) == cwx.shape(1) * 2 - 1);
-    assert(view.shape(2) == cwx.shape(2) * 2 - 1);
+    assert(d < 3);
+    assert(view.dimension() == 2);
 }
 
-template<class T, class C, class U>
-inline void
-ExportLabeler<T, C, U>::setLabel(
-    const ExportLabel label
+template<class T, class C, class LAYOUT, class U>
+inline bool
+ExportSliceLabeler<T, C, LAYOUT, U>::preprocess(
+    const CellType& cell
 ) {
-    label_ = label;
+    cells_.clear();
+    label_ = 0;
+    return true;
 }
 
-template<class T, class C, class U>
+// buffers the cell and takes the label from its anchor, if any
+template<class T, class C, class LAYOUT, class U>
 inline bool
-ExportLabeler<T, C, U>::operator()(
+ExportSliceLabeler<T, C, LAYOUT, U>::operator()(
     const CellType& cell
 ) {
-    assert(cell[0] < view_.shape(0));
-    assert(cell[1] < view_.shape(1));
-    assert(cell[2] < view_.shape(2));
-    view_(cell[0], cell[1], cell[2]) = label_;
+    assert(cell[d0_] / divisor_ < view_.shape(0));
+    assert(cell[d1_] / divisor_ < view_.shape(1));
+    cells_.push_back(cell);
+    if(label_ == 0 && cwx_.byteLabeledCellgrid_.isAnchored(cell)) {
+        label_ = cwx_.anchorage_.anchor(cell); // 0 if the anchor has no label for this cell
+    }
     return true;
 }
 
-template<class T, class C, class U>
-inline 
-ExportVoxelLabeler<T, C, U>::ExportVoxelLabeler(
-    const CWXType& cwx, 
-    ViewType& view
+// looks up the label of a component without an anchor in the slice once,
+// at its first cell in the slice
+template<class T, class C, class LAYOUT, class U>
+inline bool
+ExportSliceLabeler<T, C, LAYOUT, U>::postprocess() {
+    if(label_ == 0) {
+        label_ = cwx_.atCell(cells_.front(), workspace_);
+    }
+    for(size_t j = 0; j < cells_.size(); ++j) {
+        view_(cells_[j][d0_] / divisor_, cells_[j][d1_] / divisor_) = static_cast<ExportLabel>(label_);
+    }
+    return true;
+}
+
+template<class T, class C, class LAYOUT>
+inline
+Updater<T, C, LAYOUT>::Component::Component()
+:   first(),
+    cells(),
+    oldLabels(),
+    keptLabels(),
+    label(0)
+{}
+
+// begin and end delimit the box of changed voxels
+template<class T, class C, class LAYOUT>
+inline
+Updater<T, C, LAYOUT>::Updater(
+    CWXType& cwx,
+    const std::array<Coordinate, 3>& begin,
+    const std::array<Coordinate, 3>& end
 )
 :   cwx_(cwx),
-    view_(view),
-    label_(ExportLabel())
+    grid_(cwx.byteLabeledCellgrid_)
 {
-    assert(view.dimension() == 3);
-    assert(view.shape(0) == cwx.shape(0));
-    assert(view.shape(1) == cwx.shape(1));
-    assert(view.shape(2) == cwx.shape(2));
+    for(size_t d = 0; d < 3; ++d) {
+        assert(begin[d] < end[d] && end[d] <= cwx.shape(d));
+        const Coordinate last = 2 * cwx.shape(d) - 2;
+        boxBegin_[d] = begin[d] == 0 ? 0 : 2 * begin[d] - 1;
+        boxEnd_[d] = std::min<Coordinate>(2 * end[d] - 1, last);
+        windowBegin_[d] = boxBegin_[d] == 0 ? 0 : boxBegin_[d] - 1;
+        windowEnd_[d] = std::min<Coordinate>(boxEnd_[d] + 1, last);
+    }
 }
 
-template<class T, class C, class U>
-inline void
-ExportVoxelLabeler<T, C, U>::setLabel(
-    const ExportLabel label
-) {
-    label_ = label;
+// offset and labels are those passed to CWX::update
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+void
+Updater<T, C, LAYOUT>::operator()(
+    const std::array<Coordinate, 3>& offset,
+    const andres::View<U, B>& labels
+)
+{
+    // labels before the update
+    for(Order order = 1; order < 3; ++order) {
+        traceOld(order);
+    }
+    labelOldVoxels();
+    std::vector<std::pair<CellType, Label> > oldVertices;
+    forEachCell(0, boxBegin_, boxEnd_, [&](const CellType& cell) {
+        if(grid_.isMarked(cell)) {
+            oldVertices.push_back(std::make_pair(cell, cwx_.anchorage_.anchor(cell)));
+        }
+    });
+
+    mark(offset, labels);
+
+    // components after the update
+    for(Order order = 1; order < 3; ++order) {
+        traceNew(order);
+    }
+    searchVoxels();
+
+    relabel(oldVertices);
+    cacheLabels();
+    connect();
 }
 
-template<class T, class C, class U>
+template<class T, class C, class LAYOUT>
 inline bool
-ExportVoxelLabeler<T, C, U>::operator()(
+Updater<T, C, LAYOUT>::inWindow(
     const CellType& cell
-) {
-    assert(cell.order() == 3);
-    assert(cell[0] / 2 < view_.shape(0));
-    assert(cell[1] / 2 < view_.shape(1));
-    assert(cell[2] / 2 < view_.shape(2));
-    view_(cell[0] / 2, cell[1] / 2, cell[2] / 2) = label_;
+) const
+{
+    for(size_t d = 0; d < 3; ++d) {
+        if(cell[d] < windowBegin_[d] || cell[d] > windowEnd_[d]) {
+            return false;
+        }
+    }
     return true;
 }
 
+// calls functor(cell) for all cells of the given order whose coordinates
+// lie between begin and end, inclusively
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+inline void
+Updater<T, C, LAYOUT>::forEachCell(
+    const Order order,
+    const Coordinate* begin,
+    const Coordinate* end,
+    FUNCTOR functor
+) const
+{
+    CellType cell;
+    for(cell[2] = begin[2]; cell[2] <= end[2]; ++cell[2])
+    for(cell[1] = begin[1]; cell[1] <= end[1]; ++cell[1])
+    for(cell[0] = begin[0]; cell[0] <= end[0]; ++cell[0]) {
+        if(cell.order() == order) {
+            functor(cell);
+        }
+    }
+}
+
+// calls functor(c) for all cells c of the part of a component in the
+// window, or in the intersection of the window with the slice x_d = v if
+// d < 3. the caller begins the traversal of the workspace, such that parts
+// traced from several cells are disjoint.
+template<class T, class C, class LAYOUT>
+template<class FUNCTOR>
+void
+Updater<T, C, LAYOUT>::trace(
+    const CellType& cell,
+    const size_t d,
+    const Coordinate v,
+    FUNCTOR functor,
+    TraversalWorkspaceType& workspace
+) const
+{
+    const Order order = cell.order();
+    CellVector below;
+    CellVector above;
+    workspace.visit(cell);
+    workspace.push(cell);
+    while(!workspace.empty()) {
+        const CellType c = workspace.front();
+        workspace.pop();
+        functor(c);
+        grid_.below(c, below);
+        for(size_t j = 0; j < below.size(); ++j) {
+            if(grid_.isMarked(below[j]) || !inWindow(below[j]) || (d < 3 && below[j][d] != v)) {
+                continue;
+            }
+            grid_.above(below[j], above);
+            for(size_t k = 0; k < above.size(); ++k) {
+                if((order == 3 || grid_.isMarked(above[k])) && inWindow(above[k])
+                && (d == 3 || above[k][d] == v)) {
+                    const PackedCell packed(above[k]);
+                    if(workspace.visit(packed)) {
+                        workspace.push(packed);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// records the labels of all cells of the affected components of the given
+// order (1 or 2), before the update
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::traceOld(
+    const Order order
+)
+{
+    WorkspaceLease<Coordinate> lease;
+    std::vector<CellType> cells;
+    forEachCell(order, windowBegin_, windowEnd_, [&](const CellType& cell) {
+        if(grid_.isMarked(cell) && oldLabels_[order].count(packCell(cell)) == 0) {
+            Label label = 0;
+            cells.clear();
+            traverseComponent(grid_, cell, [&](const CellType& c) {
+                cells.push_back(c);
+                if(label == 0 && grid_.isAnchored(c)) {
+                    label = cwx_.anchorage_.anchor(c);
+                }
+                return true;
+            }, lease.workspace());
+            assert(label != 0);
+            for(size_t j = 0; j < cells.size(); ++j) {
+                oldLabels_[order][packCell(cells[j])] = label;
+            }
+            touchedLabels_[order].push_back(label);
+        }
+    });
+}
+
+// records the labels of the 3-cells in the window before the update, with
+// one label lookup per part of a 3-cell in the window
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::labelOldVoxels()
+{
+    WorkspaceLease<Coordinate> lease;
+    WorkspaceLease<Coordinate> lookupLease;
+    lease.workspace().begin();
+    forEachCell(3, windowBegin_, windowEnd_, [&](const CellType& cell) {
+        if(!lease.workspace().isVisited(cell)) {
+            const Label label = cwx_.atCell(cell, lookupLease.workspace());
+            trace(cell, 3, 0, [&](const CellType& c) {
+                oldLabels_[3][packCell(c)] = label;
+            }, lease.workspace());
+            touchedLabels_[3].push_back(label);
+        }
+    });
+}
+
+// marks the cells of the box anew, by the rules of CWX::markSlices
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+void
+Updater<T, C, LAYOUT>::mark(
+    const std::array<Coordinate, 3>& offset,
+    const andres::View<U, B>& labels
+)
+{
+    CellVector cells;
+    forEachCell(2, boxBegin_, boxEnd_, [&](const CellType& cell) {
+        grid_.above(cell, cells);
+        assert(cells.size() == 2);
+        const U label0 = labels(cells[0][0] / 2 - offset[0], cells[0][1] / 2 - offset[1], cells[0][2] / 2 - offset[2]);
+        const U label1 = labels(cells[1][0] / 2 - offset[0], cells[1][1] / 2 - offset[1], cells[1][2] / 2 - offset[2]);
+        grid_.mark(cell, label0 != label1);
+    });
+    auto countMarkedAbove = [&](const CellType& cell) {
+        grid_.above(cell, cells);
+        size_t marked = 0;
+        for(size_t j = 0; j < cells.size(); ++j) {
+            if(grid_.isMarked(cells[j])) {
+                ++marked;
+            }
+        }
+        return marked;
+    };
+    forEachCell(1, boxBegin_, boxEnd_, [&](const CellType& cell) {
+        grid_.mark(cell, countMarkedAbove(cell) > 2);
+    });
+    forEachCell(0, boxBegin_, boxEnd_, [&](const CellType& cell) {
+        const size_t marked = countMarkedAbove(cell);
+        grid_.mark(cell, marked > 2 || marked == 1);
+    });
+}
+
+// traces the affected components of the given order (1 or 2) after the
+// update and counts their cells per old label
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::traceNew(
+    const Order order
+)
+{
+    WorkspaceLease<Coordinate> lease;
+    forEachCell(order, windowBegin_, windowEnd_, [&](const CellType& cell) {
+        if(grid_.isMarked(cell) && componentOf_[order].count(packCell(cell)) == 0) {
+            const size_t index = components_[order].size();
+            components_[order].push_back(Component());
+            Component& component = components_[order].back();
+            component.first = cell;
+            traverseComponent(grid_, cell, [&](const CellType& c) {
+                const Key key = packCell(c);
+                component.cells.push_back(c);
+                componentOf_[order][key] = index;
+                typename std::unordered_map<Key, Label>::const_iterator it = oldLabels_[order].find(key);
+                if(it != oldLabels_[order].end()) {
+                    ++component.oldLabels[it->second];
+                }
+                return true;
+            }, lease.workspace());
+        }
+    });
+}
+
+// finds the affected components of 3-cells after the update, see the class
+// comment
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::searchVoxels()
+{
+    // parts of 3-cells in the window
+    WorkspaceLease<Coordinate> lease;
+    std::vector<CellType> parts; // first 3-cell of every part
+    IndexMap partOf;
+    lease.workspace().begin();
+    forEachCell(3, windowBegin_, windowEnd_, [&](const CellType& cell) {
+        if(!lease.workspace().isVisited(cell)) {
+            trace(cell, 3, 0, [&](const CellType& c) {
+                partOf[packCell(c)] = parts.size();
+            }, lease.workspace());
+            parts.push_back(cell);
+        }
+    });
+
+    // 3-cells outside of the window that are connected to 3-cells in the
+    // window, as pairs (outside, inside), by the old label of the 3-cell
+    std::map<Label, std::vector<std::pair<CellType, CellType> > > seeds;
+    CellVector faces;
+    CellVector cells;
+    forEachCell(3, windowBegin_, windowEnd_, [&](const CellType& cell) {
+        grid_.below(cell, faces);
+        for(size_t j = 0; j < faces.size(); ++j) {
+            if(!grid_.isMarked(faces[j])) {
+                grid_.above(faces[j], cells);
+                for(size_t k = 0; k < cells.size(); ++k) {
+                    if(cells[k] != cell && !inWindow(cells[k])) {
+                        seeds[oldLabels_[3][packCell(cell)]].push_back(std::make_pair(cells[k], cell));
+                    }
+                }
+            }
+        }
+    });
+    for(typename std::map<Label, std::vector<std::pair<CellType, CellType> > >::const_iterator it = seeds.begin(); it != seeds.end(); ++it) {
+        search(it->second, it->first);
+    }
+
+    // components, as a union-find forest of parts and searches
+    std::vector<size_t> parents(parts.size() + searches_.size());
+    for(size_t j = 0; j < parents.size(); ++j) {
+        parents[j] = j;
+    }
+    for(typename std::map<Label, std::vector<std::pair<CellType, CellType> > >::const_iterator it = seeds.begin(); it != seeds.end(); ++it) {
+        for(size_t j = 0; j < it->second.size(); ++j) {
+            const size_t part = find(parents, partOf[packCell(it->second[j].second)]);
+            const size_t search = find(parents, parts.size() + find(searchParents_, searchOf_[packCell(it->second[j].first)]));
+            parents[std::max(part, search)] = std::min(part, search);
+        }
+    }
+    std::vector<size_t> componentOfRoot(parents.size(), parents.size());
+    for(size_t j = 0; j < parts.size(); ++j) {
+        const size_t root = find(parents, j);
+        if(componentOfRoot[root] == parents.size()) {
+            componentOfRoot[root] = components_[3].size();
+            components_[3].push_back(Component());
+            components_[3].back().first = parts[j];
+        }
+    }
+    for(typename IndexMap::const_iterator it = partOf.begin(); it != partOf.end(); ++it) {
+        const size_t index = componentOfRoot[find(parents, it->second)];
+        componentOf_[3][it->first] = index;
+        ++components_[3][index].oldLabels[oldLabels_[3][it->first]];
+    }
+    for(size_t j = 0; j < searches_.size(); ++j) {
+        if(searchParents_[j] != j) {
+            continue;
+        }
+        const size_t index = componentOfRoot[find(parents, parts.size() + j)];
+        assert(index < components_[3].size());
+        Component& component = components_[3][index];
+        const Search& search = searches_[j];
+        for(size_t k = 0; k < search.cells.size(); ++k) {
+            componentOf_[3][packCell(search.cells[k])] = index;
+        }
+        if(search.next == search.queue.size()) {
+            component.cells.insert(component.cells.end(), search.cells.begin(), search.cells.end());
+            component.oldLabels[search.label] += search.cells.size();
+        }
+        else {
+            component.keptLabels.push_back(search.label);
+        }
+    }
+}
+
+// searches the pieces of a 3-cell outside of the window, starting from the
+// given 3-cells at the border of the window, see the class comment
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::search(
+    const std::vector<std::pair<CellType, CellType> >& seeds,
+    const Label label
+)
+{
+    const size_t numberOfStepsPerTurn = 64;
+
+    std::vector<size_t> running;
+    for(size_t j = 0; j < seeds.size(); ++j) {
+        const Key key = packCell(seeds[j].first);
+        if(searchOf_.count(key) == 0) {
+            searchOf_[key] = searches_.size();
+            running.push_back(searches_.size());
+            searchParents_.push_back(searches_.size());
+            searches_.push_back(Search());
+            searches_.back().label = label;
+            searches_.back().cells.push_back(seeds[j].first);
+            searches_.back().queue.push_back(seeds[j].first);
+            searches_.back().next = 0;
+        }
+    }
+    CellVector faces;
+    CellVector cells;
+    while(running.size() > 1) {
+        for(size_t j = 0; j < running.size(); ++j) {
+            size_t s = running[j];
+            for(size_t step = 0; step < numberOfStepsPerTurn && searchParents_[s] == s
+            && searches_[s].next < searches_[s].queue.size(); ++step) {
+                const CellType cell = searches_[s].queue[searches_[s].next];
+                ++searches_[s].next;
+                grid_.below(cell, faces);
+                for(size_t k = 0; k < faces.size(); ++k) {
+                    if(grid_.isMarked(faces[k])) {
+                        continue;
+                    }
+                    grid_.above(faces[k], cells);
+                    for(size_t m = 0; m < cells.size(); ++m) {
+                        if(cells[m] == cell || inWindow(cells[m])) {
+                            continue;
+                        }
+                        const Key key = packCell(cells[m]);
+                        typename IndexMap::const_iterator it = searchOf_.find(key);
+                        if(it == searchOf_.end()) {
+                            searchOf_[key] = s;
+                            searches_[s].cells.push_back(cells[m]);
+                            searches_[s].queue.push_back(cells[m]);
+                        }
+                        else {
+                            const size_t other = find(searchParents_, it->second);
+                            if(other != s) {
+                                s = unite(s, other);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        size_t n = 0;
+        for(size_t j = 0; j < running.size(); ++j) {
+            const size_t s = running[j];
+            if(searchParents_[s] == s && searches_[s].next < searches_[s].queue.size()) {
+                running[n] = s;
+                ++n;
+            }
+        }
+        running.resize(n);
+    }
+}
+
+// unites two searches that have met. returns the united search.
+template<class T, class C, class LAYOUT>
+size_t
+Updater<T, C, LAYOUT>::unite(
+    size_t s,
+    size_t t
+)
+{
+    if(searches_[s].cells.size() < searches_[t].cells.size()) {
+        std::swap(s, t);
+    }
+    Search& search = searches_[s];
+    Search& other = searches_[t];
+    search.cells.insert(search.cells.end(), other.cells.begin(), other.cells.end());
+    search.queue.insert(search.queue.end(), other.queue.begin() + other.next, other.queue.end());
+    std::vector<CellType>().swap(other.cells);
+    std::vector<CellType>().swap(other.queue);
+    other.next = 0;
+    searchParents_[t] = s;
+    return s;
+}
+
+// assigns to the affected components of an order that have no label yet the
+// old label of which they contain most cells, in descending order of these
+// numbers, such that every label is assigned at most once
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::chooseLabels(
+    const Order order
+)
+{
+    std::vector<Component>& components = components_[order];
+    std::set<Label> assigned;
+    std::vector<std::pair<size_t, std::pair<size_t, Label> > > candidates; // (number of cells, (component, label))
+    for(size_t j = 0; j < components.size(); ++j) {
+        if(components[j].label != 0) {
+            assigned.insert(components[j].label);
+            continue;
+        }
+        for(typename std::map<Label, size_t>::const_iterator it = components[j].oldLabels.begin(); it != components[j].oldLabels.end(); ++it) {
+            candidates.push_back(std::make_pair(it->second, std::make_pair(j, it->first)));
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](
+        const std::pair<size_t, std::pair<size_t, Label> >& a,
+        const std::pair<size_t, std::pair<size_t, Label> >& b
+    ) {
+        return a.first > b.first;
+    });
+    for(size_t j = 0; j < candidates.size(); ++j) {
+        Component& component = components[candidates[j].second.first];
+        const Label label = candidates[j].second.second;
+        if(component.label == 0 && assigned.count(label) == 0) {
+            component.label = label;
+            assigned.insert(label);
+        }
+    }
+}
+
+// assigns labels to the affected components and to changed 0-cells and
+// updates the anchors
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::relabel(
+    const std::vector<std::pair<CellType, Label> >& oldVertices
+)
+{
+    typename CWXType::AnchorageType& anchorage = cwx_.anchorage_;
+    typename CWXType::CWComplexType& cwcomplex = cwx_.cwcomplex_;
+
+    // a 3-cell with a piece that is not traced completely keeps its label.
+    // such 3-cells that have become connected are merged.
+    std::vector<std::pair<Label, Label> > merged; // (label, into)
+    for(size_t j = 0; j < components_[3].size(); ++j) {
+        Component& component = components_[3][j];
+        if(!component.keptLabels.empty()) {
+            std::sort(component.keptLabels.begin(), component.keptLabels.end());
+            component.label = component.keptLabels[0];
+            for(size_t k = 1; k < component.keptLabels.size(); ++k) {
+                merged.push_back(std::make_pair(component.keptLabels[k], component.label));
+            }
+        }
+    }
+    for(Order order = 1; order < 4; ++order) {
+        chooseLabels(order);
+    }
+
+    // old labels that are no longer used
+    std::vector<Label> freeLabels[4];
+    for(Order order = 1; order < 4; ++order) {
+        std::vector<Label>& touched = touchedLabels_[order];
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        std::set<Label> assigned;
+        for(size_t j = 0; j < components_[order].size(); ++j) {
+            assigned.insert(components_[order][j].label);
+        }
+        for(size_t j = 0; j < touched.size(); ++j) {
+            if(assigned.count(touched[j]) == 0) {
+                freeLabels[order].push_back(touched[j]);
+            }
+        }
+    }
+
+    // disconnect affected components of 1- and 2-cells. connections of
+    // 3-cells are changed by connect.
+    for(Order order = 1; order < 3; ++order) {
+        for(size_t j = 0; j < touchedLabels_[order].size(); ++j) {
+            cwcomplex.isolate(order, touchedLabels_[order][j]);
+        }
+    }
+
+    // remove the anchors in the window and the anchors of affected
+    // components outside of the window. the latter are inserted again below,
+    // with new labels.
+    std::vector<std::pair<CellType, size_t> > anchors[4]; // (cell, component)
+    for(Order order = 1; order < 4; ++order) {
+        for(size_t j = 0; j < components_[order].size(); ++j) {
+            const std::vector<CellType>& cells = components_[order][j].cells;
+            for(size_t k = 0; k < cells.size(); ++k) {
+                if(!inWindow(cells[k]) && grid_.isAnchored(cells[k]) && anchorage.anchor(cells[k]) != 0) {
+                    anchors[order].push_back(std::make_pair(cells[k], j));
+                }
+            }
+        }
+        for(size_t j = 0; j < anchors[order].size(); ++j) {
+            anchorage.erase(anchors[order][j].first);
+        }
+        forEachCell(order, windowBegin_, windowEnd_, [&](const CellType& cell) {
+            anchorage.erase(cell);
+        });
+    }
+
+    // merge 3-cells, reuse free labels, erase those left over and add new
+    // labels. cells are merged before labels are erased because erasing a
+    // label changes the label of the last cell.
+    for(size_t j = 0; j < merged.size(); ++j) {
+        cwcomplex.merge(3, merged[j].first, merged[j].second);
+        anchorage.merge(3, merged[j].first, merged[j].second);
+    }
+    for(Order order = 1; order < 4; ++order) {
+        std::vector<Component>& components = components_[order];
+        std::vector<Label>& free = freeLabels[order];
+        std::sort(free.rbegin(), free.rend());
+        for(size_t j = 0; j < components.size(); ++j) {
+            if(components[j].label == 0 && !free.empty()) {
+                components[j].label = free.back();
+                free.pop_back();
+            }
+        }
+        std::map<Label, size_t> componentOfLabel;
+        for(size_t j = 0; j < components.size(); ++j) {
+            if(components[j].label != 0) {
+                componentOfLabel[components[j].label] = j;
+            }
+        }
+        for(size_t j = 0; j < free.size(); ++j) { // in descending order
+            const Label last = cwcomplex.numberOfCells(order);
+            typename std::map<Label, size_t>::iterator it = componentOfLabel.find(last);
+            if(it != componentOfLabel.end() && free[j] != last) {
+                components[it->second].label = free[j];
+                componentOfLabel[free[j]] = it->second;
+                componentOfLabel.erase(it);
+            }
+            else if(free[j] != last) {
+                movedLabels_[order].push_back(free[j]);
+            }
+            cwcomplex.erase(order, free[j]);
+            anchorage.erase(order, free[j]);
+        }
+        for(size_t j = 0; j < components.size(); ++j) {
+            Component& component = components[j];
+            if(component.label == 0) {
+                component.label = cwcomplex.push_back(order);
+                const Label sameLabel = anchorage.push_back(component.first);
+                assert(component.label == sameLabel);
+            }
+            else {
+                anchorage.reanchor(component.first, component.label);
+            }
+            grid_.anchor(component.first, true);
+        }
+        for(size_t j = 0; j < anchors[order].size(); ++j) {
+            anchorage.anchor(anchors[order][j].first, components[anchors[order][j].second].label);
+        }
+    }
+
+    // 0-cells. labels of removed 0-cells are reused for added 0-cells.
+    std::vector<Label> free;
+    for(size_t j = 0; j < oldVertices.size(); ++j) {
+        if(!grid_.isMarked(oldVertices[j].first)) {
+            anchorage.erase(oldVertices[j].first);
+            free.push_back(oldVertices[j].second);
+        }
+    }
+    std::sort(free.rbegin(), free.rend());
+    forEachCell(0, boxBegin_, boxEnd_, [&](const CellType& cell) {
+        if(grid_.isMarked(cell) && anchorage.anchor(cell) == 0) {
+            if(free.empty()) {
+                cwcomplex.push_back(0);
+                anchorage.push_back(cell);
+            }
+            else {
+                anchorage.reanchor(cell, free.back());
+                free.pop_back();
+            }
+            grid_.anchor(cell, true);
+        }
+    });
+    for(size_t j = 0; j < free.size(); ++j) { // in descending order
+        cwcomplex.erase(0, free[j]);
+        anchorage.erase(0, free[j]);
+    }
+
+    // anchors in the window
+    if(cwx_.redundantAnchors_) {
+        forEachCell(1, windowBegin_, windowEnd_, [&](const CellType& cell) {
+            if(grid_.isMarked(cell)) {
+                grid_.anchor(cell, true);
+                anchorage.anchor(cell, components_[1][componentOf_[1][packCell(cell)]].label);
+            }
+        });
+        for(Order order = 2; order < 4; ++order) {
+            anchorSlices(order);
+        }
+    }
+}
+
+// anchors one cell of every part of a component of the given order in the
+// intersection of the window with a slice. thus, every component of every
+// slice has an anchor, as required for redundant anchors. components of
+// slices outside of the window have not changed.
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::anchorSlices(
+    const Order order
+)
+{
+    WorkspaceLease<Coordinate> lease;
+    for(size_t d = 0; d < 3; ++d) {
+        Coordinate begin[3] = {windowBegin_[0], windowBegin_[1], windowBegin_[2]};
+        Coordinate end[3] = {windowEnd_[0], windowEnd_[1], windowEnd_[2]};
+        for(Coordinate v = windowBegin_[d]; v <= windowEnd_[d]; ++v) {
+            begin[d] = v;
+            end[d] = v;
+            lease.workspace().begin();
+            forEachCell(order, begin, end, [&](const CellType& cell) {
+                if((order == 3 || grid_.isMarked(cell)) && !lease.workspace().isVisited(cell)) {
+                    grid_.anchor(cell, true);
+                    cwx_.anchorage_.anchor(cell, components_[order][componentOf_[order][packCell(cell)]].label);
+                    trace(cell, d, v, [](const CellType&) {}, lease.workspace());
+                }
+            });
+        }
+    }
+}
+
+// updates the label cache of the CWX, if any. the cells of affected
+// components are labeled anew, and 1- and 2-cells in the window that are no
+// longer marked are dropped. components whose cells are not all known, i.e.
+// 3-cells with a piece that is not traced completely and that have been
+// merged or taken another label, and the last components that have taken
+// the label of another component, are labeled by a traversal from their
+// anchor.
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::cacheLabels()
+{
+    LabelCache<Label, Coordinate>& cache = cwx_.labelCache_;
+    if(cache.empty()) {
+        return;
+    }
+    WorkspaceLease<Coordinate> lease;
+    for(Order order = 1; order < 4; ++order) {
+        if(order < 3 && !cache.hasBoundaryCells()) {
+            continue;
+        }
+        std::vector<Label> traced = movedLabels_[order];
+        for(size_t j = 0; j < components_[order].size(); ++j) {
+            const Component& component = components_[order][j];
+            if(!component.keptLabels.empty() && (component.keptLabels.size() > 1 || component.label != component.keptLabels[0])) {
+                traced.push_back(component.label);
+            }
+            else {
+                for(size_t k = 0; k < component.cells.size(); ++k) {
+                    cache.insert(component.cells[k], component.label);
+                }
+            }
+        }
+        forEachCell(order, windowBegin_, windowEnd_, [&](const CellType& cell) {
+            if(order == 3 || grid_.isMarked(cell)) {
+                cache.insert(cell, components_[order][componentOf_[order][packCell(cell)]].label);
+            }
+            else {
+                cache.erase(cell);
+            }
+        });
+        std::sort(traced.begin(), traced.end());
+        traced.erase(std::unique(traced.begin(), traced.end()), traced.end());
+        for(size_t j = 0; j < traced.size() && traced[j] <= cwx_.numberOfCells(order); ++j) {
+            cwx_.cacheLabels(order, traced[j], lease.workspace());
+        }
+    }
+}
+
+// connects the affected components to the cells of adjacent orders
+template<class T, class C, class LAYOUT>
+void
+Updater<T, C, LAYOUT>::connect()
+{
+    typename CWXType::CWComplexType& cwcomplex = cwx_.cwcomplex_;
+    WorkspaceLease<Coordinate> lease;
+    std::vector<std::pair<Label, Label> > pairs[3];
+    CellVector cells;
+
+    // 1-cells with 0-cells and 2-cells
+    for(size_t j = 0; j < components_[1].size(); ++j) {
+        const Component& component = components_[1][j];
+        for(size_t k = 0; k < component.cells.size(); ++k) {
+            grid_.below(component.cells[k], cells);
+            for(size_t m = 0; m < cells.size(); ++m) {
+                if(grid_.isMarked(cells[m])) {
+                    pairs[0].push_back(std::make_pair(labelOf(cells[m], lease.workspace()), component.label));
+                }
+            }
+            grid_.above(component.cells[k], cells);
+            for(size_t m = 0; m < cells.size(); ++m) {
+                if(grid_.isMarked(cells[m])) {
+                    pairs[1].push_back(std::make_pair(component.label, labelOf(cells[m], lease.workspace())));
+                }
+            }
+        }
+    }
+
+    // 2-cells with 1-cells and 3-cells. all cells of a 2-cell separate the
+    // same 3-cells.
+    for(size_t j = 0; j < components_[2].size(); ++j) {
+        const Component& component = components_[2][j];
+        for(size_t k = 0; k < component.cells.size(); ++k) {
+            grid_.below(component.cells[k], cells);
+            for(size_t m = 0; m < cells.size(); ++m) {
+                if(grid_.isMarked(cells[m])) {
+                    pairs[1].push_back(std::make_pair(labelOf(cells[m], lease.workspace()), component.label));
+                }
+            }
+        }
+        grid_.above(component.first, cells);
+        for(size_t m = 0; m < cells.size(); ++m) {
+            pairs[2].push_back(std::make_pair(component.label, labelOf(cells[m], lease.workspace())));
+        }
+    }
+
+    // 2-cells that are not affected but bound 3-cells in the window or in
+    // pieces that are traced completely
+    std::set<Label> boundingLabels;
+    CellVector faces;
+    auto connectBoundary = [&](const CellType& cell) {
+        grid_.below(cell, faces);
+        for(size_t k = 0; k < faces.size(); ++k) {
+            if(!grid_.isMarked(faces[k]) || componentOf_[2].count(packCell(faces[k])) != 0) {
+                continue;
+            }
+            const Label label = cwx_.atCell(faces[k], lease.workspace());
+            if(boundingLabels.insert(label).second) {
+                while(cwcomplex.above(2, label, 0) != 0) { // sizeAbove(2, label) is always 2
+                    cwcomplex.disconnect(2, label, cwcomplex.above(2, label, 0));
+                }
+                grid_.above(faces[k], cells);
+                for(size_t m = 0; m < cells.size(); ++m) {
+                    pairs[2].push_back(std::make_pair(label, labelOf(cells[m], lease.workspace())));
+                }
+            }
+        }
+    };
+    forEachCell(3, windowBegin_, windowEnd_, connectBoundary);
+    for(size_t j = 0; j < components_[3].size(); ++j) {
+        const std::vector<CellType>& voxels = components_[3][j].cells;
+        for(size_t k = 0; k < voxels.size(); ++k) {
+            connectBoundary(voxels[k]);
+        }
+    }
+
+    for(Order order = 0; order < 3; ++order) {
+        std::sort(pairs[order].begin(), pairs[order].end());
+        pairs[order].erase(std::unique(pairs[order].begin(), pairs[order].end()), pairs[order].end());
+        cwcomplex.connectPairs(order, pairs[order].begin(), pairs[order].end());
+    }
+}
+
+// label of a marked cell or 3-cell after the update
+template<class T, class C, class LAYOUT>
+inline typename Updater<T, C, LAYOUT>::Label
+Updater<T, C, LAYOUT>::labelOf(
+    const CellType& cell,
+    TraversalWorkspaceType& workspace
+) const
+{
+    const Order order = cell.order();
+    if(order == 0) {
+        return cwx_.anchorage_.anchor(cell);
+    }
+    typename IndexMap::const_iterator it = componentOf_[order].find(packCell(cell));
+    if(it != componentOf_[order].end()) {
+        return components_[order][it->second].label;
+    }
+    return cwx_.atCell(cell, workspace);
+}
+
+// root of an element in a union-find forest, with path halving
+template<class T, class C, class LAYOUT>
+inline size_t
+Updater<T, C, LAYOUT>::find(
+    std::vector<size_t>& parents,
+    size_t j
+)
+{
+    while(parents[j] != j) {
+        parents[j] = parents[parents[j]];
+        j = parents[j];
+    }
+    return j;
+}
+
 } // namespace detail
 
 } // namespace cwx
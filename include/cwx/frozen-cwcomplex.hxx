@@ -0,0 +1,218 @@
+#pragma once
+#ifndef CWX_FROZEN_CWCOMPLEX_HXX
+#define CWX_FROZEN_CWCOMPLEX_HXX
+
+#include <cassert>
+#include <vector>
+#include <array>
+#include <stdexcept>
+
+namespace cwx {
+
+/// read-only CW-complex in compressed sparse row layout.
+///
+/// for each order, the labels of the cells above (below) all cells are
+/// stored contiguously in one array, in ascending order of the label of
+/// the lower (upper) cell. offsets into these arrays delimit the lists of
+/// individual cells. the query interface is that of CWComplex.
+template<class T>
+class FrozenCWComplex {
+public:
+    typedef T Label;
+    typedef unsigned char Order;
+
+    FrozenCWComplex();
+    template<class COMPLEX> explicit FrozenCWComplex(const COMPLEX&);
+    template<class COMPLEX> void assign(const COMPLEX&);
+
+    // query
+    Label numberOfCells(const Order) const;
+    size_t sizeAbove(const Order, const Label) const;
+    size_t sizeBelow(const Order, const Label) const;
+    Label above(const Order, const Label, const size_t) const;
+    Label below(const Order, const Label, const size_t) const;
+    const Label* aboveBegin(const Order, const Label) const;
+    const Label* aboveEnd(const Order, const Label) const;
+    const Label* belowBegin(const Order, const Label) const;
+    const Label* belowEnd(const Order, const Label) const;
+
+private:
+    // the cells above (below) the cell of order k with label j are
+    // aboveLabels_[k][aboveOffsets_[k][j]], ..., aboveLabels_[k][aboveOffsets_[k][j+1]-1]
+    // offsets of order 3 (above) and order 0 (below) are all zero.
+    std::array<std::vector<size_t>, 4> aboveOffsets_;
+    std::array<std::vector<Label>, 4> aboveLabels_;
+    std::array<std::vector<size_t>, 4> belowOffsets_;
+    std::array<std::vector<Label>, 4> belowLabels_;
+};
+
+template<class T>
+inline
+FrozenCWComplex<T>::FrozenCWComplex()
+{
+    for(Order order = 0; order < 4; ++order) {
+        aboveOffsets_[order].assign(2, 0);
+        belowOffsets_[order].assign(2, 0);
+    }
+}
+
+// COMPLEX is expected to have the query interface of CWComplex, e.g.
+// CWComplex or CWX
+template<class T>
+template<class COMPLEX>
+inline
+FrozenCWComplex<T>::FrozenCWComplex(
+    const COMPLEX& complex
+)
+{
+    assign(complex);
+}
+
+template<class T>
+template<class COMPLEX>
+void
+FrozenCWComplex<T>::assign(
+    const COMPLEX& complex
+)
+{
+    for(Order order = 0; order < 4; ++order) {
+        const Label n = complex.numberOfCells(order);
+
+        // offsets are prefix sums of the sizes, starting at label 1
+        aboveOffsets_[order].assign(static_cast<size_t>(n) + 2, 0);
+        belowOffsets_[order].assign(static_cast<size_t>(n) + 2, 0);
+        for(Label label = 1; label <= n; ++label) {
+            aboveOffsets_[order][label + 1] = aboveOffsets_[order][label]
+                + (order < 3 ? complex.sizeAbove(order, label) : 0);
+            belowOffsets_[order][label + 1] = belowOffsets_[order][label]
+                + (order > 0 ? complex.sizeBelow(order, label) : 0);
+        }
+
+        std::vector<Label>(aboveOffsets_[order].back()).swap(aboveLabels_[order]);
+        std::vector<Label>(belowOffsets_[order].back()).swap(belowLabels_[order]);
+        for(Label label = 1; label <= n; ++label) {
+            for(size_t j = 0; j < sizeAbove(order, label); ++j) {
+                aboveLabels_[order][aboveOffsets_[order][label] + j] = complex.above(order, label, j);
+            }
+            for(size_t j = 0; j < sizeBelow(order, label); ++j) {
+                belowLabels_[order][belowOffsets_[order][label] + j] = complex.below(order, label, j);
+            }
+        }
+    }
+}
+
+template<class T>
+inline typename FrozenCWComplex<T>::Label
+FrozenCWComplex<T>::numberOfCells(
+    const Order order
+) const
+{
+    if(order > 3) {
+        throw std::runtime_error("invalid order");
+    }
+    return static_cast<Label>(aboveOffsets_[order].size() - 2);
+}
+
+template<class T>
+inline size_t
+FrozenCWComplex<T>::sizeAbove(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return aboveOffsets_[order][label + 1] - aboveOffsets_[order][label];
+}
+
+template<class T>
+inline size_t
+FrozenCWComplex<T>::sizeBelow(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return belowOffsets_[order][label + 1] - belowOffsets_[order][label];
+}
+
+// returns 0 if j >= sizeAbove(order, label), as CWComplex::above
+template<class T>
+inline typename FrozenCWComplex<T>::Label
+FrozenCWComplex<T>::above(
+    const Order order,
+    const Label label,
+    const size_t j
+) const
+{
+    if(order == 3) {
+        throw std::runtime_error("order 3 is not applicable here");
+    }
+    if(j >= sizeAbove(order, label)) {
+        return 0;
+    }
+    return aboveLabels_[order][aboveOffsets_[order][label] + j];
+}
+
+// assertion fails if j >= sizeBelow(order, label), as for CWComplex::below
+template<class T>
+inline typename FrozenCWComplex<T>::Label
+FrozenCWComplex<T>::below(
+    const Order order,
+    const Label label,
+    const size_t j
+) const
+{
+    if(order == 0) {
+        throw std::runtime_error("order 0 is not applicable here");
+    }
+    assert(j < sizeBelow(order, label));
+    return belowLabels_[order][belowOffsets_[order][label] + j];
+}
+
+template<class T>
+inline const typename FrozenCWComplex<T>::Label*
+FrozenCWComplex<T>::aboveBegin(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return aboveLabels_[order].data() + aboveOffsets_[order][label];
+}
+
+template<class T>
+inline const typename FrozenCWComplex<T>::Label*
+FrozenCWComplex<T>::aboveEnd(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return aboveLabels_[order].data() + aboveOffsets_[order][label + 1];
+}
+
+template<class T>
+inline const typename FrozenCWComplex<T>::Label*
+FrozenCWComplex<T>::belowBegin(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return belowLabels_[order].data() + belowOffsets_[order][label];
+}
+
+template<class T>
+inline const typename FrozenCWComplex<T>::Label*
+FrozenCWComplex<T>::belowEnd(
+    const Order order,
+    const Label label
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    return belowLabels_[order].data() + belowOffsets_[order][label + 1];
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_FROZEN_CWCOMPLEX_HXX
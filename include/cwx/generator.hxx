@@ -0,0 +1,295 @@
+#pragma once
+#ifndef CWX_GENERATOR_HXX
+#define CWX_GENERATOR_HXX
+
+// synthetic segmentations for tests and load tests
+//
+// every generator assigns to each voxel a label that is a function of the
+// coordinates of the voxel, the parameters and a seed. thus, the result does
+// not depend on the number of threads, and no memory is needed besides the
+// segmentation, at any size. voxels are written in parallel, in slabs of
+// slices orthogonal to dimension 2. a generator throws if the label type
+// cannot hold all labels.
+
+#include <cassert>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "marray.hxx"
+#include "cwx/parallel.hxx"
+
+namespace cwx {
+
+template<class T, bool B>
+    void generateVoronoi(andres::View<T, B>&, const size_t, const uint64_t = 42, const size_t = 1);
+template<class T, bool B>
+    void generateShells(andres::View<T, B>&, const size_t, const uint64_t = 42, const size_t = 1);
+template<class T, bool B>
+    void generateSheets(andres::View<T, B>&, const size_t, const uint64_t = 42, const size_t = 1);
+template<class T, bool B>
+    void generateTunnels(andres::View<T, B>&, const size_t, const size_t, const uint64_t = 42, const size_t = 1);
+template<class T, bool B>
+    void generateFragments(andres::View<T, B>&, const size_t, const uint64_t = 42, const size_t = 1);
+
+namespace detail {
+
+// splitmix64 finalizer
+inline uint64_t
+hash(
+    uint64_t x
+)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t
+hash(
+    const uint64_t seed,
+    const uint64_t a,
+    const uint64_t b = 0,
+    const uint64_t c = 0,
+    const uint64_t d = 0
+)
+{
+    return hash(hash(hash(hash(hash(seed) ^ a) ^ b) ^ c) ^ d);
+}
+
+// uniformly distributed in [0, 1)
+inline double
+uniform(
+    const uint64_t h
+)
+{
+    return static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+template<class T>
+inline void
+checkNumberOfLabels(
+    const double numberOfLabels
+)
+{
+    if(numberOfLabels > static_cast<double>(std::numeric_limits<T>::max())) {
+        throw std::runtime_error("the label type cannot hold all labels.");
+    }
+}
+
+// sets seg(x, y, z) = functor(x, y, z) for all voxels
+template<class T, bool B, class FUNCTOR>
+void
+generate(
+    andres::View<T, B>& seg,
+    const size_t numberOfThreads,
+    FUNCTOR functor
+)
+{
+    if(seg.dimension() != 3) {
+        throw std::runtime_error("segmentation is not 3-dimensional.");
+    }
+    const SlabPartition slabs(seg.shape(2), numberOfThreads == 0 ? hardwareConcurrency() : numberOfThreads);
+    parallelFor(slabs.numberOfSlabs(), [&](const size_t j) {
+        for(size_t z = slabs.begin(j); z < slabs.end(j); ++z)
+        for(size_t y = 0; y < seg.shape(1); ++y)
+        for(size_t x = 0; x < seg.shape(0); ++x) {
+            seg(x, y, z) = functor(x, y, z);
+        }
+    });
+}
+
+} // namespace detail
+
+// supervoxels of roughly cellSize^3 voxels. the volume is divided into cubes
+// of edge length cellSize, each with one seed at a random position. a voxel
+// is labeled by the nearest seed among those of its own and the 26 adjacent
+// cubes, i.e. the supervoxels are approximately the cells of a Voronoi
+// diagram. labels are 1 + the index of the cube, first coordinate fastest.
+template<class T, bool B>
+void
+generateVoronoi(
+    andres::View<T, B>& seg,
+    const size_t cellSize,
+    const uint64_t seed,
+    const size_t numberOfThreads
+)
+{
+    assert(cellSize > 0);
+    size_t gridShape[3];
+    for(size_t d = 0; d < 3; ++d) {
+        gridShape[d] = (seg.shape(d) + cellSize - 1) / cellSize;
+    }
+    detail::checkNumberOfLabels<T>(static_cast<double>(gridShape[0]) * gridShape[1] * gridShape[2]);
+    const double s = static_cast<double>(cellSize);
+    detail::generate(seg, numberOfThreads, [&](const size_t x, const size_t y, const size_t z) {
+        const size_t voxel[] = {x, y, z};
+        size_t best = 0;
+        double bestDistance = std::numeric_limits<double>::max();
+        for(int dz = -1; dz <= 1; ++dz)
+        for(int dy = -1; dy <= 1; ++dy)
+        for(int dx = -1; dx <= 1; ++dx) {
+            const int offset[] = {dx, dy, dz};
+            int64_t g[3];
+            bool inside = true;
+            for(size_t d = 0; d < 3; ++d) {
+                g[d] = static_cast<int64_t>(voxel[d] / cellSize) + offset[d];
+                inside = inside && g[d] >= 0 && g[d] < static_cast<int64_t>(gridShape[d]);
+            }
+            if(inside) {
+                const size_t cube = g[0] + gridShape[0] * (g[1] + gridShape[1] * static_cast<size_t>(g[2]));
+                double distance = 0;
+                for(size_t d = 0; d < 3; ++d) {
+                    const double position = s * (g[d] + detail::uniform(detail::hash(seed, cube, d)));
+                    const double delta = position - (voxel[d] + 0.5);
+                    distance += delta * delta;
+                }
+                if(distance < bestDistance) {
+                    bestDistance = distance;
+                    best = cube;
+                }
+            }
+        }
+        return static_cast<T>(best + 1);
+    });
+}
+
+// nested spherical shells of the given thickness around a center near the
+// center of the volume. the innermost ball has label 1.
+template<class T, bool B>
+void
+generateShells(
+    andres::View<T, B>& seg,
+    const size_t thickness,
+    const uint64_t seed,
+    const size_t numberOfThreads
+)
+{
+    assert(thickness > 0);
+    double center[3];
+    double diagonal = 0;
+    for(size_t d = 0; d < 3; ++d) {
+        center[d] = 0.5 * seg.shape(d) + thickness * (detail::uniform(detail::hash(seed, d)) - 0.5);
+        diagonal += static_cast<double>(seg.shape(d)) * seg.shape(d);
+    }
+    detail::checkNumberOfLabels<T>(std::sqrt(diagonal) / thickness + 2);
+    detail::generate(seg, numberOfThreads, [&](const size_t x, const size_t y, const size_t z) {
+        const double dx = x + 0.5 - center[0];
+        const double dy = y + 0.5 - center[1];
+        const double dz = z + 0.5 - center[2];
+        return static_cast<T>(std::sqrt(dx * dx + dy * dy + dz * dz) / thickness + 1);
+    });
+}
+
+// wavy sheets, one voxel thick, roughly orthogonal to dimension 2 and
+// spacing voxels apart. between two sheets is a thick region. sheets have
+// even labels, regions odd labels.
+template<class T, bool B>
+void
+generateSheets(
+    andres::View<T, B>& seg,
+    const size_t spacing,
+    const uint64_t seed,
+    const size_t numberOfThreads
+)
+{
+    assert(spacing > 1);
+    const double amplitude = 0.25 * spacing;
+    const double wavelength = 4.0 * spacing;
+    const double pi = 3.14159265358979323846;
+    const double phase0 = 2 * pi * detail::uniform(detail::hash(seed, 0));
+    const double phase1 = 2 * pi * detail::uniform(detail::hash(seed, 1));
+    detail::checkNumberOfLabels<T>(2.0 * ((seg.shape(2) + 2 * amplitude) / spacing + 1));
+    detail::generate(seg, numberOfThreads, [&](const size_t x, const size_t y, const size_t z) {
+        const double offset = amplitude
+            * std::sin(2 * pi * x / wavelength + phase0)
+            * std::sin(2 * pi * y / wavelength + phase1);
+        const double h = z - offset + amplitude; // >= 0
+        const size_t k = static_cast<size_t>(h / spacing);
+        const bool sheet = h - static_cast<double>(k) * spacing < 1.0;
+        return static_cast<T>(2 * k + (sheet ? 2 : 1));
+    });
+}
+
+// a background with label 1 that is traversed by straight tunnels of the
+// given radius along all three dimensions, spacing voxels apart. every
+// tunnel has its own label. where tunnels cross, the tunnel along the lower
+// dimension takes precedence. the lattice of tunnels is shifted randomly.
+template<class T, bool B>
+void
+generateTunnels(
+    andres::View<T, B>& seg,
+    const size_t spacing,
+    const size_t radius,
+    const uint64_t seed,
+    const size_t numberOfThreads
+)
+{
+    assert(spacing > 2 * radius + 1);
+    size_t shift[3];
+    size_t numbers[3]; // number of lattice positions
+    for(size_t d = 0; d < 3; ++d) {
+        shift[d] = detail::hash(seed, d) % spacing;
+        numbers[d] = (seg.shape(d) + shift[d] + spacing / 2) / spacing + 1;
+    }
+    detail::checkNumberOfLabels<T>(2.0 + 3.0 * std::max(numbers[1] * numbers[2], std::max(numbers[0] * numbers[2], numbers[0] * numbers[1])));
+    const int64_t r2 = static_cast<int64_t>(radius * radius);
+    detail::generate(seg, numberOfThreads, [&](const size_t x, const size_t y, const size_t z) {
+        const size_t voxel[] = {x, y, z};
+        size_t line[3]; // index of the nearest lattice position
+        int64_t delta[3]; // offset from the nearest lattice position
+        for(size_t d = 0; d < 3; ++d) {
+            const size_t c = voxel[d] + shift[d];
+            line[d] = (c + spacing / 2) / spacing;
+            delta[d] = static_cast<int64_t>(c) - static_cast<int64_t>(line[d] * spacing);
+        }
+        for(size_t d = 0; d < 3; ++d) { // dimension of the tunnel
+            const size_t e0 = d == 0 ? 1 : 0;
+            const size_t e1 = d == 2 ? 1 : 2;
+            if(delta[e0] * delta[e0] + delta[e1] * delta[e1] <= r2) {
+                return static_cast<T>(2 + d + 3 * (line[e0] + numbers[e0] * line[e1]));
+            }
+        }
+        return static_cast<T>(1);
+    });
+}
+
+// many small fragments. the volume is divided into cubes of edge length
+// fragmentSize. the boundaries between cubes are blurred by shifting every
+// voxel randomly by up to half the edge length in each dimension before
+// assigning it to a cube. thus, most labels consist of a core and many
+// fragments of few voxels, some not connected to the core.
+template<class T, bool B>
+void
+generateFragments(
+    andres::View<T, B>& seg,
+    const size_t fragmentSize,
+    const uint64_t seed,
+    const size_t numberOfThreads
+)
+{
+    assert(fragmentSize > 0);
+    size_t gridShape[3];
+    for(size_t d = 0; d < 3; ++d) {
+        // shifted coordinates lie in (-fragmentSize/2, shape + fragmentSize/2)
+        gridShape[d] = (seg.shape(d) + fragmentSize - 1) / fragmentSize + 2;
+    }
+    detail::checkNumberOfLabels<T>(static_cast<double>(gridShape[0]) * gridShape[1] * gridShape[2]);
+    const double s = static_cast<double>(fragmentSize);
+    detail::generate(seg, numberOfThreads, [&](const size_t x, const size_t y, const size_t z) {
+        const size_t voxel[] = {x, y, z};
+        size_t g[3];
+        for(size_t d = 0; d < 3; ++d) {
+            const double shifted = voxel[d] + 0.5 + s * (detail::uniform(detail::hash(seed, x, y, z, d)) - 0.5);
+            g[d] = static_cast<size_t>(std::floor(shifted / s) + 1); // >= 0
+        }
+        return static_cast<T>(1 + g[0] + gridShape[0] * (g[1] + gridShape[1] * g[2]));
+    });
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_GENERATOR_HXX
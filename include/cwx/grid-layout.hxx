@@ -0,0 +1,490 @@
+#pragma once
+#ifndef CWX_GRID_LAYOUT_HXX
+#define CWX_GRID_LAYOUT_HXX
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include "marray.hxx"
+
+namespace cwx {
+
+/// layouts of the bytes of a ByteLabeledCellgrid in memory, one byte per
+/// voxel.
+///
+/// a layout has the functions
+/// - void resize(const size_t, const size_t, const size_t)
+/// - unsigned char operator()(const size_t, const size_t, const size_t) const
+/// - unsigned char& operator()(const size_t, const size_t, const size_t)
+/// - void set(const size_t, const size_t, const size_t, const unsigned char)
+/// - bool isContiguous(const size_t) const
+/// - size_t memory() const
+/// - template<bool B> void assign(const andres::View<unsigned char, B>&)
+/// - ExportType grid() const
+/// and the constant concurrentWrites, where ExportType is indexed like an
+/// andres::View<unsigned char> by voxel coordinates. the bytes of voxels
+/// that are added by resize are 0. assign expects a view of the shape of
+/// the layout.
+/// isContiguous(j) is true if the bytes of voxels adjacent in dimension j
+/// are adjacent in memory, such that rows of voxels can be marked through
+/// pointers. concurrentWrites is true if different threads may write to
+/// different bytes while others read.
+
+/// bytes in an andres::Marray, in its coordinate order. rows of voxels along
+/// the fastest dimension are contiguous in memory, which permits the
+/// row-wise marking of detail::Marker. grid() refers to the bytes without
+/// copying them.
+class LinearLayout {
+public:
+    typedef andres::View<unsigned char> ExportType;
+    static const bool concurrentWrites = true;
+
+    LinearLayout();
+    void resize(const size_t, const size_t, const size_t);
+    unsigned char operator()(const size_t, const size_t, const size_t) const;
+    unsigned char& operator()(const size_t, const size_t, const size_t);
+    void set(const size_t, const size_t, const size_t, const unsigned char);
+    bool isContiguous(const size_t) const;
+    size_t memory() const;
+    template<bool B> void assign(const andres::View<unsigned char, B>&);
+    ExportType grid() const;
+
+private:
+    andres::Marray<unsigned char> bytes_;
+};
+
+/// bytes in cubic bricks of EDGE^3 voxels. the bricks are stored in the
+/// order of their first voxel, with the first coordinate fastest, and so
+/// are the voxels within a brick. voxels that are close in any dimension
+/// are thus close in memory, such that traversals across slices touch
+/// fewer cache lines and pages than with LinearLayout. the volume is padded
+/// to whole bricks. grid() copies the bytes into an andres::Marray.
+template<size_t EDGE = 8>
+class BrickedLayout {
+public:
+    typedef andres::Marray<unsigned char> ExportType;
+    static const bool concurrentWrites = true;
+
+    BrickedLayout();
+    void resize(const size_t, const size_t, const size_t);
+    unsigned char operator()(const size_t, const size_t, const size_t) const;
+    unsigned char& operator()(const size_t, const size_t, const size_t);
+    void set(const size_t, const size_t, const size_t, const unsigned char);
+    bool isContiguous(const size_t) const;
+    size_t memory() const;
+    template<bool B> void assign(const andres::View<unsigned char, B>&);
+    ExportType grid() const;
+
+private:
+    size_t index(const size_t, const size_t, const size_t) const;
+
+    size_t shape_[3];
+    size_t bricks_[2]; // number of bricks in dimensions 0 and 1
+    std::vector<unsigned char> bytes_;
+};
+
+/// bytes in cubic bricks of EDGE^3 voxels, of which only those are stored
+/// that contain a byte other than 0, i.e. a marked cell or an anchor. a
+/// directory holds one number per brick that refers to a stored brick, or
+/// to a brick of zeros shared by all bricks that are not stored. reading a
+/// byte is thus two lookups without a branch. for volumes with large
+/// homogeneous regions, memory grows with the area of the boundaries rather
+/// than with the volume, plus one number per brick.
+///
+/// set allocates a brick when it writes a byte other than 0 to a brick that
+/// is not stored, and so does the non-const operator() always. bricks are
+/// not released when their bytes become 0 again. bytes must not be written
+/// while other threads access the layout. grid() copies the bytes into an
+/// andres::Marray.
+template<size_t EDGE = 16>
+class SparseLayout {
+public:
+    typedef andres::Marray<unsigned char> ExportType;
+    static const bool concurrentWrites = false;
+
+    SparseLayout();
+    void resize(const size_t, const size_t, const size_t);
+    unsigned char operator()(const size_t, const size_t, const size_t) const;
+    unsigned char& operator()(const size_t, const size_t, const size_t);
+    void set(const size_t, const size_t, const size_t, const unsigned char);
+    bool isContiguous(const size_t) const;
+    size_t numberOfBricks() const;
+    size_t memory() const;
+    template<bool B> void assign(const andres::View<unsigned char, B>&);
+    ExportType grid() const;
+
+private:
+    static const size_t brickSize_ = EDGE * EDGE * EDGE;
+
+    size_t brick(const size_t, const size_t, const size_t) const;
+    size_t offset(const size_t, const size_t, const size_t) const;
+
+    size_t shape_[3];
+    size_t bricks_[2]; // number of bricks in dimensions 0 and 1
+    std::vector<size_t> directory_; // 0 for bricks that are not stored
+    std::vector<unsigned char> bytes_; // stored bricks, after the brick of zeros
+};
+
+inline
+LinearLayout::LinearLayout()
+:   bytes_()
+{}
+
+inline void
+LinearLayout::resize(
+    const size_t n0,
+    const size_t n1,
+    const size_t n2
+)
+{
+#   ifdef _MSC_VER // MSVC does currently not support initializer lists
+        size_t shape[] = {n0, n1, n2};
+        bytes_.resize(shape, shape + 3);
+#   else
+        bytes_.resize({n0, n1, n2});
+#   endif
+}
+
+inline unsigned char
+LinearLayout::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    return bytes_(x, y, z);
+}
+
+inline unsigned char&
+LinearLayout::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+)
+{
+    return bytes_(x, y, z);
+}
+
+inline void
+LinearLayout::set(
+    const size_t x,
+    const size_t y,
+    const size_t z,
+    const unsigned char value
+)
+{
+    bytes_(x, y, z) = value;
+}
+
+inline bool
+LinearLayout::isContiguous(
+    const size_t j
+) const
+{
+    return bytes_.strides(j) == 1;
+}
+
+inline size_t
+LinearLayout::memory() const
+{
+    return bytes_.size();
+}
+
+template<bool B>
+void
+LinearLayout::assign(
+    const andres::View<unsigned char, B>& grid
+)
+{
+    assert(grid.dimension() == 3);
+    if(grid.isSimple() && grid.coordinateOrder() == bytes_.coordinateOrder()) {
+        std::copy(grid.begin(), grid.end(), bytes_.begin());
+    }
+    else {
+        for(size_t z = 0; z < grid.shape(2); ++z)
+        for(size_t y = 0; y < grid.shape(1); ++y)
+        for(size_t x = 0; x < grid.shape(0); ++x) {
+            bytes_(x, y, z) = grid(x, y, z);
+        }
+    }
+}
+
+inline LinearLayout::ExportType
+LinearLayout::grid() const
+{
+    return bytes_;
+}
+
+template<size_t EDGE>
+inline
+BrickedLayout<EDGE>::BrickedLayout()
+:   bytes_()
+{
+    static_assert(EDGE > 0 && (EDGE & (EDGE - 1)) == 0, "the edge length of bricks must be a power of 2.");
+    shape_[0] = shape_[1] = shape_[2] = 0;
+    bricks_[0] = bricks_[1] = 0;
+}
+
+template<size_t EDGE>
+inline void
+BrickedLayout<EDGE>::resize(
+    const size_t n0,
+    const size_t n1,
+    const size_t n2
+)
+{
+    shape_[0] = n0;
+    shape_[1] = n1;
+    shape_[2] = n2;
+    bricks_[0] = (n0 + EDGE - 1) / EDGE;
+    bricks_[1] = (n1 + EDGE - 1) / EDGE;
+    const size_t bricks2 = (n2 + EDGE - 1) / EDGE;
+    bytes_.assign(bricks_[0] * bricks_[1] * bricks2 * EDGE * EDGE * EDGE, 0);
+}
+
+template<size_t EDGE>
+inline unsigned char
+BrickedLayout<EDGE>::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    return bytes_[index(x, y, z)];
+}
+
+template<size_t EDGE>
+inline unsigned char&
+BrickedLayout<EDGE>::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+)
+{
+    return bytes_[index(x, y, z)];
+}
+
+template<size_t EDGE>
+inline void
+BrickedLayout<EDGE>::set(
+    const size_t x,
+    const size_t y,
+    const size_t z,
+    const unsigned char value
+)
+{
+    bytes_[index(x, y, z)] = value;
+}
+
+// rows of voxels are contiguous only within a brick
+template<size_t EDGE>
+inline bool
+BrickedLayout<EDGE>::isContiguous(
+    const size_t
+) const
+{
+    return false;
+}
+
+template<size_t EDGE>
+inline size_t
+BrickedLayout<EDGE>::memory() const
+{
+    return bytes_.size();
+}
+
+template<size_t EDGE>
+template<bool B>
+void
+BrickedLayout<EDGE>::assign(
+    const andres::View<unsigned char, B>& grid
+)
+{
+    assert(grid.dimension() == 3);
+    assert(grid.shape(0) == shape_[0] && grid.shape(1) == shape_[1] && grid.shape(2) == shape_[2]);
+    for(size_t z = 0; z < shape_[2]; ++z)
+    for(size_t y = 0; y < shape_[1]; ++y)
+    for(size_t x = 0; x < shape_[0]; ++x) {
+        bytes_[index(x, y, z)] = grid(x, y, z);
+    }
+}
+
+template<size_t EDGE>
+typename BrickedLayout<EDGE>::ExportType
+BrickedLayout<EDGE>::grid() const
+{
+    ExportType grid(shape_, shape_ + 3);
+    for(size_t z = 0; z < shape_[2]; ++z)
+    for(size_t y = 0; y < shape_[1]; ++y)
+    for(size_t x = 0; x < shape_[0]; ++x) {
+        grid(x, y, z) = bytes_[index(x, y, z)];
+    }
+    return grid;
+}
+
+template<size_t EDGE>
+inline size_t
+BrickedLayout<EDGE>::index(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    assert(x < shape_[0] && y < shape_[1] && z < shape_[2]);
+    const size_t brick = (z / EDGE * bricks_[1] + y / EDGE) * bricks_[0] + x / EDGE;
+    return brick * (EDGE * EDGE * EDGE) + (z % EDGE * EDGE + y % EDGE) * EDGE + x % EDGE;
+}
+
+template<size_t EDGE>
+inline
+SparseLayout<EDGE>::SparseLayout()
+:   directory_(),
+    bytes_(brickSize_, 0)
+{
+    static_assert(EDGE > 0 && (EDGE & (EDGE - 1)) == 0, "the edge length of bricks must be a power of 2.");
+    shape_[0] = shape_[1] = shape_[2] = 0;
+    bricks_[0] = bricks_[1] = 0;
+}
+
+// releases all bricks
+template<size_t EDGE>
+inline void
+SparseLayout<EDGE>::resize(
+    const size_t n0,
+    const size_t n1,
+    const size_t n2
+)
+{
+    shape_[0] = n0;
+    shape_[1] = n1;
+    shape_[2] = n2;
+    bricks_[0] = (n0 + EDGE - 1) / EDGE;
+    bricks_[1] = (n1 + EDGE - 1) / EDGE;
+    const size_t bricks2 = (n2 + EDGE - 1) / EDGE;
+    std::vector<size_t>(bricks_[0] * bricks_[1] * bricks2, 0).swap(directory_);
+    std::vector<unsigned char>(brickSize_, 0).swap(bytes_);
+}
+
+template<size_t EDGE>
+inline unsigned char
+SparseLayout<EDGE>::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    return bytes_[directory_[brick(x, y, z)] * brickSize_ + offset(x, y, z)];
+}
+
+// allocates the brick of the voxel if it is not stored
+template<size_t EDGE>
+inline unsigned char&
+SparseLayout<EDGE>::operator()(
+    const size_t x,
+    const size_t y,
+    const size_t z
+)
+{
+    size_t& stored = directory_[brick(x, y, z)];
+    if(stored == 0) {
+        stored = bytes_.size() / brickSize_;
+        bytes_.resize(bytes_.size() + brickSize_, 0);
+    }
+    return bytes_[stored * brickSize_ + offset(x, y, z)];
+}
+
+template<size_t EDGE>
+inline void
+SparseLayout<EDGE>::set(
+    const size_t x,
+    const size_t y,
+    const size_t z,
+    const unsigned char value
+)
+{
+    if(value != 0 || directory_[brick(x, y, z)] != 0) {
+        (*this)(x, y, z) = value;
+    }
+}
+
+template<size_t EDGE>
+inline bool
+SparseLayout<EDGE>::isContiguous(
+    const size_t
+) const
+{
+    return false;
+}
+
+// number of bricks stored
+template<size_t EDGE>
+inline size_t
+SparseLayout<EDGE>::numberOfBricks() const
+{
+    return bytes_.size() / brickSize_ - 1;
+}
+
+template<size_t EDGE>
+inline size_t
+SparseLayout<EDGE>::memory() const
+{
+    return directory_.size() * sizeof(size_t) + bytes_.size();
+}
+
+template<size_t EDGE>
+template<bool B>
+void
+SparseLayout<EDGE>::assign(
+    const andres::View<unsigned char, B>& grid
+)
+{
+    assert(grid.dimension() == 3);
+    assert(grid.shape(0) == shape_[0] && grid.shape(1) == shape_[1] && grid.shape(2) == shape_[2]);
+    for(size_t z = 0; z < shape_[2]; ++z)
+    for(size_t y = 0; y < shape_[1]; ++y)
+    for(size_t x = 0; x < shape_[0]; ++x) {
+        set(x, y, z, grid(x, y, z));
+    }
+}
+
+template<size_t EDGE>
+typename SparseLayout<EDGE>::ExportType
+SparseLayout<EDGE>::grid() const
+{
+    ExportType grid(shape_, shape_ + 3);
+    for(size_t z = 0; z < shape_[2]; ++z)
+    for(size_t y = 0; y < shape_[1]; ++y)
+    for(size_t x = 0; x < shape_[0]; ++x) {
+        grid(x, y, z) = (*this)(x, y, z);
+    }
+    return grid;
+}
+
+template<size_t EDGE>
+inline size_t
+SparseLayout<EDGE>::brick(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    assert(x < shape_[0] && y < shape_[1] && z < shape_[2]);
+    return (z / EDGE * bricks_[1] + y / EDGE) * bricks_[0] + x / EDGE;
+}
+
+template<size_t EDGE>
+inline size_t
+SparseLayout<EDGE>::offset(
+    const size_t x,
+    const size_t y,
+    const size_t z
+) const
+{
+    return (z % EDGE * EDGE + y % EDGE) * EDGE + x % EDGE;
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_GRID_LAYOUT_HXX
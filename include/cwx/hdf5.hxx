@@ -0,0 +1,601 @@
+#pragma once
+#ifndef CWX_HDF5_HXX
+#define CWX_HDF5_HXX
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "andres/marray_hdf5.hxx"
+#include "cwx/cwx.hxx"
+
+namespace cwx {
+
+/// loader of slabs of voxel slices orthogonal to dimension 2 from a
+/// 3-dimensional HDF5 dataset, for use with CWX::buildFromSlabs.
+///
+/// the file is expected to remain open while the loader is in use.
+template<class T>
+class HDF5SlabLoader {
+public:
+    typedef T value_type;
+
+    HDF5SlabLoader(const hid_t&, const std::string&);
+    size_t shape(const size_t) const;
+    void operator()(const size_t, const size_t, andres::Marray<value_type>&) const;
+
+private:
+    hid_t file_;
+    std::string datasetName_;
+    std::vector<size_t> shape_;
+};
+
+template<class U, class T, class C, class LAYOUT>
+    void buildFromHDF5(CWX<T, C, LAYOUT>&, const std::string&, const std::string&, const size_t, bool = false, const size_t = 1);
+template<class T, class C, class LAYOUT>
+    void save(const hid_t&, const std::string&, const CWX<T, C, LAYOUT>&);
+template<class T, class C, class LAYOUT>
+    void load(const hid_t&, const std::string&, CWX<T, C, LAYOUT>&);
+
+namespace detail {
+
+// for INTERNAL use with save and load
+template<class T, class C, class LAYOUT>
+class HDF5Serializer {
+public:
+    typedef CWX<T, C, LAYOUT> CWXType;
+    typedef typename CWXType::Label Label;
+    typedef typename CWXType::Coordinate Coordinate;
+    typedef typename CWXType::Order Order;
+    typedef typename CWXType::CellType CellType;
+
+    static void save(const hid_t&, const CWXType&);
+    static void load(const hid_t&, CWXType&);
+};
+
+template<class T>
+    hid_t fileType();
+template<class T>
+    hid_t createChunked(const hid_t&, const std::string&, const std::vector<hsize_t>&, const bool = false);
+template<class T>
+    void saveChunked(const hid_t&, const std::string&, const std::vector<hsize_t>&, const T*, const bool = false);
+template<class T>
+    void saveChunked(const hid_t&, const std::string&, const std::vector<T>&);
+template<class T>
+    void loadVector(const hid_t&, const std::string&, std::vector<T>&);
+template<class GRID>
+    void saveGrid(const hid_t&, const std::string&, const GRID&);
+template<class GRID>
+    void loadGrid(const hid_t&, const std::string&, GRID&);
+
+} // namespace detail
+
+template<class T>
+inline
+HDF5SlabLoader<T>::HDF5SlabLoader(
+    const hid_t& file,
+    const std::string& datasetName
+)
+:   file_(file),
+    datasetName_(datasetName),
+    shape_()
+{
+    andres::hdf5::loadShape(file_, datasetName_, shape_);
+    if(shape_.size() != 3) {
+        throw std::runtime_error("dataset is not 3-dimensional.");
+    }
+}
+
+template<class T>
+inline size_t
+HDF5SlabLoader<T>::shape(
+    const size_t dimension
+) const
+{
+    return shape_[dimension];
+}
+
+// loads the voxel slices [sliceBegin, sliceEnd) of dimension 2
+template<class T>
+inline void
+HDF5SlabLoader<T>::operator()(
+    const size_t sliceBegin,
+    const size_t sliceEnd,
+    andres::Marray<value_type>& out
+) const
+{
+    assert(sliceBegin < sliceEnd && sliceEnd <= shape_[2]);
+    const size_t base[] = {0, 0, sliceBegin};
+    const size_t slabShape[] = {shape_[0], shape_[1], sliceEnd - sliceBegin};
+    andres::hdf5::loadHyperslab(file_, datasetName_, base, base + 3, slabShape, out);
+}
+
+// builds a CWX from a segmentation stored in an HDF5 dataset of voxel labels
+// of type U, reading slabs of voxel slices whose size is bounded by the
+// memory budget (in bytes), cf. CWX::buildFromSlabs
+template<class U, class T, class C, class LAYOUT>
+void
+buildFromHDF5(
+    CWX<T, C, LAYOUT>& cwx,
+    const std::string& fileName,
+    const std::string& datasetName,
+    const size_t memoryBudget,
+    bool verbose,
+    const size_t numberOfThreads
+)
+{
+    hid_t file = andres::hdf5::openFile(fileName);
+    try {
+        HDF5SlabLoader<U> loader(file, datasetName);
+        cwx.buildFromSlabs(loader, memoryBudget, verbose, numberOfThreads);
+    }
+    catch(...) {
+        andres::hdf5::closeFile(file);
+        throw;
+    }
+    andres::hdf5::closeFile(file);
+}
+
+// saves the complete state of a CWX in a new HDF5 group. this state
+// consists of the byte-labeled cell grid, the anchors, the CW-complex and
+// whether anchors are redundant. cached labels are not saved.
+// all datasets are chunked. the grid is written slice by slice, such that
+// a grid in a sparse layout is never stored densely in memory.
+template<class T, class C, class LAYOUT>
+void
+save(
+    const hid_t& parentHandle,
+    const std::string& groupName,
+    const CWX<T, C, LAYOUT>& cwx
+)
+{
+    hid_t group = andres::hdf5::createGroup(parentHandle, groupName);
+    try {
+        detail::HDF5Serializer<T, C, LAYOUT>::save(group, cwx);
+    }
+    catch(...) {
+        andres::hdf5::closeGroup(group);
+        throw;
+    }
+    andres::hdf5::closeGroup(group);
+}
+
+// loads a CWX from an HDF5 group written by save. the CWX is expected to be
+// default-constructed or loaded before. its label cache is left empty.
+// the sizes of datasets, the ranges of labels and the orders and
+// coordinates of anchors are checked, but the complex is not validated
+// against the grid as this would require a traversal of the volume, cf.
+// CWX::testInvariant.
+// the grid can be loaded into a CWX of any layout, as it is read in slabs
+// of voxel slices.
+template<class T, class C, class LAYOUT>
+void
+load(
+    const hid_t& parentHandle,
+    const std::string& groupName,
+    CWX<T, C, LAYOUT>& cwx
+)
+{
+    hid_t group = andres::hdf5::openGroup(parentHandle, groupName);
+    try {
+        detail::HDF5Serializer<T, C, LAYOUT>::load(group, cwx);
+    }
+    catch(...) {
+        andres::hdf5::closeGroup(group);
+        throw;
+    }
+    andres::hdf5::closeGroup(group);
+}
+
+namespace detail {
+
+// datasets:
+// - grid: the bytes of byteLabeledCellgrid_, stored like an andres::Marray.
+//   grids are written like an array in LastMajorOrder, i.e. with the first
+//   coordinate fastest.
+// - number-of-cells: number of cells of orders 0, ..., 3
+// - redundant-anchors: 1 if anchors are redundant, 0 otherwise
+// - above-offsets-k, above-labels-k for k = 0, 1, 2: the labels of the cells
+//   above the cell of order k with label j are above-labels-k[i] for i in
+//   [above-offsets-k[j-1], above-offsets-k[j]). offsets are 64-bit unsigned
+//   integers on every platform.
+// - anchored-cells: the coordinates of the first anchor of every label,
+//   ordered by order and label
+// - anchor-cells, anchor-labels: the coordinates and labels of all other
+//   anchors, ordered by cell
+template<class T, class C, class LAYOUT>
+void
+HDF5Serializer<T, C, LAYOUT>::save(
+    const hid_t& group,
+    const CWXType& cwx
+)
+{
+    saveGrid(group, "grid", cwx.byteLabeledCellgrid_);
+
+    std::vector<Label> numberOfCells(4);
+    for(Order order = 0; order < 4; ++order) {
+        numberOfCells[order] = cwx.numberOfCells(order);
+    }
+    saveChunked(group, "number-of-cells", numberOfCells);
+    saveChunked(group, "redundant-anchors", std::vector<unsigned char>(1, cwx.redundantAnchors_));
+
+    for(Order order = 0; order < 3; ++order) {
+        std::vector<uint64_t> offsets(numberOfCells[order]);
+        std::vector<Label> labels;
+        for(Label label = 1; label <= numberOfCells[order]; ++label) {
+            for(size_t j = 0; j < cwx.sizeAbove(order, label); ++j) {
+                labels.push_back(cwx.above(order, label, j));
+            }
+            offsets[label - 1] = labels.size();
+        }
+        const char index[] = {static_cast<char>('0' + order), '\0'};
+        saveChunked(group, std::string("above-offsets-") + index, offsets);
+        saveChunked(group, std::string("above-labels-") + index, labels);
+    }
+
+    std::vector<Coordinate> anchoredCells;
+    CellType cell;
+    for(Order order = 0; order < 4; ++order) {
+        for(Label label = 1; label <= numberOfCells[order]; ++label) {
+            cwx.anchorage_.anchor(order, label, cell);
+            for(size_t j = 0; j < 3; ++j) {
+                anchoredCells.push_back(cell[j]);
+            }
+        }
+    }
+    saveChunked(group, "anchored-cells", anchoredCells);
+
+    std::vector<std::pair<CellType, Label> > anchors;
+    cwx.anchorage_.forEachAnchor([&](const CellType& anchor, const Label label) {
+        cwx.anchorage_.anchor(anchor.order(), label, cell);
+        if(anchor != cell) {
+            anchors.push_back(std::make_pair(anchor, label));
+        }
+    });
+    std::sort(anchors.begin(), anchors.end());
+    std::vector<Coordinate> anchorCells;
+    std::vector<Label> anchorLabels;
+    for(size_t j = 0; j < anchors.size(); ++j) {
+        for(size_t k = 0; k < 3; ++k) {
+            anchorCells.push_back(anchors[j].first[k]);
+        }
+        anchorLabels.push_back(anchors[j].second);
+    }
+    saveChunked(group, "anchor-cells", anchorCells);
+    saveChunked(group, "anchor-labels", anchorLabels);
+}
+
+template<class T, class C, class LAYOUT>
+void
+HDF5Serializer<T, C, LAYOUT>::load(
+    const hid_t& group,
+    CWXType& cwx
+)
+{
+    loadGrid(group, "grid", cwx.byteLabeledCellgrid_);
+
+    std::vector<Label> numberOfCells;
+    loadVector(group, "number-of-cells", numberOfCells);
+    std::vector<unsigned char> redundantAnchors;
+    loadVector(group, "redundant-anchors", redundantAnchors);
+    if(numberOfCells.size() != 4 || redundantAnchors.size() != 1) {
+        throw std::runtime_error("HDF5 group does not contain a CWX.");
+    }
+    cwx.redundantAnchors_ = redundantAnchors[0] != 0;
+
+    cwx.cwcomplex_ = typename CWXType::CWComplexType(numberOfCells[0],
+        numberOfCells[1], numberOfCells[2], numberOfCells[3]);
+    for(Order order = 0; order < 3; ++order) {
+        const char index[] = {static_cast<char>('0' + order), '\0'};
+        std::vector<uint64_t> offsets;
+        std::vector<Label> labels;
+        loadVector(group, std::string("above-offsets-") + index, offsets);
+        loadVector(group, std::string("above-labels-") + index, labels);
+        if(offsets.size() != numberOfCells[order]
+        || (!offsets.empty() && offsets.back() != labels.size())) {
+            throw std::runtime_error("HDF5 group does not contain a CWX.");
+        }
+        for(size_t j = 0; j < labels.size(); ++j) {
+            if(labels[j] == 0 || labels[j] > numberOfCells[order + 1]) {
+                throw std::runtime_error("HDF5 group does not contain a CWX.");
+            }
+        }
+        std::vector<std::pair<Label, Label> > pairs(labels.size());
+        size_t begin = 0;
+        for(Label label = 1; label <= numberOfCells[order]; ++label) {
+            const size_t end = static_cast<size_t>(offsets[label - 1]);
+            if(end < begin) {
+                throw std::runtime_error("HDF5 group does not contain a CWX.");
+            }
+            for(size_t j = begin; j < end; ++j) {
+                pairs[j] = std::make_pair(label, labels[j]);
+            }
+            begin = end;
+        }
+        cwx.cwcomplex_.connectPairs(order, pairs.begin(), pairs.end());
+    }
+
+    std::vector<Coordinate> anchoredCells;
+    std::vector<Coordinate> anchorCells;
+    std::vector<Label> anchorLabels;
+    loadVector(group, "anchored-cells", anchoredCells);
+    loadVector(group, "anchor-cells", anchorCells);
+    loadVector(group, "anchor-labels", anchorLabels);
+    if(anchoredCells.size() != 3 * (static_cast<size_t>(numberOfCells[0])
+        + numberOfCells[1] + numberOfCells[2] + numberOfCells[3])
+    || anchorCells.size() != 3 * anchorLabels.size()) {
+        throw std::runtime_error("HDF5 group does not contain a CWX.");
+    }
+    // anchors must be cells of the grid, of the order of their section and
+    // with labels of cells of that order
+    auto isInGrid = [&](const CellType& cell) {
+        for(size_t d = 0; d < 3; ++d) {
+            if(static_cast<size_t>(cell[d]) + 1 >= 2 * static_cast<size_t>(cwx.shape(d))) {
+                return false;
+            }
+        }
+        return true;
+    };
+    {
+        Order order = 0;
+        Label label = 0;
+        for(size_t j = 0; j < anchoredCells.size(); j += 3) {
+            while(label == numberOfCells[order]) {
+                ++order;
+                label = 0;
+            }
+            ++label;
+            const CellType cell(anchoredCells[j], anchoredCells[j + 1], anchoredCells[j + 2]);
+            if(cell.order() != order || !isInGrid(cell)) {
+                throw std::runtime_error("HDF5 group does not contain a CWX.");
+            }
+        }
+    }
+    for(size_t j = 0; j < anchorLabels.size(); ++j) {
+        const CellType cell(anchorCells[3 * j], anchorCells[3 * j + 1], anchorCells[3 * j + 2]);
+        if(!isInGrid(cell) || anchorLabels[j] == 0 || anchorLabels[j] > numberOfCells[cell.order()]) {
+            throw std::runtime_error("HDF5 group does not contain a CWX.");
+        }
+    }
+    cwx.anchorage_ = typename CWXType::AnchorageType();
+    cwx.anchorage_.reserve(anchoredCells.size() / 3 + anchorLabels.size());
+    for(size_t j = 0; j < anchoredCells.size(); j += 3) {
+        cwx.anchorage_.push_back(CellType(anchoredCells[j], anchoredCells[j + 1], anchoredCells[j + 2]));
+    }
+    for(size_t j = 0; j < anchorLabels.size(); ++j) {
+        cwx.anchorage_.anchor(CellType(anchorCells[3 * j], anchorCells[3 * j + 1],
+            anchorCells[3 * j + 2]), anchorLabels[j]);
+    }
+
+    cwx.labelCache_.clear();
+    cwx.buildMemory_ = 0;
+    cwx.buildStats_ = BuildStats();
+}
+
+// type of the datasets of arrays of T in files. 64-bit unsigned integers
+// are stored in little endian such that files are independent of the
+// platform, as size_t and uint64_t are unsigned long or unsigned long long.
+template<class T>
+inline hid_t
+fileType()
+{
+    return andres::hdf5::hdf5Type<T>();
+}
+
+template<>
+inline hid_t
+fileType<uint64_t>()
+{
+    return H5T_STD_U64LE;
+}
+
+// creates a new dataset of arrays of T in C order with chunks of about 1 MB
+// along the first dimension and returns its handle. if reverseShape is
+// true, the dataset is marked as written by andres::hdf5::save for an array
+// in LastMajorOrder.
+template<class T>
+hid_t
+createChunked(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    const std::vector<hsize_t>& shape,
+    const bool reverseShape
+)
+{
+    hsize_t size = 1;
+    for(size_t j = 0; j < shape.size(); ++j) {
+        size *= shape[j];
+    }
+    hid_t dataspace = H5Screate_simple(static_cast<int>(shape.size()), &shape[0], NULL);
+    if(dataspace < 0) {
+        throw std::runtime_error("cannot create HDF5 dataspace.");
+    }
+    hid_t properties = H5Pcreate(H5P_DATASET_CREATE);
+    if(size > 0) { // empty datasets cannot be chunked
+        std::vector<hsize_t> chunkShape(shape);
+        const hsize_t rowSize = size / shape[0];
+        chunkShape[0] = std::max<hsize_t>(1, std::min<hsize_t>(shape[0], (1 << 20) / sizeof(T) / rowSize));
+        H5Pset_chunk(properties, static_cast<int>(shape.size()), &chunkShape[0]);
+    }
+    hid_t dataset = H5Dcreate(groupHandle, datasetName.c_str(), fileType<T>(),
+        dataspace, H5P_DEFAULT, properties, H5P_DEFAULT);
+    H5Pclose(properties);
+    H5Sclose(dataspace);
+    if(dataset < 0) {
+        throw std::runtime_error("cannot create HDF5 dataset.");
+    }
+    if(reverseShape) {
+        const hsize_t attributeShape[] = {1};
+        const unsigned char value = 1;
+        hid_t attributeDataspace = H5Screate_simple(1, attributeShape, NULL);
+        hid_t attribute = H5Acreate(dataset, andres::hdf5::reverseShapeAttributeName,
+            H5T_STD_U8LE, attributeDataspace, H5P_DEFAULT, H5P_DEFAULT);
+        const herr_t status = attribute < 0 ? -1 : H5Awrite(attribute, H5T_NATIVE_UCHAR, &value);
+        if(attribute >= 0) {
+            H5Aclose(attribute);
+        }
+        H5Sclose(attributeDataspace);
+        if(status < 0) {
+            H5Dclose(dataset);
+            throw std::runtime_error("cannot write HDF5 attribute.");
+        }
+    }
+    return dataset;
+}
+
+// writes an array in C order to a new dataset, cf. createChunked
+template<class T>
+void
+saveChunked(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    const std::vector<hsize_t>& shape,
+    const T* data,
+    const bool reverseShape
+)
+{
+    hsize_t size = 1;
+    for(size_t j = 0; j < shape.size(); ++j) {
+        size *= shape[j];
+    }
+    hid_t dataset = createChunked<T>(groupHandle, datasetName, shape, reverseShape);
+    herr_t status = 0;
+    if(size > 0) {
+        status = H5Dwrite(dataset, andres::hdf5::hdf5Type<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+    }
+    H5Dclose(dataset);
+    if(status < 0) {
+        throw std::runtime_error("cannot write HDF5 dataset.");
+    }
+}
+
+template<class T>
+inline void
+saveChunked(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    const std::vector<T>& data
+)
+{
+    const std::vector<hsize_t> shape(1, data.size());
+    saveChunked(groupHandle, datasetName, shape, data.empty() ? 0 : &data[0]);
+}
+
+// loads a 1-dimensional dataset that may be empty
+template<class T>
+void
+loadVector(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    std::vector<T>& out
+)
+{
+    hid_t dataset = H5Dopen(groupHandle, datasetName.c_str(), H5P_DEFAULT);
+    if(dataset < 0) {
+        throw std::runtime_error("cannot open HDF5 dataset " + datasetName + ".");
+    }
+    hid_t dataspace = H5Dget_space(dataset);
+    hid_t type = H5Dget_type(dataset);
+    hid_t nativeType = H5Tget_native_type(type, H5T_DIR_DESCEND);
+    const bool typesEqual = H5Tequal(nativeType, andres::hdf5::hdf5Type<T>()) > 0;
+    H5Tclose(nativeType);
+    H5Tclose(type);
+    hsize_t size = 0;
+    if(!typesEqual || H5Sget_simple_extent_ndims(dataspace) != 1) {
+        H5Sclose(dataspace);
+        H5Dclose(dataset);
+        throw std::runtime_error("HDF5 dataset " + datasetName + " has an unexpected type or dimension.");
+    }
+    H5Sget_simple_extent_dims(dataspace, &size, NULL);
+    out.resize(static_cast<size_t>(size));
+    herr_t status = 0;
+    if(size > 0) {
+        status = H5Dread(dataset, andres::hdf5::hdf5Type<T>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, &out[0]);
+    }
+    H5Sclose(dataspace);
+    H5Dclose(dataset);
+    if(status < 0) {
+        throw std::runtime_error("cannot read HDF5 dataset " + datasetName + ".");
+    }
+}
+
+// writes the bytes of a grid with the interface of ByteLabeledCellgrid to a
+// new dataset, one voxel slice of dimension 2 at a time, like an array in
+// LastMajorOrder
+template<class GRID>
+void
+saveGrid(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    const GRID& grid
+)
+{
+    typedef typename GRID::Coordinate Coordinate;
+    std::vector<hsize_t> shape(3);
+    for(size_t j = 0; j < 3; ++j) {
+        shape[j] = grid.shape(2 - j);
+    }
+    hid_t dataset = createChunked<unsigned char>(groupHandle, datasetName, shape, true);
+    herr_t status = 0;
+    if(shape[0] * shape[1] * shape[2] > 0) {
+        hid_t dataspace = H5Dget_space(dataset);
+        const hsize_t sliceShape[] = {1, shape[1], shape[2]};
+        hid_t memspace = H5Screate_simple(3, sliceShape, NULL);
+        std::vector<unsigned char> slice(static_cast<size_t>(shape[1] * shape[2]));
+        for(Coordinate z = 0; z < grid.shape(2) && status >= 0; ++z) {
+            for(Coordinate y = 0; y < grid.shape(1); ++y)
+            for(Coordinate x = 0; x < grid.shape(0); ++x) {
+                slice[x + static_cast<size_t>(grid.shape(0)) * y] = grid(x, y, z);
+            }
+            const hsize_t offset[] = {z, 0, 0};
+            status = H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, offset, NULL, sliceShape, NULL);
+            if(status >= 0) {
+                status = H5Dwrite(dataset, andres::hdf5::hdf5Type<unsigned char>(), memspace, dataspace, H5P_DEFAULT, &slice[0]);
+            }
+        }
+        H5Sclose(memspace);
+        H5Sclose(dataspace);
+    }
+    H5Dclose(dataset);
+    if(status < 0) {
+        throw std::runtime_error("cannot write HDF5 dataset.");
+    }
+}
+
+// loads the bytes of a grid with the interface of ByteLabeledCellgrid from a
+// dataset written by saveGrid or by andres::hdf5::save, in slabs of voxel
+// slices of about 1 MB
+template<class GRID>
+void
+loadGrid(
+    const hid_t& groupHandle,
+    const std::string& datasetName,
+    GRID& grid
+)
+{
+    typedef typename GRID::Coordinate Coordinate;
+    std::vector<size_t> shape;
+    andres::hdf5::loadShape(groupHandle, datasetName, shape);
+    if(shape.size() != 3) {
+        throw std::runtime_error("grid is not 3-dimensional.");
+    }
+    grid.resize(static_cast<Coordinate>(shape[0]), static_cast<Coordinate>(shape[1]), static_cast<Coordinate>(shape[2]));
+    const size_t slabSize = std::max<size_t>(1, (1 << 20) / std::max<size_t>(1, shape[0] * shape[1]));
+    andres::Marray<unsigned char> slab;
+    for(size_t z = 0; z < shape[2]; z += slabSize) {
+        const size_t base[] = {0, 0, z};
+        const size_t slabShape[] = {shape[0], shape[1], std::min(slabSize, shape[2] - z)};
+        andres::hdf5::loadHyperslab(groupHandle, datasetName, base, base + 3, slabShape, slab);
+        grid.assignSlices(static_cast<Coordinate>(z), slab);
+    }
+}
+
+} // namespace detail
+
+} // namespace cwx
+
+#endif // #ifndef CWX_HDF5_HXX
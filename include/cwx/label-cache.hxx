@@ -0,0 +1,174 @@
+#pragma once
+#ifndef CWX_LABEL_CACHE_HXX
+#define CWX_LABEL_CACHE_HXX
+
+#include <cassert>
+#include <vector>
+
+#include "cwx/cell.hxx"
+#include "cwx/cell-map.hxx"
+
+namespace cwx {
+
+/// materialized labels of connected components.
+///
+/// the labels of 3-cells are stored in a dense array with one entry per
+/// voxel. optionally, the labels of marked 1- and 2-cells are stored in a
+/// sparse map. the labels of 0-cells are not cached as they are anchors.
+template<class T, class C>
+class LabelCache {
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef Cell<Coordinate> CellType;
+    typedef typename CellType::Order Order;
+
+    LabelCache();
+
+    // query
+    bool empty() const;
+    bool hasBoundaryCells() const;
+    size_t memory() const;
+    Label atVoxel(const Coordinate, const Coordinate, const Coordinate) const;
+    Label atCell(const CellType&) const;
+
+    // manipulation
+    void assign(const Coordinate, const Coordinate, const Coordinate, const bool);
+    void insert(const CellType&, const Label);
+    void erase(const CellType&);
+    void clear();
+
+private:
+    Coordinate shape_[2];
+    std::vector<Label> voxelLabels_;
+    CellMap<Label, Coordinate> boundaryLabels_;
+    bool hasBoundaryCells_;
+};
+
+template<class T, class C>
+inline
+LabelCache<T, C>::LabelCache()
+:   voxelLabels_(),
+    boundaryLabels_(),
+    hasBoundaryCells_(false)
+{
+    shape_[0] = 0;
+    shape_[1] = 0;
+}
+
+template<class T, class C>
+inline bool
+LabelCache<T, C>::empty() const
+{
+    return voxelLabels_.empty();
+}
+
+template<class T, class C>
+inline bool
+LabelCache<T, C>::hasBoundaryCells() const
+{
+    return hasBoundaryCells_;
+}
+
+// returns the number of bytes allocated for the cache
+template<class T, class C>
+inline size_t
+LabelCache<T, C>::memory() const
+{
+    return voxelLabels_.capacity() * sizeof(Label) + boundaryLabels_.memory();
+}
+
+template<class T, class C>
+inline typename LabelCache<T, C>::Label
+LabelCache<T, C>::atVoxel(
+    const Coordinate x,
+    const Coordinate y,
+    const Coordinate z
+) const
+{
+    assert(!empty());
+    assert(x < shape_[0] && y < shape_[1]);
+    return voxelLabels_[x + static_cast<size_t>(shape_[0]) * (y + static_cast<size_t>(shape_[1]) * z)];
+}
+
+// returns 0 for 1- and 2-cells that are not marked.
+// precondition: cell is a 3-cell, or boundary cells are cached.
+template<class T, class C>
+inline typename LabelCache<T, C>::Label
+LabelCache<T, C>::atCell(
+    const CellType& cell
+) const
+{
+    const Order order = cell.order();
+    assert(order != 0);
+    if(order == 3) {
+        return atVoxel(cell[0] / 2, cell[1] / 2, cell[2] / 2);
+    }
+    else {
+        assert(hasBoundaryCells_);
+        return boundaryLabels_[cell];
+    }
+}
+
+// allocates the dense array for a volume of the given shape. all labels
+// are 0 initially.
+template<class T, class C>
+void
+LabelCache<T, C>::assign(
+    const Coordinate shape0,
+    const Coordinate shape1,
+    const Coordinate shape2,
+    const bool boundaryCells
+)
+{
+    clear();
+    shape_[0] = shape0;
+    shape_[1] = shape1;
+    voxelLabels_.resize(static_cast<size_t>(shape0) * shape1 * shape2);
+    hasBoundaryCells_ = boundaryCells;
+}
+
+template<class T, class C>
+inline void
+LabelCache<T, C>::insert(
+    const CellType& cell,
+    const Label label
+)
+{
+    assert(label != 0);
+    if(cell.order() == 3) {
+        voxelLabels_[cell[0] / 2 + static_cast<size_t>(shape_[0])
+            * (cell[1] / 2 + static_cast<size_t>(shape_[1]) * (cell[2] / 2))] = label;
+    }
+    else {
+        assert(cell.order() != 0 && hasBoundaryCells_);
+        boundaryLabels_.insert(cell, label);
+    }
+}
+
+// removes the label of a 1- or 2-cell that is no longer marked
+template<class T, class C>
+inline void
+LabelCache<T, C>::erase(
+    const CellType& cell
+)
+{
+    assert(cell.order() == 1 || cell.order() == 2);
+    assert(hasBoundaryCells_);
+    boundaryLabels_.erase(cell);
+}
+
+template<class T, class C>
+inline void
+LabelCache<T, C>::clear()
+{
+    std::vector<Label>().swap(voxelLabels_);
+    boundaryLabels_.clear();
+    hasBoundaryCells_ = false;
+    shape_[0] = 0;
+    shape_[1] = 0;
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_LABEL_CACHE_HXX
@@ -0,0 +1,687 @@
+#pragma once
+#ifndef CWX_MAPPED_CWX_HXX
+#define CWX_MAPPED_CWX_HXX
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "cwx/cwx.hxx"
+
+namespace cwx {
+
+namespace detail {
+
+// header of the binary format written by saveMapped. all numbers in the
+// file are little-endian. the header is followed by the sections below,
+// each at an offset that is a multiple of 64 bytes:
+// - grid: one byte per voxel as in ByteLabeledCellgrid, first coordinate
+//   fastest
+// - anchored cells: the coordinates (Coordinate[3]) of the first anchor of
+//   every label, ordered by order and label
+// - anchor keys: the packed coordinates (uint64, cf. packCell) of all
+//   anchors, sorted
+// - anchor labels: the labels (Label) of the anchors, in the same order
+// - above offsets and above labels for orders 0, 1, 2: the labels of the
+//   cells above the cell of order k with label j are aboveLabels[k][i] for
+//   i in [aboveOffsets[k][j-1], aboveOffsets[k][j]) (offsets are uint64)
+// - below offsets and below labels for orders 1, 2, 3, accordingly
+struct MappedHeader {
+    enum Section {
+        GridSection,
+        AnchoredCellsSection,
+        AnchorKeysSection,
+        AnchorLabelsSection,
+        AboveOffsetsSection, // + order, for orders 0, 1, 2
+        AboveLabelsSection = AboveOffsetsSection + 3, // + order
+        BelowOffsetsSection = AboveLabelsSection + 3, // + order - 1, for orders 1, 2, 3
+        BelowLabelsSection = BelowOffsetsSection + 3, // + order - 1
+        NumberOfSections = BelowLabelsSection + 3
+    };
+
+    char magic[8];
+    uint32_t version;
+    uint8_t labelSize;
+    uint8_t coordinateSize;
+    uint8_t redundantAnchors;
+    uint8_t reserved;
+    uint64_t shape[3];
+    uint64_t numberOfCells[4];
+    uint64_t numberOfAnchors;
+    uint64_t sectionOffsets[NumberOfSections];
+    uint64_t sectionSizes[NumberOfSections]; // in bytes
+    uint64_t fileSize;
+};
+
+static const char mappedMagic[8] = {'C', 'W', 'X', 'M', 'A', 'P', '\0', '\0'};
+static const uint32_t mappedVersion = 1;
+
+bool isLittleEndian();
+
+// for INTERNAL use with saveMapped
+template<class T, class C, class LAYOUT>
+class MappedWriter {
+public:
+    static void save(const std::string&, const CWX<T, C, LAYOUT>&);
+};
+
+} // namespace detail
+
+template<class T, class C, class LAYOUT>
+    void saveMapped(const std::string&, const CWX<T, C, LAYOUT>&);
+
+/// read-only CWX backed by a memory-mapped file written by saveMapped.
+///
+/// opening a file maps it into memory without reading or copying it. pages
+/// are read on demand and shared through the page cache among all processes
+/// that map the same file. anchors are found by binary search in the sorted
+/// array of anchors. the query interface is that of CWX. offsets, labels
+/// and anchors are validated in one pass on opening, such that a corrupt
+/// file throws instead of causing reads beyond the mapping.
+///
+/// the format is little-endian. it is not supported on big-endian machines.
+template<class T, class C>
+class MappedCWX {
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef ByteLabeledCellgridView<Label, Coordinate> GridType;
+    typedef typename GridType::Order Order;
+    typedef typename GridType::CellType CellType;
+    typedef typename GridType::CellVector CellVector;
+    typedef TraversalWorkspace<Coordinate> TraversalWorkspaceType;
+
+    MappedCWX(const std::string&);
+    ~MappedCWX();
+
+    // query
+    Coordinate shape(const Order) const;
+    Label numberOfCells(const Order) const;
+    size_t sizeAbove(const Order, const Label) const;
+    size_t sizeBelow(const Order, const Label) const;
+    Label above(const Order, const Label, const size_t) const;
+    void above(const CellType&, CellVector&) const;
+    Label below(const Order, const Label, const size_t) const;
+    void below(const CellType&, CellVector&) const;
+    Label atVoxel(const Coordinate, const Coordinate, const Coordinate) const;
+    Label atCell(const CellType&) const;
+    Label atCell(const CellType&, TraversalWorkspaceType&) const;
+    bool isMarked(const CellType&) const;
+    bool redundantAnchors() const;
+    const GridType& grid() const;
+
+    template<class FUNCTOR> void process(const Order, const Label, FUNCTOR&) const;
+    template<class FUNCTOR> void process(const Order, const Label, FUNCTOR&, TraversalWorkspaceType&) const;
+
+private:
+    typedef detail::MappedHeader Header;
+
+    MappedCWX(const MappedCWX&);
+    MappedCWX& operator=(const MappedCWX&);
+    void open(const std::string&);
+    template<class U> const U* section(const size_t, const size_t) const;
+    Label anchor(const CellType&) const;
+    void anchor(const Order, const Label, CellType&) const;
+
+    void* data_;
+    size_t size_;
+    const Header* header_;
+    GridType grid_;
+    const Coordinate* anchoredCells_;
+    const uint64_t* anchorKeys_;
+    const Label* anchorLabels_;
+    const uint64_t* aboveOffsets_[3];
+    const Label* aboveLabels_[3];
+    const uint64_t* belowOffsets_[4]; // indexed by order, entry 0 unused
+    const Label* belowLabels_[4];
+};
+
+namespace detail {
+
+inline bool
+isLittleEndian()
+{
+    const uint32_t one = 1;
+    unsigned char byte;
+    std::memcpy(&byte, &one, 1);
+    return byte == 1;
+}
+
+template<class T, class C, class LAYOUT>
+void
+MappedWriter<T, C, LAYOUT>::save(
+    const std::string& fileName,
+    const CWX<T, C, LAYOUT>& cwx
+)
+{
+    typedef CWX<T, C, LAYOUT> CWXType;
+    typedef typename CWXType::Label Label;
+    typedef typename CWXType::Coordinate Coordinate;
+    typedef typename CWXType::Order Order;
+    typedef typename CWXType::CellType CellType;
+    typedef MappedHeader Header;
+
+    if(!isLittleEndian()) {
+        throw std::runtime_error("the binary CWX format is not supported on big-endian machines.");
+    }
+
+    // sections other than the grid
+    std::vector<Coordinate> anchoredCells;
+    CellType cell;
+    for(Order order = 0; order < 4; ++order) {
+        for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+            cwx.anchorage_.anchor(order, label, cell);
+            for(size_t j = 0; j < 3; ++j) {
+                anchoredCells.push_back(cell[j]);
+            }
+        }
+    }
+    std::vector<std::pair<uint64_t, Label> > anchors;
+    anchors.reserve(cwx.anchorage_.numberOfAnchors());
+    cwx.anchorage_.forEachAnchor([&](const CellType& anchor, const Label label) {
+        anchors.push_back(std::make_pair(packCell(anchor), label));
+    });
+    std::sort(anchors.begin(), anchors.end());
+    std::vector<uint64_t> anchorKeys(anchors.size());
+    std::vector<Label> anchorLabels(anchors.size());
+    for(size_t j = 0; j < anchors.size(); ++j) {
+        anchorKeys[j] = anchors[j].first;
+        anchorLabels[j] = anchors[j].second;
+    }
+    std::vector<std::vector<uint64_t> > offsets(6);
+    std::vector<std::vector<Label> > labels(6);
+    for(Order order = 0; order < 4; ++order) {
+        for(size_t direction = 0; direction < 2; ++direction) { // 0: above, 1: below
+            if((direction == 0 && order == 3) || (direction == 1 && order == 0)) {
+                continue;
+            }
+            const size_t k = direction == 0 ? order : 3 + order - 1;
+            offsets[k].push_back(0);
+            for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+                if(direction == 0) {
+                    for(size_t j = 0; j < cwx.sizeAbove(order, label); ++j) {
+                        labels[k].push_back(cwx.above(order, label, j));
+                    }
+                }
+                else {
+                    for(size_t j = 0; j < cwx.sizeBelow(order, label); ++j) {
+                        labels[k].push_back(cwx.below(order, label, j));
+                    }
+                }
+                offsets[k].push_back(labels[k].size());
+            }
+        }
+    }
+
+    // header
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, mappedMagic, sizeof(header.magic));
+    header.version = mappedVersion;
+    header.labelSize = sizeof(Label);
+    header.coordinateSize = sizeof(Coordinate);
+    header.redundantAnchors = cwx.redundantAnchors_;
+    for(size_t j = 0; j < 3; ++j) {
+        header.shape[j] = cwx.shape(j);
+    }
+    for(Order order = 0; order < 4; ++order) {
+        header.numberOfCells[order] = cwx.numberOfCells(order);
+    }
+    header.numberOfAnchors = anchors.size();
+    std::vector<const char*> sectionData(Header::NumberOfSections, static_cast<const char*>(0));
+    header.sectionSizes[Header::GridSection] = header.shape[0] * header.shape[1] * header.shape[2];
+    header.sectionSizes[Header::AnchoredCellsSection] = anchoredCells.size() * sizeof(Coordinate);
+    sectionData[Header::AnchoredCellsSection] = reinterpret_cast<const char*>(anchoredCells.data());
+    header.sectionSizes[Header::AnchorKeysSection] = anchorKeys.size() * sizeof(uint64_t);
+    sectionData[Header::AnchorKeysSection] = reinterpret_cast<const char*>(anchorKeys.data());
+    header.sectionSizes[Header::AnchorLabelsSection] = anchorLabels.size() * sizeof(Label);
+    sectionData[Header::AnchorLabelsSection] = reinterpret_cast<const char*>(anchorLabels.data());
+    for(size_t k = 0; k < 6; ++k) {
+        const size_t offsetsSection = k < 3 ? Header::AboveOffsetsSection + k : Header::BelowOffsetsSection + k - 3;
+        const size_t labelsSection = k < 3 ? Header::AboveLabelsSection + k : Header::BelowLabelsSection + k - 3;
+        header.sectionSizes[offsetsSection] = offsets[k].size() * sizeof(uint64_t);
+        sectionData[offsetsSection] = reinterpret_cast<const char*>(offsets[k].data());
+        header.sectionSizes[labelsSection] = labels[k].size() * sizeof(Label);
+        sectionData[labelsSection] = reinterpret_cast<const char*>(labels[k].data());
+    }
+    uint64_t offset = sizeof(Header);
+    for(size_t j = 0; j < Header::NumberOfSections; ++j) {
+        offset = (offset + 63) / 64 * 64;
+        header.sectionOffsets[j] = offset;
+        offset += header.sectionSizes[j];
+    }
+    header.fileSize = offset;
+
+    // write
+    std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("cannot open " + fileName + " for writing.");
+    }
+    const char padding[64] = {0};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    uint64_t position = sizeof(Header);
+    for(size_t j = 0; j < Header::NumberOfSections; ++j) {
+        file.write(padding, header.sectionOffsets[j] - position);
+        if(j == Header::GridSection) {
+            std::vector<unsigned char> row(cwx.shape(0));
+            for(Coordinate z = 0; z < cwx.shape(2); ++z)
+            for(Coordinate y = 0; y < cwx.shape(1); ++y) {
+                for(Coordinate x = 0; x < cwx.shape(0); ++x) {
+                    row[x] = cwx.byteLabeledCellgrid_(x, y, z);
+                }
+                file.write(reinterpret_cast<const char*>(row.data()), row.size());
+            }
+        }
+        else if(header.sectionSizes[j] != 0) {
+            file.write(sectionData[j], header.sectionSizes[j]);
+        }
+        position = header.sectionOffsets[j] + header.sectionSizes[j];
+    }
+    if(!file) {
+        throw std::runtime_error("cannot write " + fileName + ".");
+    }
+}
+
+} // namespace detail
+
+// writes the complete state of a CWX to a file that can be opened as a
+// MappedCWX. cached labels are not written. the grid is written row by row,
+// such that a CWX of any layout can be saved.
+template<class T, class C, class LAYOUT>
+inline void
+saveMapped(
+    const std::string& fileName,
+    const CWX<T, C, LAYOUT>& cwx
+)
+{
+    detail::MappedWriter<T, C, LAYOUT>::save(fileName, cwx);
+}
+
+template<class T, class C>
+inline
+MappedCWX<T, C>::MappedCWX(
+    const std::string& fileName
+)
+:   data_(MAP_FAILED),
+    size_(0),
+    header_(0),
+    grid_()
+{
+    try {
+        open(fileName);
+    }
+    catch(...) {
+        if(data_ != MAP_FAILED) {
+            munmap(data_, size_);
+        }
+        throw;
+    }
+}
+
+template<class T, class C>
+inline
+MappedCWX<T, C>::~MappedCWX()
+{
+    munmap(data_, size_);
+}
+
+template<class T, class C>
+void
+MappedCWX<T, C>::open(
+    const std::string& fileName
+)
+{
+    if(!detail::isLittleEndian()) {
+        throw std::runtime_error("the binary CWX format is not supported on big-endian machines.");
+    }
+    const int file = ::open(fileName.c_str(), O_RDONLY);
+    if(file < 0) {
+        throw std::runtime_error("cannot open " + fileName + ".");
+    }
+    struct stat status;
+    if(fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) {
+        close(file);
+        throw std::runtime_error(fileName + " is not a binary CWX file.");
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    data_ = mmap(0, size_, PROT_READ, MAP_SHARED, file, 0);
+    close(file); // the mapping remains valid
+    if(data_ == MAP_FAILED) {
+        throw std::runtime_error("cannot map " + fileName + ".");
+    }
+
+    header_ = static_cast<const Header*>(data_);
+    if(std::memcmp(header_->magic, detail::mappedMagic, sizeof(header_->magic)) != 0
+    || header_->fileSize != size_) {
+        throw std::runtime_error(fileName + " is not a binary CWX file.");
+    }
+    if(header_->version != detail::mappedVersion) {
+        throw std::runtime_error(fileName + " has an unsupported version.");
+    }
+    if(header_->labelSize != sizeof(Label) || header_->coordinateSize != sizeof(Coordinate)) {
+        throw std::runtime_error(fileName + " has labels or coordinates of a different size.");
+    }
+
+    size_t numberOfCells = 0;
+    for(Order order = 0; order < 4; ++order) {
+        numberOfCells += header_->numberOfCells[order];
+    }
+    grid_ = GridType(header_->shape[0], header_->shape[1], header_->shape[2],
+        section<unsigned char>(Header::GridSection, header_->shape[0] * header_->shape[1] * header_->shape[2]));
+    anchoredCells_ = section<Coordinate>(Header::AnchoredCellsSection, 3 * numberOfCells);
+    anchorKeys_ = section<uint64_t>(Header::AnchorKeysSection, header_->numberOfAnchors);
+    anchorLabels_ = section<Label>(Header::AnchorLabelsSection, header_->numberOfAnchors);
+    for(Order order = 0; order < 4; ++order) {
+        if(order < 3) {
+            aboveOffsets_[order] = section<uint64_t>(Header::AboveOffsetsSection + order, header_->numberOfCells[order] + 1);
+            aboveLabels_[order] = section<Label>(Header::AboveLabelsSection + order, aboveOffsets_[order][header_->numberOfCells[order]]);
+        }
+        if(order > 0) {
+            belowOffsets_[order] = section<uint64_t>(Header::BelowOffsetsSection + order - 1, header_->numberOfCells[order] + 1);
+            belowLabels_[order] = section<Label>(Header::BelowLabelsSection + order - 1, belowOffsets_[order][header_->numberOfCells[order]]);
+        }
+    }
+
+    // one pass over offsets, labels and anchor keys, such that queries
+    // never read beyond the mapping
+    for(Order order = 0; order < 4; ++order) {
+        for(size_t direction = 0; direction < 2; ++direction) { // 0: above, 1: below
+            if((direction == 0 && order == 3) || (direction == 1 && order == 0)) {
+                continue;
+            }
+            const uint64_t* offsets = direction == 0 ? aboveOffsets_[order] : belowOffsets_[order];
+            const Label* labels = direction == 0 ? aboveLabels_[order] : belowLabels_[order];
+            const uint64_t maxLabel = header_->numberOfCells[direction == 0 ? order + 1 : order - 1];
+            if(offsets[0] != 0) {
+                throw std::runtime_error("binary CWX file is corrupt.");
+            }
+            for(size_t j = 0; j < header_->numberOfCells[order]; ++j) {
+                if(offsets[j + 1] < offsets[j]) {
+                    throw std::runtime_error("binary CWX file is corrupt.");
+                }
+            }
+            for(uint64_t j = 0; j < offsets[header_->numberOfCells[order]]; ++j) {
+                if(labels[j] == 0 || labels[j] > maxLabel) {
+                    throw std::runtime_error("binary CWX file is corrupt.");
+                }
+            }
+        }
+    }
+    for(size_t j = 1; j < header_->numberOfAnchors; ++j) {
+        if(anchorKeys_[j] <= anchorKeys_[j - 1]) {
+            throw std::runtime_error("binary CWX file is corrupt.");
+        }
+    }
+}
+
+// returns a pointer to a section of the given number of elements
+template<class T, class C>
+template<class U>
+inline const U*
+MappedCWX<T, C>::section(
+    const size_t j,
+    const size_t size
+) const
+{
+    const uint64_t offset = header_->sectionOffsets[j];
+    if(offset % 64 != 0 || header_->sectionSizes[j] != size * sizeof(U)
+    || offset > size_ || header_->sectionSizes[j] > size_ - offset) {
+        throw std::runtime_error("binary CWX file is corrupt.");
+    }
+    return reinterpret_cast<const U*>(static_cast<const char*>(data_) + offset);
+}
+
+template<class T, class C>
+inline typename MappedCWX<T, C>::Coordinate
+MappedCWX<T, C>::shape(
+    const Order d
+) const
+{
+    return grid_.shape(d);
+}
+
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::numberOfCells(
+    const Order order
+) const
+{
+    assert(order < 4);
+    return static_cast<Label>(header_->numberOfCells[order]);
+}
+
+template<class T, class C>
+inline size_t
+MappedCWX<T, C>::sizeAbove(
+    const Order order,
+    const Label label
+) const
+{
+    assert(order < 3);
+    assert(label > 0 && label <= numberOfCells(order));
+    return aboveOffsets_[order][label] - aboveOffsets_[order][label - 1];
+}
+
+template<class T, class C>
+inline size_t
+MappedCWX<T, C>::sizeBelow(
+    const Order order,
+    const Label label
+) const
+{
+    assert(order > 0 && order < 4);
+    assert(label > 0 && label <= numberOfCells(order));
+    return belowOffsets_[order][label] - belowOffsets_[order][label - 1];
+}
+
+// returns 0 if j >= sizeAbove(order, label), as CWX::above
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::above(
+    const Order order,
+    const Label label,
+    const size_t j
+) const
+{
+    if(order == 3) {
+        throw std::runtime_error("order 3 is not applicable here");
+    }
+    if(j >= sizeAbove(order, label)) {
+        return 0;
+    }
+    return aboveLabels_[order][aboveOffsets_[order][label - 1] + j];
+}
+
+template<class T, class C>
+inline void
+MappedCWX<T, C>::above(
+    const CellType& cell,
+    CellVector& above
+) const
+{
+    grid_.above(cell, above);
+}
+
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::below(
+    const Order order,
+    const Label label,
+    const size_t j
+) const
+{
+    if(order == 0) {
+        throw std::runtime_error("order 0 is not applicable here");
+    }
+    assert(j < sizeBelow(order, label));
+    return belowLabels_[order][belowOffsets_[order][label - 1] + j];
+}
+
+template<class T, class C>
+inline void
+MappedCWX<T, C>::below(
+    const CellType& cell,
+    CellVector& below
+) const
+{
+    grid_.below(cell, below);
+}
+
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::atVoxel(
+    const Coordinate x,
+    const Coordinate y,
+    const Coordinate z
+) const
+{
+    return atCell(CellType(2*x, 2*y, 2*z));
+}
+
+// uses a workspace of the calling thread
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::atCell(
+    const CellType& cell
+) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    return atCell(cell, lease.workspace());
+}
+
+template<class T, class C>
+typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::atCell(
+    const CellType& cell,
+    TraversalWorkspaceType& workspace
+) const
+{
+    const Order order = cell.order();
+    if(order == 0) {
+        assert(grid_.isAnchored(cell));
+        return anchor(cell);
+    }
+    else if(order == 3 || grid_.isMarked(cell)) {
+        Label label = 0;
+        detail::traverseComponent(grid_, cell, [&](const CellType& c) {
+            if(grid_.isAnchored(c)) { // if anchor found
+                label = anchor(c); // 0 if the anchor has no label for this cell
+            }
+            return label == 0;
+        }, workspace);
+        if(label == 0) {
+            throw std::runtime_error("no anchor found.");
+        }
+        return label;
+    }
+    else {
+        return 0;
+    }
+}
+
+template<class T, class C>
+inline bool
+MappedCWX<T, C>::isMarked(
+    const CellType& cell
+) const
+{
+    return grid_.isMarked(cell);
+}
+
+template<class T, class C>
+inline bool
+MappedCWX<T, C>::redundantAnchors() const
+{
+    return header_->redundantAnchors != 0;
+}
+
+template<class T, class C>
+inline const typename MappedCWX<T, C>::GridType&
+MappedCWX<T, C>::grid() const
+{
+    return grid_;
+}
+
+// process one connected component, using a workspace of the calling thread
+template<class T, class C>
+template<class FUNCTOR>
+inline void
+MappedCWX<T, C>::process(
+    const Order order,
+    const Label label,
+    FUNCTOR& functor
+) const
+{
+    detail::WorkspaceLease<Coordinate> lease;
+    process(order, label, functor, lease.workspace());
+}
+
+// process one connected component
+template<class T, class C>
+template<class FUNCTOR>
+void
+MappedCWX<T, C>::process(
+    const Order order,
+    const Label label,
+    FUNCTOR& functor,
+    TraversalWorkspaceType& workspace
+) const
+{
+    assert(label > 0 && label <= numberOfCells(order));
+    CellType cell;
+    anchor(order, label, cell);
+    if(order == 0) {
+        functor(cell);
+    }
+    else {
+        detail::traverseComponent(grid_, cell, [&](const CellType& c) {
+            return functor(c);
+        }, workspace);
+    }
+}
+
+// returns 0 if the cell is not an anchor
+template<class T, class C>
+inline typename MappedCWX<T, C>::Label
+MappedCWX<T, C>::anchor(
+    const CellType& cell
+) const
+{
+    const uint64_t key = detail::packCell(cell);
+    const uint64_t* end = anchorKeys_ + header_->numberOfAnchors;
+    const uint64_t* it = std::lower_bound(anchorKeys_, end, key);
+    if(it == end || *it != key) {
+        return 0;
+    }
+    return anchorLabels_[it - anchorKeys_];
+}
+
+// the first anchor of a label
+template<class T, class C>
+inline void
+MappedCWX<T, C>::anchor(
+    const Order order,
+    const Label label,
+    CellType& cell
+) const
+{
+    size_t j = label - 1;
+    for(Order k = 0; k < order; ++k) {
+        j += header_->numberOfCells[k];
+    }
+    cell = CellType(anchoredCells_[3 * j], anchoredCells_[3 * j + 1], anchoredCells_[3 * j + 2]);
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_MAPPED_CWX_HXX
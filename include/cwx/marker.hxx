@@ -0,0 +1,338 @@
+#pragma once
+#ifndef CWX_MARKER_HXX
+#define CWX_MARKER_HXX
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#include "marray.hxx"
+#include "cwx/byte-labeled-cellgrid.hxx"
+
+namespace cwx {
+namespace detail {
+
+/// marking engine that operates on whole rows of voxels.
+///
+/// a row is a sequence of voxels along the dimension in which the bytes of
+/// the ByteLabeledCellgrid are contiguous in memory. all cells that are
+/// encoded in one byte are marked at once, with loops over plain arrays
+/// that the compiler can vectorize.
+///
+/// the functions return false (and leave the grid unchanged) if the
+/// memory layout does not permit the row-wise treatment, e.g. for views
+/// whose voxels are not contiguous along the row dimension. callers are
+/// expected to fall back to cell-wise marking in this case.
+template<class T, class C, class LAYOUT = LinearLayout>
+class Marker {
+public:
+    typedef T Label;
+    typedef C Coordinate;
+    typedef ByteLabeledCellgrid<Label, Coordinate, LAYOUT> ByteLabeledCellgridType;
+    typedef typename ByteLabeledCellgridType::CellType CellType;
+    typedef typename ByteLabeledCellgridType::Order Order;
+
+    Marker(ByteLabeledCellgridType&);
+    template<class U, bool B>
+        bool markBoundaries(const andres::View<U, B>&, const Coordinate, const Coordinate, const Coordinate = 0);
+    bool mark(const Order, const Coordinate, const Coordinate, std::vector<CellType>&);
+
+private:
+    size_t rows(const Coordinate, const Coordinate) const;
+    void row(const size_t, const Coordinate, const Coordinate, Coordinate*, Coordinate&) const;
+    void markRows1(const Coordinate, const Coordinate);
+    void markRows0(const Coordinate, const Coordinate, std::vector<CellType>&);
+
+    ByteLabeledCellgridType& grid_;
+    bool contiguous_;
+    size_t shape_[3];
+    size_t d_[3]; // d_[0]: row dimension, d_[1], d_[2]: remaining dimensions
+    std::vector<unsigned char> buffer_;
+
+    // bit of the 2-cell normal to dimension d, of the 1-cell along dimension d
+    static const unsigned char bit2_[3];
+    static const unsigned char bit1_[3];
+};
+
+template<class T, class C, class LAYOUT>
+const unsigned char Marker<T, C, LAYOUT>::bit2_[3] = {8, 2, 1};
+
+template<class T, class C, class LAYOUT>
+const unsigned char Marker<T, C, LAYOUT>::bit1_[3] = {4, 16, 32};
+
+template<class T, class C, class LAYOUT>
+inline
+Marker<T, C, LAYOUT>::Marker(
+    ByteLabeledCellgridType& grid
+)
+:   grid_(grid),
+    contiguous_(false),
+    buffer_()
+{
+    for(size_t j = 0; j < 3; ++j) {
+        shape_[j] = grid.shape(j);
+    }
+    for(size_t j = 0; j < 3; ++j) {
+        if(grid.grid_.isContiguous(j)) {
+            contiguous_ = true;
+            d_[0] = j;
+            d_[1] = j == 0 ? 1 : 0;
+            d_[2] = j == 2 ? 1 : 2;
+            break;
+        }
+    }
+    assert(ByteLabeledCellgridType::byte_[1][0][0] == bit2_[0]);
+    assert(ByteLabeledCellgridType::byte_[0][1][0] == bit2_[1]);
+    assert(ByteLabeledCellgridType::byte_[0][0][1] == bit2_[2]);
+    assert(ByteLabeledCellgridType::byte_[0][1][1] == bit1_[0]);
+    assert(ByteLabeledCellgridType::byte_[1][0][1] == bit1_[1]);
+    assert(ByteLabeledCellgridType::byte_[1][1][0] == bit1_[2]);
+}
+
+// marks the 2-cells between voxels of different labels in all rows whose
+// voxel coordinate in dimension 2 is in [sliceBegin, sliceEnd). the view
+// holds the voxel slices of dimension 2 from offset on.
+template<class T, class C, class LAYOUT>
+template<class U, bool B>
+bool
+Marker<T, C, LAYOUT>::markBoundaries(
+    const andres::View<U, B>& volumeLabeling,
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    const Coordinate offset
+)
+{
+    assert(offset <= sliceBegin);
+    if(!contiguous_ || volumeLabeling.strides(d_[0]) != 1) {
+        return false;
+    }
+    const unsigned char bitR = bit2_[d_[0]];
+    const unsigned char bitP = bit2_[d_[1]];
+    const unsigned char bitQ = bit2_[d_[2]];
+    const unsigned char keep = static_cast<unsigned char>(~(bitR | bitP | bitQ));
+    const size_t numberOfRows = rows(sliceBegin, sliceEnd);
+    Coordinate c[3];
+    Coordinate length;
+    for(size_t j = 0; j < numberOfRows; ++j) {
+        row(j, sliceBegin, sliceEnd, c, length);
+        const U* v = &volumeLabeling(c[0], c[1], c[2] - offset);
+        const U* vp = v; // compares equal if there is no next row
+        const U* vq = v;
+        if(c[d_[1]] + 1 < shape_[d_[1]]) {
+            ++c[d_[1]];
+            vp = &volumeLabeling(c[0], c[1], c[2] - offset);
+            --c[d_[1]];
+        }
+        if(c[d_[2]] + 1 < shape_[d_[2]]) {
+            ++c[d_[2]];
+            vq = &volumeLabeling(c[0], c[1], c[2] - offset);
+            --c[d_[2]];
+        }
+        unsigned char* g = &grid_.grid_(c[0], c[1], c[2]);
+        // the last voxel of the volume has no successor in the row
+        const size_t n = c[d_[0]] + length == shape_[d_[0]] ? length - 1 : length;
+        for(size_t k = 0; k < n; ++k) {
+            g[k] = (g[k] & keep)
+                | (v[k] != v[k + 1] ? bitR : 0)
+                | (v[k] != vp[k] ? bitP : 0)
+                | (v[k] != vq[k] ? bitQ : 0);
+        }
+        for(size_t k = n; k < length; ++k) {
+            g[k] = (g[k] & keep)
+                | (v[k] != vp[k] ? bitP : 0)
+                | (v[k] != vq[k] ? bitQ : 0);
+        }
+    }
+    return true;
+}
+
+// marks the 1-cells (order == 1) or 0-cells (order == 0) in all rows whose
+// voxel coordinate in dimension 2 is in [sliceBegin, sliceEnd), based on
+// the marks of the cells of order + 1. marked 0-cells are also anchored
+// and appended to zeroCells (not necessarily in scan order).
+template<class T, class C, class LAYOUT>
+bool
+Marker<T, C, LAYOUT>::mark(
+    const Order order,
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    std::vector<CellType>& zeroCells
+)
+{
+    assert(order < 2);
+    if(!contiguous_) {
+        return false;
+    }
+    if(order == 1) {
+        markRows1(sliceBegin, sliceEnd);
+    }
+    else {
+        markRows0(sliceBegin, sliceEnd, zeroCells);
+    }
+    return true;
+}
+
+template<class T, class C, class LAYOUT>
+void
+Marker<T, C, LAYOUT>::markRows1(
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd
+)
+{
+    const unsigned char r = bit2_[d_[0]];
+    const unsigned char p = bit2_[d_[1]];
+    const unsigned char q = bit2_[d_[2]];
+    const unsigned char bitR = bit1_[d_[0]];
+    const unsigned char bitP = bit1_[d_[1]];
+    const unsigned char bitQ = bit1_[d_[2]];
+    const size_t numberOfRows = rows(sliceBegin, sliceEnd);
+    Coordinate c[3];
+    Coordinate length;
+    for(size_t j = 0; j < numberOfRows; ++j) {
+        row(j, sliceBegin, sliceEnd, c, length);
+        const bool hasP = c[d_[1]] + 1 < shape_[d_[1]];
+        const bool hasQ = c[d_[2]] + 1 < shape_[d_[2]];
+        if(!hasP && !hasQ) {
+            continue; // no 1-cells in this row
+        }
+        unsigned char* g = &grid_.grid_(c[0], c[1], c[2]);
+        const unsigned char* gp = g;
+        const unsigned char* gq = g;
+        if(hasP) {
+            ++c[d_[1]];
+            gp = &grid_.grid_(c[0], c[1], c[2]);
+            --c[d_[1]];
+        }
+        if(hasQ) {
+            ++c[d_[2]];
+            gq = &grid_.grid_(c[0], c[1], c[2]);
+            --c[d_[2]];
+        }
+        const size_t n = c[d_[0]] + length == shape_[d_[0]] ? length - 1 : length;
+        buffer_.assign(length, 0);
+        unsigned char* b = &buffer_[0];
+        if(hasP && hasQ) { // 1-cells along the row
+            for(size_t k = 0; k < length; ++k) {
+                const unsigned char count = ((g[k] & p) != 0) + ((gq[k] & p) != 0)
+                    + ((g[k] & q) != 0) + ((gp[k] & q) != 0);
+                b[k] = count > 2 ? bitR : 0;
+            }
+        }
+        if(hasQ) { // 1-cells along dimension d_[1]
+            for(size_t k = 0; k < n; ++k) {
+                const unsigned char count = ((g[k] & q) != 0) + ((g[k + 1] & q) != 0)
+                    + ((g[k] & r) != 0) + ((gq[k] & r) != 0);
+                b[k] |= count > 2 ? bitP : 0;
+            }
+        }
+        if(hasP) { // 1-cells along dimension d_[2]
+            for(size_t k = 0; k < n; ++k) {
+                const unsigned char count = ((g[k] & p) != 0) + ((g[k + 1] & p) != 0)
+                    + ((g[k] & r) != 0) + ((gp[k] & r) != 0);
+                b[k] |= count > 2 ? bitQ : 0;
+            }
+        }
+        const unsigned char keep = static_cast<unsigned char>(~(bitR | bitP | bitQ));
+        for(size_t k = 0; k < length; ++k) {
+            g[k] = (g[k] & keep) | b[k];
+        }
+    }
+}
+
+template<class T, class C, class LAYOUT>
+void
+Marker<T, C, LAYOUT>::markRows0(
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    std::vector<CellType>& zeroCells
+)
+{
+    const unsigned char r = bit1_[d_[0]];
+    const unsigned char p = bit1_[d_[1]];
+    const unsigned char q = bit1_[d_[2]];
+    const unsigned char bit = 64 | 128; // 0-cells are marked and anchored
+    const size_t numberOfRows = rows(sliceBegin, sliceEnd);
+    Coordinate c[3];
+    Coordinate length;
+    for(size_t j = 0; j < numberOfRows; ++j) {
+        row(j, sliceBegin, sliceEnd, c, length);
+        if(c[d_[1]] + 1 == shape_[d_[1]] || c[d_[2]] + 1 == shape_[d_[2]]) {
+            continue; // no 0-cells in this row
+        }
+        unsigned char* g = &grid_.grid_(c[0], c[1], c[2]);
+        ++c[d_[1]];
+        const unsigned char* gp = &grid_.grid_(c[0], c[1], c[2]);
+        --c[d_[1]];
+        ++c[d_[2]];
+        const unsigned char* gq = &grid_.grid_(c[0], c[1], c[2]);
+        --c[d_[2]];
+        const size_t n = c[d_[0]] + length == shape_[d_[0]] ? length - 1 : length;
+        buffer_.assign(length, 0);
+        unsigned char* b = &buffer_[0];
+        for(size_t k = 0; k < n; ++k) {
+            const unsigned char count = ((g[k] & r) != 0) + ((g[k + 1] & r) != 0)
+                + ((g[k] & p) != 0) + ((gp[k] & p) != 0)
+                + ((g[k] & q) != 0) + ((gq[k] & q) != 0);
+            // same rule as CWX::markSlices, including the case count == 1
+            b[k] = (count > 2 || count == 1) ? bit : 0;
+        }
+        for(size_t k = 0; k < n; ++k) {
+            if(b[k] != 0) {
+                g[k] |= bit;
+                CellType cell(2 * c[0] + 1, 2 * c[1] + 1, 2 * c[2] + 1);
+                cell[d_[0]] += 2 * static_cast<Coordinate>(k);
+                zeroCells.push_back(cell);
+            }
+        }
+    }
+}
+
+// number of rows in the voxel slices [sliceBegin, sliceEnd) of dimension 2
+template<class T, class C, class LAYOUT>
+inline size_t
+Marker<T, C, LAYOUT>::rows(
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd
+) const
+{
+    assert(sliceBegin <= sliceEnd && sliceEnd <= shape_[2]);
+    if(d_[0] == 2) {
+        return sliceBegin == sliceEnd ? 0 : shape_[0] * shape_[1];
+    }
+    else {
+        return shape_[d_[1]] * (sliceEnd - sliceBegin);
+    }
+}
+
+// writes the voxel coordinates of the first voxel of the j-th row in the
+// slices [sliceBegin, sliceEnd) of dimension 2 to c and the number of voxels
+// in this row to length
+template<class T, class C, class LAYOUT>
+inline void
+Marker<T, C, LAYOUT>::row(
+    const size_t j,
+    const Coordinate sliceBegin,
+    const Coordinate sliceEnd,
+    Coordinate* c,
+    Coordinate& length
+) const
+{
+    if(d_[0] == 2) {
+        // rows along dimension 2 are cut to the slices
+        c[0] = static_cast<Coordinate>(j % shape_[0]);
+        c[1] = static_cast<Coordinate>(j / shape_[0]);
+        c[2] = sliceBegin;
+        length = sliceEnd - sliceBegin;
+    }
+    else {
+        c[d_[0]] = 0;
+        c[d_[1]] = static_cast<Coordinate>(j % shape_[d_[1]]);
+        c[2] = static_cast<Coordinate>(sliceBegin + j / shape_[d_[1]]);
+        length = static_cast<Coordinate>(shape_[d_[0]]);
+    }
+}
+
+} // namespace detail
+} // namespace cwx
+
+#endif // #ifndef CWX_MARKER_HXX
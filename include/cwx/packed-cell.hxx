@@ -0,0 +1,156 @@
+#pragma once
+#ifndef CWX_PACKED_CELL_HXX
+#define CWX_PACKED_CELL_HXX
+
+#include <cassert>
+#include <cstdint>
+
+#include "cwx/cell.hxx"
+
+namespace cwx {
+
+/// cell whose coordinates are packed into one 64-bit integer, with 21 bits
+/// per coordinate as in detail::packCell.
+///
+/// packed cells are ordered like cells. the order of a packed cell and the
+/// parities of its coordinates are read from three bits, and stepping to an
+/// adjacent cell is one addition or subtraction. traversals, hash tables of
+/// cells and grids of bytes accept packed cells, such that hot loops need
+/// not pack cells anew for every access. coordinates must be less than
+/// 2^21.
+class PackedCell {
+public:
+    typedef uint64_t Key;
+    typedef unsigned char Order;
+
+    // construction
+    PackedCell();
+    template<class C> explicit PackedCell(const Cell<C>&);
+    explicit PackedCell(const Key);
+
+    // query
+    Key key() const;
+    Order order() const;
+    bool isOdd(const size_t) const;
+    Key operator[](const size_t) const;
+    template<class C> void unpack(Cell<C>&) const;
+    bool operator<(const PackedCell&) const;
+    bool operator==(const PackedCell&) const;
+    bool operator!=(const PackedCell&) const;
+
+    // manipulation
+    void increment(const size_t);
+    void decrement(const size_t);
+
+private:
+    Key key_;
+};
+
+inline
+PackedCell::PackedCell()
+:   key_(0)
+{}
+
+template<class C>
+inline
+PackedCell::PackedCell(
+    const Cell<C>& cell
+)
+:   key_(detail::packCell(cell))
+{}
+
+inline
+PackedCell::PackedCell(
+    const Key key
+)
+:   key_(key)
+{}
+
+inline PackedCell::Key
+PackedCell::key() const
+{
+    return key_;
+}
+
+inline PackedCell::Order
+PackedCell::order() const
+{
+    return static_cast<Order>(3 - (key_ & 1) - ((key_ >> 21) & 1) - ((key_ >> 42) & 1));
+}
+
+inline bool
+PackedCell::isOdd(
+    const size_t j
+) const
+{
+    assert(j < 3);
+    return (key_ >> (21 * j)) & 1;
+}
+
+inline PackedCell::Key
+PackedCell::operator[](
+    const size_t j
+) const
+{
+    assert(j < 3);
+    return (key_ >> (21 * j)) & ((Key(1) << 21) - 1);
+}
+
+template<class C>
+inline void
+PackedCell::unpack(
+    Cell<C>& cell
+) const
+{
+    cell = detail::unpackCell<C>(key_);
+}
+
+inline bool
+PackedCell::operator<(
+    const PackedCell& other
+) const
+{
+    return key_ < other.key_;
+}
+
+inline bool
+PackedCell::operator==(
+    const PackedCell& other
+) const
+{
+    return key_ == other.key_;
+}
+
+inline bool
+PackedCell::operator!=(
+    const PackedCell& other
+) const
+{
+    return key_ != other.key_;
+}
+
+// increments coordinate j, which must be less than 2^21 - 1
+inline void
+PackedCell::increment(
+    const size_t j
+)
+{
+    assert(j < 3);
+    assert((*this)[j] + 1 < (Key(1) << 21));
+    key_ += Key(1) << (21 * j);
+}
+
+// decrements coordinate j, which must be positive
+inline void
+PackedCell::decrement(
+    const size_t j
+)
+{
+    assert(j < 3);
+    assert((*this)[j] > 0);
+    key_ -= Key(1) << (21 * j);
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_PACKED_CELL_HXX
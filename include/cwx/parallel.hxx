@@ -0,0 +1,124 @@
+#pragma once
+#ifndef CWX_PARALLEL_HXX
+#define CWX_PARALLEL_HXX
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <exception>
+
+namespace cwx {
+
+/// partition of the range [0, size) into contiguous slabs.
+///
+/// slabs are as equal in size as possible and never empty. the partition
+/// depends only on size and the requested number of slabs, such that
+/// successive parallel phases over the same range operate on the same slabs.
+class SlabPartition {
+public:
+    SlabPartition(const size_t, const size_t);
+
+    size_t numberOfSlabs() const;
+    size_t begin(const size_t) const;
+    size_t end(const size_t) const;
+
+private:
+    std::vector<size_t> bounds_;
+};
+
+size_t hardwareConcurrency();
+template<class FUNCTOR> void parallelFor(const size_t, FUNCTOR);
+
+inline
+SlabPartition::SlabPartition(
+    const size_t size,
+    const size_t numberOfSlabs
+)
+:   bounds_(1, 0)
+{
+    assert(numberOfSlabs > 0);
+    const size_t n = size < numberOfSlabs ? size : numberOfSlabs;
+    for(size_t j = 0; j < n; ++j) {
+        bounds_.push_back(size / n * (j + 1) + (j < size % n ? j + 1 : size % n));
+    }
+    assert(bounds_.back() == size);
+}
+
+inline size_t
+SlabPartition::numberOfSlabs() const
+{
+    return bounds_.size() - 1;
+}
+
+inline size_t
+SlabPartition::begin(
+    const size_t slab
+) const
+{
+    assert(slab < numberOfSlabs());
+    return bounds_[slab];
+}
+
+inline size_t
+SlabPartition::end(
+    const size_t slab
+) const
+{
+    assert(slab < numberOfSlabs());
+    return bounds_[slab + 1];
+}
+
+// returns the number of hardware threads, or 1 if it cannot be determined
+inline size_t
+hardwareConcurrency()
+{
+    const size_t n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// calls functor(j) for all j in [0, size), each call in its own thread.
+// the calling thread handles j = 0. if a call throws, the first exception
+// is rethrown after all threads have been joined.
+template<class FUNCTOR>
+void
+parallelFor(
+    const size_t size,
+    FUNCTOR functor
+)
+{
+    if(size == 0) {
+        return;
+    }
+    std::vector<std::exception_ptr> exceptions(size);
+    std::vector<std::thread> threads;
+    threads.reserve(size - 1);
+    for(size_t j = 1; j < size; ++j) {
+        threads.push_back(std::thread([&functor, &exceptions, j]() {
+            try {
+                functor(j);
+            }
+            catch(...) {
+                exceptions[j] = std::current_exception();
+            }
+        }));
+    }
+    try {
+        functor(0);
+    }
+    catch(...) {
+        exceptions[0] = std::current_exception();
+    }
+    for(size_t j = 0; j < threads.size(); ++j) {
+        threads[j].join();
+    }
+    for(size_t j = 0; j < size; ++j) {
+        if(exceptions[j]) {
+            std::rethrow_exception(exceptions[j]);
+        }
+    }
+}
+
+} // namespace cwx
+
+#endif // #ifndef CWX_PARALLEL_HXX
@@ -0,0 +1,413 @@
+#pragma once
+#ifndef CWX_TRAVERSAL_WORKSPACE_HXX
+#define CWX_TRAVERSAL_WORKSPACE_HXX
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "cwx/cell.hxx"
+#include "cwx/packed-cell.hxx"
+
+namespace cwx {
+
+/// memory for breadth-first traversals of connected components of cells.
+///
+/// a workspace holds a set of visited cells and a queue of cells. both are
+/// kept across traversals such that a traversal allocates memory only if it
+/// visits more cells than any previous traversal with the same workspace.
+/// the visited set is a hash table whose slots are stamped with the number
+/// of the traversal. starting a traversal thus takes constant time. cells
+/// are stored packed, and all functions accept packed cells as well.
+///
+/// a workspace must not be used by more than one thread at a time.
+template<class C>
+class TraversalWorkspace {
+public:
+    typedef C Coordinate;
+    typedef Cell<Coordinate> CellType;
+
+    TraversalWorkspace();
+
+    void begin();
+
+    // visited set
+    size_t numberOfVisitedCells() const;
+    bool isVisited(const CellType&) const;
+    bool isVisited(const PackedCell&) const;
+    bool visit(const CellType&);
+    bool visit(const PackedCell&);
+
+    // queue
+    bool empty() const;
+    CellType front() const;
+    const PackedCell& packedFront() const;
+    void push(const CellType&);
+    void push(const PackedCell&);
+    void pop();
+
+private:
+    typedef uint64_t Key;
+    typedef uint32_t Epoch;
+
+    size_t slot(const Key) const;
+    void rehash(const size_t);
+
+    std::vector<Key> keys_;
+    std::vector<Epoch> epochs_; // slot is occupied iff epochs_[j] == epoch_
+    Epoch epoch_;
+    size_t numberOfVisitedCells_;
+    std::vector<PackedCell> queue_; // ring buffer with 2^k elements
+    size_t queueBegin_;
+    size_t queueSize_;
+};
+
+namespace detail {
+
+// grants exclusive use of one of the workspaces of the calling thread.
+// workspaces are created on demand and returned to the thread's pool when
+// the lease ends. this allows for nested traversals, e.g. a call of
+// CWX::atCell from within a functor passed to CWX::process.
+template<class C>
+class WorkspaceLease {
+public:
+    typedef TraversalWorkspace<C> TraversalWorkspaceType;
+
+    WorkspaceLease();
+    ~WorkspaceLease();
+    TraversalWorkspaceType& workspace();
+
+private:
+    WorkspaceLease(const WorkspaceLease&);
+    WorkspaceLease& operator=(const WorkspaceLease&);
+    static std::vector<std::unique_ptr<TraversalWorkspaceType> >& pool();
+
+    std::unique_ptr<TraversalWorkspaceType> workspace_;
+};
+
+template<class GRID, class FUNCTOR>
+    bool traverseComponent(const GRID&, const typename GRID::CellType&, FUNCTOR, TraversalWorkspace<typename GRID::Coordinate>&);
+template<unsigned char ORDER, class GRID, class FUNCTOR>
+    bool traverseComponent(const GRID&, const typename GRID::CellType&, FUNCTOR, TraversalWorkspace<typename GRID::Coordinate>&);
+template<unsigned char ORDER, class GRID, class CELL, class FUNCTOR>
+    void forEachNeighbor(const GRID&, const CELL&, FUNCTOR);
+
+} // namespace detail
+
+template<class C>
+inline
+TraversalWorkspace<C>::TraversalWorkspace()
+:   keys_(16),
+    epochs_(16, 0),
+    epoch_(0),
+    numberOfVisitedCells_(0),
+    queue_(16),
+    queueBegin_(0),
+    queueSize_(0)
+{}
+
+// starts a new traversal: clears the visited set and the queue
+template<class C>
+inline void
+TraversalWorkspace<C>::begin()
+{
+    ++epoch_;
+    if(epoch_ == 0) { // if stamps wrapped around
+        std::fill(epochs_.begin(), epochs_.end(), 0);
+        epoch_ = 1;
+    }
+    numberOfVisitedCells_ = 0;
+    queueBegin_ = 0;
+    queueSize_ = 0;
+}
+
+template<class C>
+inline size_t
+TraversalWorkspace<C>::numberOfVisitedCells() const
+{
+    return numberOfVisitedCells_;
+}
+
+template<class C>
+inline bool
+TraversalWorkspace<C>::isVisited(
+    const CellType& cell
+) const
+{
+    return isVisited(PackedCell(cell));
+}
+
+template<class C>
+inline bool
+TraversalWorkspace<C>::isVisited(
+    const PackedCell& cell
+) const
+{
+    return epochs_[slot(cell.key())] == epoch_;
+}
+
+// marks a cell as visited. returns false if it had been visited before
+template<class C>
+inline bool
+TraversalWorkspace<C>::visit(
+    const CellType& cell
+)
+{
+    return visit(PackedCell(cell));
+}
+
+template<class C>
+inline bool
+TraversalWorkspace<C>::visit(
+    const PackedCell& cell
+)
+{
+    const Key key = cell.key();
+    size_t j = slot(key);
+    if(epochs_[j] == epoch_) {
+        return false;
+    }
+    if((numberOfVisitedCells_ + 1) * 2 > keys_.size()) { // max. load factor 1/2
+        rehash(2 * keys_.size());
+        j = slot(key);
+    }
+    keys_[j] = key;
+    epochs_[j] = epoch_;
+    ++numberOfVisitedCells_;
+    return true;
+}
+
+template<class C>
+inline bool
+TraversalWorkspace<C>::empty() const
+{
+    return queueSize_ == 0;
+}
+
+template<class C>
+inline typename TraversalWorkspace<C>::CellType
+TraversalWorkspace<C>::front() const
+{
+    CellType cell;
+    packedFront().unpack(cell);
+    return cell;
+}
+
+template<class C>
+inline const PackedCell&
+TraversalWorkspace<C>::packedFront() const
+{
+    assert(!empty());
+    return queue_[queueBegin_];
+}
+
+template<class C>
+inline void
+TraversalWorkspace<C>::push(
+    const CellType& cell
+)
+{
+    push(PackedCell(cell));
+}
+
+template<class C>
+inline void
+TraversalWorkspace<C>::push(
+    const PackedCell& cell
+)
+{
+    if(queueSize_ == queue_.size()) {
+        // unroll the ring buffer into a buffer of twice the size
+        std::vector<PackedCell> queue(2 * queue_.size());
+        for(size_t j = 0; j < queueSize_; ++j) {
+            queue[j] = queue_[(queueBegin_ + j) & (queue_.size() - 1)];
+        }
+        queue_.swap(queue);
+        queueBegin_ = 0;
+    }
+    queue_[(queueBegin_ + queueSize_) & (queue_.size() - 1)] = cell;
+    ++queueSize_;
+}
+
+template<class C>
+inline void
+TraversalWorkspace<C>::pop()
+{
+    assert(!empty());
+    queueBegin_ = (queueBegin_ + 1) & (queue_.size() - 1);
+    --queueSize_;
+}
+
+// returns the slot that holds the key in the current traversal or, if the
+// key is not in the set, the free slot where the key would be inserted
+template<class C>
+inline size_t
+TraversalWorkspace<C>::slot(
+    const Key key
+) const
+{
+    const size_t mask = keys_.size() - 1;
+    size_t j = detail::hashPackedCell(key, mask);
+    while(epochs_[j] == epoch_ && keys_[j] != key) {
+        j = (j + 1) & mask;
+    }
+    return j;
+}
+
+template<class C>
+void
+TraversalWorkspace<C>::rehash(
+    const size_t capacity
+)
+{
+    assert((capacity & (capacity - 1)) == 0); // power of 2
+    std::vector<Key> keys(capacity);
+    std::vector<Epoch> epochs(capacity, 0);
+    keys_.swap(keys);
+    epochs_.swap(epochs);
+    const Epoch epoch = epoch_;
+    epoch_ = 1;
+    for(size_t j = 0; j < keys.size(); ++j) {
+        if(epochs[j] == epoch) {
+            const size_t k = slot(keys[j]);
+            keys_[k] = keys[j];
+            epochs_[k] = epoch_;
+        }
+    }
+}
+
+namespace detail {
+
+template<class C>
+inline
+WorkspaceLease<C>::WorkspaceLease()
+:   workspace_()
+{
+    std::vector<std::unique_ptr<TraversalWorkspaceType> >& p = pool();
+    if(p.empty()) {
+        workspace_.reset(new TraversalWorkspaceType);
+    }
+    else {
+        workspace_ = std::move(p.back());
+        p.pop_back();
+    }
+}
+
+template<class C>
+inline
+WorkspaceLease<C>::~WorkspaceLease()
+{
+    pool().push_back(std::move(workspace_));
+}
+
+template<class C>
+inline typename WorkspaceLease<C>::TraversalWorkspaceType&
+WorkspaceLease<C>::workspace()
+{
+    return *workspace_;
+}
+
+template<class C>
+inline std::vector<std::unique_ptr<typename WorkspaceLease<C>::TraversalWorkspaceType> >&
+WorkspaceLease<C>::pool()
+{
+    static thread_local std::vector<std::unique_ptr<TraversalWorkspaceType> > workspaces;
+    return workspaces;
+}
+
+// breadth-first traversal of the connected component of a cell of order
+// 1, 2 or 3 in a grid with the interface of ByteLabeledCellgrid. two k-cells
+// are connected if they bound the same unmarked (k-1)-cell. all 3-cells are
+// considered, and all marked k-cells for k = 1, 2.
+// functor(cell) is called for every cell of the component. if it returns
+// false, the traversal is stopped and false is returned.
+// the order of the cell is dispatched once to traverseComponent<ORDER>.
+template<class GRID, class FUNCTOR>
+bool
+traverseComponent(
+    const GRID& grid,
+    const typename GRID::CellType& cell,
+    FUNCTOR functor,
+    TraversalWorkspace<typename GRID::Coordinate>& workspace
+)
+{
+    switch(cell.order()) {
+    case 1:
+        return traverseComponent<1>(grid, cell, functor, workspace);
+    case 2:
+        return traverseComponent<2>(grid, cell, functor, workspace);
+    default:
+        assert(cell.order() == 3);
+        return traverseComponent<3>(grid, cell, functor, workspace);
+    }
+}
+
+// breadth-first traversal as above, for a cell of order ORDER. a 0-cell is
+// a component by itself. throws before any cell is visited if the cells of
+// the grid do not fit into packed cells, cf. testShape.
+template<unsigned char ORDER, class GRID, class FUNCTOR>
+bool
+traverseComponent(
+    const GRID& grid,
+    const typename GRID::CellType& cell,
+    FUNCTOR functor,
+    TraversalWorkspace<typename GRID::Coordinate>& workspace
+)
+{
+    typedef typename GRID::CellType CellType;
+    assert(cell.order() == ORDER);
+    testShape(grid.shape(0), grid.shape(1), grid.shape(2));
+    workspace.begin();
+    workspace.visit(cell);
+    workspace.push(cell);
+    CellType c;
+    while(!workspace.empty()) {
+        const PackedCell packed = workspace.packedFront();
+        workspace.pop();
+        packed.unpack(c);
+        if(!functor(c)) {
+            return false;
+        }
+        forEachNeighbor<ORDER>(grid, packed, [&](const PackedCell& neighbor) {
+            if(workspace.visit(neighbor)) {
+                workspace.push(neighbor);
+            }
+        });
+    }
+    return true;
+}
+
+// calls functor(neighbor) for all cells of order ORDER that are connected
+// to the given cell of this order by an unmarked (ORDER-1)-cell, including
+// the cell itself once per such (ORDER-1)-cell. all 3-cells are considered,
+// and all marked cells of order 1 and 2. the order of calls is that of the
+// cells found by below and above. CELL is the cell type of the grid or
+// PackedCell.
+template<unsigned char ORDER, class GRID, class CELL, class FUNCTOR>
+inline void
+forEachNeighbor(
+    const GRID& grid,
+    const CELL& cell,
+    FUNCTOR functor
+)
+{
+    grid.template forEachBelow<ORDER>(cell, [&](const CELL& face) {
+        if(!grid.isMarked(face)) { // if not a boundary
+            grid.template forEachAbove<(ORDER > 0 ? ORDER - 1 : 0)>(face, [&](const CELL& neighbor) {
+                assert(neighbor.order() == ORDER);
+                if(ORDER == 3 || grid.isMarked(neighbor)) {
+                    functor(neighbor);
+                }
+            });
+        }
+    });
+}
+
+} // namespace detail
+
+} // namespace cwx
+
+#endif // #ifndef CWX_TRAVERSAL_WORKSPACE_HXX
@@ -0,0 +1,82 @@
+#include <array>
+#include <vector>
+
+#include "cwx/generator.hxx"
+#include "cwx/accumulators.hxx"
+#include "cwx/cwx.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+typedef unsigned int Label;
+typedef unsigned int Coordinate;
+typedef cwx::Cell<Coordinate> Cell;
+typedef cwx::CWX<Label, Coordinate> CWX;
+typedef cwx::Accumulators<cwx::Count, cwx::BoundingBox, cwx::Centroid> Features;
+
+int main() {
+    const size_t shape[] = {13, 11, 17};
+    andres::Marray<Label> seg(shape, shape + 3);
+    cwx::generateVoronoi(seg, 8, 7, 1);
+    CWX cwx;
+    cwx.build(seg);
+
+    // features computed cell by cell
+    std::array<std::vector<size_t>, 4> counts;
+    std::array<std::vector<std::array<size_t, 6> >, 4> boxes;
+    std::array<std::vector<std::array<double, 3> >, 4> sums;
+    for(unsigned char order = 0; order < 4; ++order) {
+        counts[order].resize(cwx.numberOfCells(order) + 1);
+        std::array<size_t, 6> box = {{~size_t(0), ~size_t(0), ~size_t(0), 0, 0, 0}};
+        boxes[order].resize(cwx.numberOfCells(order) + 1, box);
+        std::array<double, 3> sum = {{0, 0, 0}};
+        sums[order].resize(cwx.numberOfCells(order) + 1, sum);
+    }
+    Cell cell;
+    for(cell[2] = 0; cell[2] < 2 * shape[2] - 1; ++cell[2])
+    for(cell[1] = 0; cell[1] < 2 * shape[1] - 1; ++cell[1])
+    for(cell[0] = 0; cell[0] < 2 * shape[0] - 1; ++cell[0]) {
+        const unsigned char order = cell.order();
+        if(order == 3 || cwx.isMarked(cell)) {
+            const Label label = cwx.atCell(cell);
+            ++counts[order][label];
+            for(size_t d = 0; d < 3; ++d) {
+                boxes[order][label][d] = std::min<size_t>(boxes[order][label][d], cell[d]);
+                boxes[order][label][d + 3] = std::max<size_t>(boxes[order][label][d + 3], cell[d]);
+                sums[order][label][d] += cell[d];
+            }
+        }
+    }
+
+    for(size_t numberOfThreads = 1; numberOfThreads < 8; numberOfThreads += 3) {
+        std::array<std::vector<Features>, 4> features;
+        cwx.accumulate(features, numberOfThreads);
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(features[order].size() == cwx.numberOfCells(order) + 1);
+            test(features[order][0].count() == 0);
+            for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+                const Features& f = features[order][label];
+                test(f.count() == counts[order][label]);
+                test(f.count() > 0);
+                for(size_t d = 0; d < 3; ++d) {
+                    test(f.min(d) == boxes[order][label][d]);
+                    test(f.max(d) == boxes[order][label][d + 3]);
+                    const double centroid = sums[order][label][d] / counts[order][label];
+                    test(f.centroid(d) > centroid - 1e-9 && f.centroid(d) < centroid + 1e-9);
+                }
+            }
+        }
+    }
+
+    // a single accumulator
+    std::array<std::vector<cwx::Count>, 4> volumes;
+    cwx.accumulate(volumes, 2);
+    size_t numberOfVoxels = 0;
+    for(Label label = 1; label <= cwx.numberOfCells(3); ++label) {
+        numberOfVoxels += volumes[3][label].count();
+    }
+    test(numberOfVoxels == seg.size());
+
+    return 0;
+}
@@ -68,6 +68,112 @@ int main() {
         anchorage.anchor(0, 1, c);
         test(c[0] == 1 && c[1] == 1 && c[2] == 1);
     }
+    {
+        // additional anchors, enough to grow the index several times
+        test(anchorage.numberOfAnchors() == 5);
+        CellType c;
+        size_t n = 0;
+        for(c[2] = 0; c[2] < 20; ++c[2])
+        for(c[1] = 0; c[1] < 20; ++c[1])
+        for(c[0] = 1; c[0] < 20; c[0] += 2) {
+            if(c.order() == 2) {
+                anchorage.anchor(c, 1);
+                ++n;
+            }
+        }
+        test(anchorage.numberOfAnchors() == 5 + n);
+        anchorage.reserve(4 * n);
+        test(anchorage.numberOfAnchors() == 5 + n);
+        for(c[2] = 0; c[2] < 20; ++c[2])
+        for(c[1] = 0; c[1] < 20; ++c[1])
+        for(c[0] = 1; c[0] < 20; c[0] += 2) {
+            test(anchorage.anchor(c) == (c.order() == 2 ? 1 : 0) || c.order() == 0);
+        }
+        c[0] = 0; c[1] = 0; c[2] = 0;
+        test(anchorage.anchor(c) == 0);
+        c[0] = 2; c[1] = 2; c[2] = 1;
+        test(anchorage.anchor(c) == 1);
+        c[0] = 6; c[1] = 4; c[2] = 2;
+        test(anchorage.anchor(c) == 2);
+    }
+    {
+        // erase every other additional anchor
+        CellType c;
+        size_t n = anchorage.numberOfAnchors();
+        for(c[2] = 0; c[2] < 20; ++c[2])
+        for(c[1] = 0; c[1] < 20; ++c[1])
+        for(c[0] = 1; c[0] < 20; c[0] += 4) {
+            if(c.order() == 2) {
+                anchorage.erase(c);
+                --n;
+            }
+        }
+        test(anchorage.numberOfAnchors() == n);
+        for(c[2] = 0; c[2] < 20; ++c[2])
+        for(c[1] = 0; c[1] < 20; ++c[1])
+        for(c[0] = 1; c[0] < 20; c[0] += 2) {
+            if(c.order() == 2) {
+                test(anchorage.anchor(c) == (c[0] % 4 == 3 ? 1 : 0));
+            }
+        }
+    }
+    {
+        // merge and erase labels
+        Anchorage anchorage;
+        CellType c(0, 0, 0);
+        for(c[0] = 0; c[0] < 8; c[0] += 2) {
+            anchorage.push_back(c); // labels 1, 2, 3, 4
+        }
+        c[1] = 2;
+        for(c[0] = 0; c[0] < 8; c[0] += 2) {
+            anchorage.anchor(c, c[0] / 2 + 1);
+        }
+
+        anchorage.merge(3, 2, 1);
+        anchorage.erase(3, 2); // 4 takes the label 2
+        test(anchorage.numberOfCells(3) == 3);
+        for(c[1] = 0; c[1] < 4; c[1] += 2) {
+            c[0] = 0; test(anchorage.anchor(c) == 1);
+            c[0] = 2; test(anchorage.anchor(c) == 1);
+            c[0] = 4; test(anchorage.anchor(c) == 3);
+            c[0] = 6; test(anchorage.anchor(c) == 2);
+        }
+        anchorage.anchor(3, 2, c);
+        test(c == CellType(6, 0, 0));
+
+        c = CellType(8, 0, 0);
+        test(anchorage.push_back(c) == 4);
+        test(anchorage.anchor(c) == 4);
+        anchorage.merge(3, 1, 4);
+        anchorage.erase(3, 1); // 4 takes the label 1
+        test(anchorage.numberOfCells(3) == 3);
+        c = CellType(0, 2, 0); test(anchorage.anchor(c) == 1);
+        c = CellType(2, 2, 0); test(anchorage.anchor(c) == 1);
+        c = CellType(8, 0, 0); test(anchorage.anchor(c) == 1);
+        anchorage.anchor(3, 1, c);
+        test(c == CellType(8, 0, 0));
+
+        anchorage.erase(CellType(6, 0, 0));
+        anchorage.erase(CellType(6, 2, 0));
+        anchorage.erase(3, 2);
+        test(anchorage.numberOfCells(3) == 2);
+        size_t n = 0;
+        anchorage.forEachAnchor([&](const CellType& cell, const Label label) {
+            test(label == (cell[0] == 4 ? 2 : 1));
+            ++n;
+        });
+        test(n == anchorage.numberOfAnchors() && n == 7);
+
+        // a label whose anchors have been merged into another label gets new
+        // anchors
+        anchorage.merge(3, 2, 1);
+        c = CellType(4, 0, 0); test(anchorage.anchor(c) == 1);
+        anchorage.reanchor(CellType(10, 0, 0), 2);
+        c = CellType(10, 0, 0); test(anchorage.anchor(c) == 2);
+        anchorage.anchor(3, 2, c);
+        test(c == CellType(10, 0, 0));
+        c = CellType(4, 2, 0); test(anchorage.anchor(c) == 1);
+    }
 
     return 0;
 }
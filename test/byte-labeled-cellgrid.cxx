@@ -34,6 +34,41 @@ int main() {
         test(grid.shape(1) == 4);
         test(grid.shape(2) == 3);
 
+        // shapes whose cell coordinates do not fit into packed cells
+        for(size_t d = 0; d < 3; ++d) {
+            Coordinate shape[] = {1, 4, 3};
+            shape[d] = (1 << 20) + 1;
+            bool thrown = false;
+            try {
+                grid.resize(shape[0], shape[1], shape[2]);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+            test(grid.shape(0) == 1 && grid.shape(1) == 4 && grid.shape(2) == 3);
+            thrown = false;
+            try {
+                ByteLabeledCellgrid otherGrid(shape[0], shape[1], shape[2]);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+            thrown = false;
+            const unsigned char byte = 0;
+            try {
+                cwx::ByteLabeledCellgridView<Label, Coordinate> view(shape[0], shape[1], shape[2], &byte);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+        }
+        grid.resize(1 << 20, 1, 1);
+        test(grid.shape(0) == 1 << 20);
+        grid.resize(1, 4, 3);
+
         std::string s = grid.asString();
     }
 
@@ -100,9 +135,108 @@ int main() {
                     else if(c.order() != 3) { // used for anchoring
                         test(!grid.isMarked(c));
                     }
+                    test(grid.isMarked(cwx::PackedCell(c)) == grid.isMarked(c));
+                    test(grid.isAnchored(cwx::PackedCell(c)) == grid.isAnchored(c));
                 }
             }
         }
+
+        // unmarking cells keeps the anchors
+        if(grid.firstCell(order, c)) {
+            do {
+                grid.mark(c, false);
+                test(!grid.isMarked(c));
+                test(grid.isAnchored(c));
+            } while(grid.orderPreservingIncrement(c));
+        }
+        for(c[0]=0; c[0]<grid.shape(0) * 2 - 1; ++c[0]) {
+            for(c[1]=0; c[1]<grid.shape(1) * 2 - 1; ++c[1]) {
+                for(c[2]=0; c[2]<grid.shape(2) * 2 - 1; ++c[2]) {
+                    if(c.order() != 3) {
+                        test(!grid.isMarked(c));
+                    }
+                }
+            }
+        }
+    }
+
+    // bricked layout, with a shape that is not a multiple of the brick edge
+    {
+        typedef cwx::ByteLabeledCellgrid<Label, Coordinate, cwx::BrickedLayout<4> > BrickedCellgrid;
+        ByteLabeledCellgrid linear(9, 5, 6);
+        BrickedCellgrid bricked(9, 5, 6);
+        test(bricked.memory() == 12*8*8);
+        std::mt19937 generator(42);
+        for(size_t j = 0; j < 500; ++j) {
+            Cell c(generator() % 17, generator() % 9, generator() % 11);
+            const bool value = generator() % 3 != 0;
+            linear.mark(c, value);
+            bricked.mark(c, value);
+            if(c.order() == 3) {
+                linear.anchor(c, value);
+                bricked.anchor(c, value);
+            }
+        }
+        Cell c;
+        for(c[2] = 0; c[2] < 11; ++c[2])
+        for(c[1] = 0; c[1] < 9; ++c[1])
+        for(c[0] = 0; c[0] < 17; ++c[0]) {
+            test(bricked.isMarked(c) == linear.isMarked(c));
+            test(bricked.isAnchored(c) == linear.isAnchored(c));
+            test(bricked.isMarked(cwx::PackedCell(c)) == linear.isMarked(c));
+        }
+        test(bricked.asString() == linear.asString());
+
+        // export and assignment
+        const BrickedCellgrid::GridViewType exported = bricked.grid();
+        for(size_t z = 0; z < 6; ++z)
+        for(size_t y = 0; y < 5; ++y)
+        for(size_t x = 0; x < 9; ++x) {
+            test(exported(x, y, z) == linear.grid()(x, y, z));
+        }
+        BrickedCellgrid assigned;
+        assigned.assign(linear.grid());
+        test(assigned.shape(0) == 9 && assigned.shape(1) == 5 && assigned.shape(2) == 6);
+        test(assigned.asString() == linear.asString());
+        ByteLabeledCellgrid reassigned;
+        reassigned.assign(exported);
+        test(reassigned.asString() == linear.asString());
+    }
+
+    // sparse layout
+    {
+        typedef cwx::SparseLayout<4> SparseLayout;
+        typedef cwx::ByteLabeledCellgrid<Label, Coordinate, SparseLayout> SparseCellgrid;
+        SparseLayout layout;
+        const SparseLayout& constLayout = layout; // reads do not allocate
+        layout.resize(9, 5, 6);
+        test(layout.numberOfBricks() == 0);
+        test(constLayout(8, 4, 5) == 0);
+        layout.set(8, 4, 5, 0); // does not allocate
+        test(layout.numberOfBricks() == 0);
+        layout.set(8, 4, 5, 3);
+        test(layout.numberOfBricks() == 1);
+        test(constLayout(8, 4, 5) == 3);
+        test(constLayout(0, 0, 0) == 0);
+        layout.set(8, 4, 5, 0);
+        test(layout.numberOfBricks() == 1);
+        test(layout.memory() == 12 * sizeof(size_t) + 2 * 4*4*4);
+
+        SparseCellgrid sparse(9, 5, 6);
+        ByteLabeledCellgrid linear(9, 5, 6);
+        sparse.mark(Cell(1, 0, 0), false);
+        sparse.anchor(Cell(10, 8, 6), false);
+        test(sparse.memory() == 12 * sizeof(size_t) + 4*4*4);
+        sparse.mark(Cell(1, 0, 0), true);
+        linear.mark(Cell(1, 0, 0), true);
+        sparse.anchor(Cell(10, 8, 6), true);
+        linear.anchor(Cell(10, 8, 6), true);
+        test(sparse.memory() == 12 * sizeof(size_t) + 3 * 4*4*4);
+        test(sparse.asString() == linear.asString());
+        SparseCellgrid assigned;
+        assigned.assign(linear.grid());
+        test(assigned.memory() == sparse.memory());
+        test(assigned.asString() == linear.asString());
     }
 
     // firstCell, orderPreservingIncrement with fixed dimension
@@ -1,5 +1,7 @@
 #include <stdexcept>
 #include <random>
+#include <vector>
+#include <algorithm>
 
 #include "cwx/cellgrid.hxx"
 
@@ -88,6 +90,80 @@ void testGeometry() {
     // firstCell, orderPreservingIncrement with fixed dimension
     // is tested in unit test of ByteLabeledCellgrid
 
+    // firstCell, orderPreservingIncrement and forEachCell, compared to
+    // an iteration over all cells, for small and degenerate shapes
+    for(Coordinate s0 = 1; s0 < 4; ++s0)
+    for(Coordinate s1 = 1; s1 < 4; ++s1)
+    for(Coordinate s2 = 1; s2 < 4; ++s2) {
+        Cellgrid grid(s0, s1, s2);
+        for(unsigned char order = 0; order < 4; ++order) {
+            std::vector<Cell> cells;
+            Cell c;
+            for(c[2] = 0; c[2] < 2 * s2 - 1; ++c[2])
+            for(c[1] = 0; c[1] < 2 * s1 - 1; ++c[1])
+            for(c[0] = 0; c[0] < 2 * s0 - 1; ++c[0]) {
+                if(c.order() == order) {
+                    cells.push_back(c);
+                }
+            }
+            std::vector<Cell> iterated;
+            if(grid.firstCell(order, c)) {
+                do {
+                    iterated.push_back(c);
+                } while(grid.orderPreservingIncrement(c));
+            }
+            test(iterated == cells);
+            iterated.clear();
+            grid.forEachCell(order, [&](const Cell& cell) {
+                iterated.push_back(cell);
+                return true;
+            });
+            test(iterated == cells);
+
+            for(Order d = 0; d < 3; ++d) {
+                for(Coordinate v = 0; v < 2 * grid.shape(d) - 1; ++v) {
+                    std::vector<Cell> sliceCells;
+                    for(size_t j = 0; j < cells.size(); ++j) {
+                        if(cells[j][d] == v) {
+                            sliceCells.push_back(cells[j]);
+                        }
+                    }
+                    iterated.clear();
+                    if(grid.firstCell(order, d, v, c)) {
+                        do {
+                            iterated.push_back(c);
+                        } while(grid.orderPreservingIncrement(d, c));
+                    }
+                    test(iterated == sliceCells);
+                    iterated.clear();
+                    grid.forEachCell(order, d, v, [&](const Cell& cell) {
+                        iterated.push_back(cell);
+                        return true;
+                    });
+                    test(iterated == sliceCells);
+                }
+            }
+
+            // slabs, and stopping the iteration
+            iterated.clear();
+            for(Coordinate z = 0; z < 2 * s2 - 1; z += 2) {
+                grid.forEachCellInSlab(order, z, std::min<Coordinate>(z + 2, 2 * s2 - 1), [&](const Cell& cell) {
+                    iterated.push_back(cell);
+                    return true;
+                });
+            }
+            test(iterated == cells);
+            if(!cells.empty()) {
+                size_t n = 0;
+                test(!grid.forEachCell(order, [&](const Cell&) {
+                    ++n;
+                    return false;
+                }));
+                test(n == 1);
+            }
+        }
+    }
+
     // above
     {
         Cellgrid grid(10, 20, 30);
@@ -427,10 +503,75 @@ void testGeometryCombinedWithTopology() {
     }
 }
 
+// appends the cells found by forEachAbove<ORDER> and forEachBelow<ORDER>
+template<unsigned char ORDER>
+void stencils(const Cellgrid& cellgrid, const Cell& cell, CellVector& cellsAbove, CellVector& cellsBelow) {
+    cellgrid.forEachAbove<ORDER>(cell, [&](const Cell& c) { cellsAbove.push_back(c); });
+    cellgrid.forEachBelow<ORDER>(cell, [&](const Cell& c) { cellsBelow.push_back(c); });
+}
+
+// appends the cells found by forEachAbove<ORDER> and forEachBelow<ORDER> for
+// the packed cell
+template<unsigned char ORDER>
+void packedStencils(const Cellgrid& cellgrid, const Cell& cell, CellVector& cellsAbove, CellVector& cellsBelow) {
+    Cell c;
+    cellgrid.forEachAbove<ORDER>(cwx::PackedCell(cell), [&](const cwx::PackedCell& p) { p.unpack(c); cellsAbove.push_back(c); });
+    cellgrid.forEachBelow<ORDER>(cwx::PackedCell(cell), [&](const cwx::PackedCell& p) { p.unpack(c); cellsBelow.push_back(c); });
+}
+
+void testStencils() {
+    Coordinate shape[] = {3, 1, 4};
+    Cellgrid cellgrid(shape[0], shape[1], shape[2]);
+    Cell cell;
+    for(cell[2] = 0; cell[2] < 2 * shape[2] - 1; ++cell[2])
+    for(cell[1] = 0; cell[1] < 2 * shape[1] - 1; ++cell[1])
+    for(cell[0] = 0; cell[0] < 2 * shape[0] - 1; ++cell[0]) {
+        CellVector above;
+        CellVector below;
+        cellgrid.above(cell, above);
+        cellgrid.below(cell, below);
+        CellVector fixedAbove;
+        CellVector fixedBelow;
+        CellVector packedAbove;
+        CellVector packedBelow;
+        switch(cell.order()) {
+        case 0:
+            stencils<0>(cellgrid, cell, fixedAbove, fixedBelow);
+            packedStencils<0>(cellgrid, cell, packedAbove, packedBelow);
+            break;
+        case 1:
+            stencils<1>(cellgrid, cell, fixedAbove, fixedBelow);
+            packedStencils<1>(cellgrid, cell, packedAbove, packedBelow);
+            break;
+        case 2:
+            stencils<2>(cellgrid, cell, fixedAbove, fixedBelow);
+            packedStencils<2>(cellgrid, cell, packedAbove, packedBelow);
+            break;
+        case 3:
+            stencils<3>(cellgrid, cell, fixedAbove, fixedBelow);
+            packedStencils<3>(cellgrid, cell, packedAbove, packedBelow);
+            break;
+        }
+        test(fixedAbove.size() == above.size());
+        test(packedAbove.size() == above.size());
+        for(size_t j = 0; j < above.size(); ++j) {
+            test(fixedAbove[j] == above[j]);
+            test(packedAbove[j] == above[j]);
+        }
+        test(fixedBelow.size() == below.size());
+        test(packedBelow.size() == below.size());
+        for(size_t j = 0; j < below.size(); ++j) {
+            test(fixedBelow[j] == below[j]);
+            test(packedBelow[j] == below[j]);
+        }
+    }
+}
+
 int main() {
     testGeometry();
     testTopology();
     testGeometryCombinedWithTopology();
+    testStencils();
 
     return 0;
 }
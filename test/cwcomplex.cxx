@@ -1,5 +1,7 @@
 #include <stdexcept>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include "cwx/cwcomplex.hxx"
 
@@ -168,6 +170,74 @@ int main() {
         test(complex.below(3, 4, 0) == 4);
         test(complex.below(3, 4, 1) == 5);
         test(complex.below(3, 4, 2) == 6);
+
+        // bulk insertion of the same connections, unsorted and with duplicates
+        CWComplex bulk(1, 4, 6, 4);
+        std::vector<std::pair<Label, Label> > pairs[3];
+        pairs[0] = {{1, 1}, {1, 2}, {1, 4}, {1, 3}, {1, 2}};
+        pairs[1] = {{1, 3}, {1, 4}, {1, 5}, {2, 1}, {2, 2}, {2, 3}, {3, 2},
+            {3, 4}, {3, 6}, {4, 1}, {4, 5}, {4, 6}, {2, 1}};
+        pairs[2] = {{2, 3}, {2, 1}, {1, 1}, {1, 2}, {3, 2}, {3, 3}, {4, 3},
+            {4, 4}, {5, 2}, {5, 4}, {6, 1}, {6, 4}};
+        for(unsigned char order = 0; order < 3; ++order) {
+            bulk.connectPairs(order, pairs[order].begin(), pairs[order].end());
+        }
+        for(unsigned char order = 0; order < 4; ++order) {
+            for(Label label = 1; label <= complex.numberOfCells(order); ++label) {
+                test(bulk.sizeAbove(order, label) == complex.sizeAbove(order, label));
+                test(bulk.sizeBelow(order, label) == complex.sizeBelow(order, label));
+                for(size_t j = 0; j < complex.sizeAbove(order, label); ++j) {
+                    test(bulk.above(order, label, j) == complex.above(order, label, j));
+                }
+                for(size_t j = 0; j < complex.sizeBelow(order, label); ++j) {
+                    test(bulk.below(order, label, j) == complex.below(order, label, j));
+                }
+            }
+        }
+
+        // erase a 2-cell. the last 2-cell takes its label
+        bulk.erase(2, 2);
+        test(bulk.numberOfCells(2) == 5);
+        test(bulk.above(2, 2, 0) == 1 && bulk.above(2, 2, 1) == 4);
+        test(bulk.sizeBelow(2, 2) == 2);
+        test(bulk.below(2, 2, 0) == 3 && bulk.below(2, 2, 1) == 4);
+        test(bulk.sizeAbove(1, 2) == 2);
+        test(bulk.above(1, 2, 0) == 1 && bulk.above(1, 2, 1) == 3);
+        test(bulk.sizeAbove(1, 3) == 2);
+        test(bulk.above(1, 3, 0) == 2 && bulk.above(1, 3, 1) == 4);
+        test(bulk.sizeAbove(1, 4) == 3);
+        test(bulk.above(1, 4, 0) == 1 && bulk.above(1, 4, 1) == 2 && bulk.above(1, 4, 2) == 5);
+        test(bulk.sizeBelow(3, 1) == 2);
+        test(bulk.below(3, 1, 0) == 1 && bulk.below(3, 1, 1) == 2);
+        test(bulk.sizeBelow(3, 3) == 2);
+        test(bulk.below(3, 3, 0) == 3 && bulk.below(3, 3, 1) == 4);
+        test(bulk.sizeBelow(3, 4) == 3);
+        test(bulk.below(3, 4, 0) == 2 && bulk.below(3, 4, 1) == 4 && bulk.below(3, 4, 2) == 5);
+
+        // merge the 3-cell 4 into the 3-cell 3 and erase it
+        bulk.merge(3, 4, 3);
+        test(bulk.sizeBelow(3, 4) == 0);
+        bulk.erase(3, 4);
+        test(bulk.numberOfCells(3) == 3);
+        test(bulk.sizeBelow(3, 3) == 4);
+        test(bulk.below(3, 3, 0) == 2 && bulk.below(3, 3, 1) == 3
+            && bulk.below(3, 3, 2) == 4 && bulk.below(3, 3, 3) == 5);
+        test(bulk.above(2, 2, 0) == 1 && bulk.above(2, 2, 1) == 3);
+        test(bulk.above(2, 4, 0) == 3 && bulk.above(2, 4, 1) == 0);
+        test(bulk.above(2, 5, 0) == 2 && bulk.above(2, 5, 1) == 3);
+
+        // isolate a 1-cell
+        bulk.isolate(1, 4);
+        test(bulk.sizeAbove(1, 4) == 0);
+        test(bulk.sizeBelow(1, 4) == 0);
+        test(bulk.sizeAbove(0, 1) == 3);
+        test(bulk.sizeBelow(2, 1) == 1);
+
+        // disconnect a 2-cell from a 3-cell
+        const size_t n = bulk.sizeBelow(3, 2);
+        bulk.disconnect(2, 5, 2);
+        test(bulk.above(2, 5, 0) == 3 && bulk.above(2, 5, 1) == 0);
+        test(bulk.sizeBelow(3, 2) == n - 1);
     }
 
     return 0;
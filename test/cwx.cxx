@@ -1,9 +1,78 @@
+#include <random>
+#include <array>
+#include <set>
+#include <vector>
+#include <utility>
+
 #include "cwx/cwx.hxx"
 
 inline void test(const bool& pred) {
     if(!pred) throw std::runtime_error("Test failed.");
 }
 
+// loads slabs of a segmentation held in memory and records the slabs
+class SlabLoader {
+public:
+    typedef unsigned int value_type;
+
+    SlabLoader(const andres::Marray<unsigned int>& seg)
+        : seg_(seg), slabs_()
+        {}
+    size_t shape(const size_t j) const
+        { return seg_.shape(j); }
+    void operator()(const size_t sliceBegin, const size_t sliceEnd, andres::Marray<value_type>& out)
+        {
+            const size_t shape[] = {seg_.shape(0), seg_.shape(1), sliceEnd - sliceBegin};
+            out.resize(shape, shape + 3);
+            for(size_t z = sliceBegin; z < sliceEnd; ++z)
+            for(size_t y = 0; y < shape[1]; ++y)
+            for(size_t x = 0; x < shape[0]; ++x) {
+                out(x, y, z - sliceBegin) = seg_(x, y, z);
+            }
+            slabs_.push_back(std::make_pair(sliceBegin, sliceEnd));
+        }
+    const std::vector<std::pair<size_t, size_t> >& slabs() const
+        { return slabs_; }
+
+private:
+    const andres::Marray<unsigned int>& seg_;
+    std::vector<std::pair<size_t, size_t> > slabs_;
+};
+
+// functor to be used with CWX::process(order, functor)
+class ComponentCollector {
+public:
+    typedef cwx::Cell<unsigned int> Cell;
+
+    const std::set<std::set<Cell> >& components() const
+        { return components_; }
+    bool preprocess(const Cell&)
+        { cells_.clear(); return true; }
+    bool operator()(const Cell& cell)
+        { cells_.insert(cell); return true; }
+    bool postprocess()
+        { components_.insert(cells_); return true; }
+
+private:
+    std::set<Cell> cells_;
+    std::set<std::set<Cell> > components_;
+};
+
+// functor to be used with CWX::parallelProcess
+class LabeledCellCollector {
+public:
+    typedef unsigned int Label;
+    typedef cwx::Cell<unsigned int> Cell;
+
+    const std::vector<std::pair<Label, Cell> >& cells() const
+        { return cells_; }
+    bool operator()(const Label label, const Cell& cell)
+        { cells_.push_back(std::make_pair(label, cell)); return true; }
+
+private:
+    std::vector<std::pair<Label, Cell> > cells_;
+};
+
 int main() {
     typedef unsigned int Label;
     typedef unsigned int Coordinate;
@@ -96,6 +165,19 @@ int main() {
             }
         }
     }
+    for(Label j = 1; j <= cwx.numberOfCells(2); ++j) {
+        cwx::CellCollector<Coordinate> mesh;
+        cwx.process(2, j, mesh);
+        cwx::CellCollector<Coordinate> fixedMesh;
+        cwx.process<2>(j, fixedMesh);
+        test(fixedMesh.cells() == mesh.cells());
+    }
+    {
+        cwx::CellCollector<Coordinate> mesh;
+        cwx.process<0>(1, mesh);
+        test(mesh.cells().size() == 1);
+        test(mesh.cells()[0] == Cell(3, 3, 3));
+    }
 
     // labeledCellGrid
     {
@@ -129,5 +211,716 @@ int main() {
         }
     }
 
+    // labeledCellSlice and labeledVoxelSlice
+    for(unsigned char d = 0; d < 3; ++d) {
+        const unsigned char d0 = d == 0 ? 1 : 0;
+        const unsigned char d1 = d == 2 ? 1 : 2;
+        for(Coordinate v = 0; v < 2 * cwx.shape(d) - 1; ++v) {
+            andres::Marray<float> labeledCellSlice;
+            cwx.labeledCellSlice(d, v, labeledCellSlice);
+            test(labeledCellSlice.dimension() == 2);
+            test(labeledCellSlice.shape(0) == cwx.shape(d0) * 2 - 1);
+            test(labeledCellSlice.shape(1) == cwx.shape(d1) * 2 - 1);
+            Cell c;
+            c[d] = v;
+            for(c[d1] = 0; c[d1] < labeledCellSlice.shape(1); ++c[d1])
+            for(c[d0] = 0; c[d0] < labeledCellSlice.shape(0); ++c[d0]) {
+                test(labeledCellSlice(c[d0], c[d1]) == cwx.atCell(c));
+            }
+        }
+        for(Coordinate v = 0; v < cwx.shape(d); ++v) {
+            andres::Marray<float> labeledVoxelSlice;
+            cwx.labeledVoxelSlice(d, v, labeledVoxelSlice);
+            test(labeledVoxelSlice.dimension() == 2);
+            test(labeledVoxelSlice.shape(0) == cwx.shape(d0));
+            test(labeledVoxelSlice.shape(1) == cwx.shape(d1));
+            for(Coordinate y = 0; y < cwx.shape(d1); ++y)
+            for(Coordinate x = 0; x < cwx.shape(d0); ++x) {
+                Cell c;
+                c[d] = 2 * v;
+                c[d0] = 2 * x;
+                c[d1] = 2 * y;
+                test(labeledVoxelSlice(x, y) == cwx.atCell(c));
+            }
+        }
+    }
+
+    // merge
+    {
+        CWX mergedCWX;
+        mergedCWX.build(seg);
+        const Label labels[] = {
+            mergedCWX.atVoxel(0, 0, 0), mergedCWX.atVoxel(3, 0, 0),
+            mergedCWX.atVoxel(0, 3, 0), mergedCWX.atVoxel(3, 3, 0),
+            mergedCWX.atVoxel(3, 3, 3)
+        };
+
+        // 3-cells that are equal or touch only at the 0-cell cannot be merged
+        for(size_t j = 0; j < 2; ++j) {
+            bool thrown = false;
+            try {
+                mergedCWX.merge(labels[0], labels[4 * j]);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+        }
+
+        // the 2-cell between the 3-cells is removed
+        mergedCWX.merge(labels[0], labels[1]);
+        test(mergedCWX.numberOfCells(3) == 7);
+        test(mergedCWX.numberOfCells(2) == 11);
+        test(mergedCWX.numberOfCells(1) == 6);
+        test(mergedCWX.numberOfCells(0) == 1);
+        test(mergedCWX.atVoxel(0, 0, 0) == mergedCWX.atVoxel(3, 0, 0));
+        test(!mergedCWX.isMarked(Cell(3, 1, 1)));
+
+        // the 1-cell at the center of the bottom half bounds two 2-cells
+        // afterwards. it is removed, and the 2-cells are merged
+        mergedCWX.merge(mergedCWX.atVoxel(0, 3, 0), mergedCWX.atVoxel(3, 3, 0));
+        test(mergedCWX.numberOfCells(3) == 6);
+        test(mergedCWX.numberOfCells(2) == 9);
+        test(mergedCWX.numberOfCells(1) == 5);
+        test(mergedCWX.numberOfCells(0) == 1);
+        test(!mergedCWX.isMarked(Cell(3, 3, 1)));
+        test(mergedCWX.atCell(Cell(1, 3, 1)) == mergedCWX.atCell(Cell(5, 3, 1)));
+
+        mergedCWX.merge(mergedCWX.atVoxel(0, 0, 0), mergedCWX.atVoxel(0, 3, 0));
+        test(mergedCWX.numberOfCells(3) == 5);
+        test(mergedCWX.numberOfCells(2) == 8);
+        test(mergedCWX.numberOfCells(1) == 5);
+        test(mergedCWX.numberOfCells(0) == 1);
+    }
+
+    // parallel build
+    {
+        size_t size[] = {11, 9, 13};
+        andres::Marray<Label> seg(size, size + 3);
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<Label> distribution(1, 4);
+        std::vector<Label> blockLabels(4 * 4 * 5);
+        for(size_t j = 0; j < blockLabels.size(); ++j) {
+            blockLabels[j] = distribution(generator);
+        }
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            seg(x, y, z) = blockLabels[x / 3 + 4 * (y / 3) + 16 * (z / 3)];
+        }
+
+        CWX serialCWX;
+        serialCWX.build(seg);
+
+        // build statistics
+        {
+            const cwx::BuildStats& stats = serialCWX.buildStats();
+            for(unsigned char order = 0; order < 4; ++order) {
+                test(stats.numberOfCells[order] == serialCWX.numberOfCells(order));
+                test(stats.labelingTime[order] >= 0);
+            }
+            test(stats.numberOfAnchors >= serialCWX.numberOfCells(0) + serialCWX.numberOfCells(1)
+                + serialCWX.numberOfCells(2) + serialCWX.numberOfCells(3));
+            test(stats.numberOfVisitedCells > 0); // redundant anchors
+            test(stats.loadingTime == 0);
+            test(stats.totalTime >= stats.markingTime + stats.redundantAnchorTime);
+            test(stats.gridMemory == size[0] * size[1] * size[2]);
+            test(stats.complexMemory > 0);
+            test(stats.anchorageMemory > 0);
+            test(stats.labelCacheMemory == 0);
+            test(stats.peakMemory == serialCWX.buildMemory());
+        }
+
+        // cell-wise marking for views that are not contiguous along rows
+        {
+            const andres::CoordinateOrder otherOrder =
+                seg.coordinateOrder() == andres::FirstMajorOrder
+                ? andres::LastMajorOrder : andres::FirstMajorOrder;
+            andres::Marray<Label> otherSeg(size, size + 3, 0, otherOrder);
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                otherSeg(x, y, z) = seg(x, y, z);
+            }
+            CWX otherCWX;
+            otherCWX.build(otherSeg, false, 3);
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                test(otherCWX.grid()(x, y, z) == serialCWX.grid()(x, y, z));
+            }
+        }
+        for(size_t numberOfThreads = 2; numberOfThreads < 20; numberOfThreads *= 3) {
+            CWX parallelCWX;
+            parallelCWX.build(seg, false, numberOfThreads);
+            for(unsigned char order = 0; order < 4; ++order) {
+                test(parallelCWX.numberOfCells(order) == serialCWX.numberOfCells(order));
+            }
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                test(parallelCWX.grid()(x, y, z) == serialCWX.grid()(x, y, z));
+                test(parallelCWX.atVoxel(x, y, z) == serialCWX.atVoxel(x, y, z));
+            }
+            Cell cell;
+            CWX::TraversalWorkspaceType workspace;
+            for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+            for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+            for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                    test(parallelCWX.atCell(cell, workspace) == serialCWX.atCell(cell));
+                }
+            }
+        }
+
+        // build from slabs, with a budget of half the memory of the
+        // segmentation
+        for(size_t numberOfThreads = 1; numberOfThreads < 4; numberOfThreads += 2) {
+            size_t size[] = {8, 8, 200};
+            andres::Marray<Label> seg(size, size + 3);
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                seg(x, y, z) = blockLabels[x / 4 + 4 * (y / 4) + 16 * (z / 40)];
+            }
+            CWX serialCWX;
+            serialCWX.build(seg);
+
+            const size_t numberOfVoxels = size[0] * size[1] * size[2];
+            const size_t sliceMemory = size[0] * size[1] * sizeof(SlabLoader::value_type);
+            const size_t budget = numberOfVoxels * sizeof(Label) / 2;
+            SlabLoader loader(seg);
+            CWX slabCWX;
+            bool thrown = false;
+            try { // too small for the grid and two slices
+                slabCWX.buildFromSlabs(loader, numberOfVoxels + sliceMemory, false, numberOfThreads);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+            thrown = false;
+            try { // too small for the grid and the buffers for labeling
+                slabCWX.buildFromSlabs(loader, numberOfVoxels + 2 * sliceMemory, false, numberOfThreads);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+            test(loader.slabs().empty());
+
+            // slabs as thick as the budget permits next to the grid, and a
+            // halo of one slice
+            slabCWX.buildFromSlabs(loader, budget, false, numberOfThreads);
+            const size_t slabSize = (budget - numberOfVoxels) / sliceMemory - 1;
+            test(loader.slabs().size() == (size[2] + slabSize - 1) / slabSize);
+            test(loader.slabs().size() > 1);
+            for(size_t j = 0; j < loader.slabs().size(); ++j) {
+                test(loader.slabs()[j].first == slabSize * j);
+                test(loader.slabs()[j].second == std::min(slabSize * (j + 1) + 1, size[2]));
+            }
+            test(slabCWX.buildMemory() >= numberOfVoxels + slabSize * sliceMemory);
+            test(slabCWX.buildMemory() < numberOfVoxels * sizeof(Label));
+            for(unsigned char order = 0; order < 4; ++order) {
+                test(slabCWX.numberOfCells(order) == serialCWX.numberOfCells(order));
+            }
+            Cell cell;
+            for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+            for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+            for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                test(slabCWX.isMarked(cell) == serialCWX.isMarked(cell));
+                if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                    test(slabCWX.atCell(cell) == serialCWX.atCell(cell));
+                }
+            }
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                test(slabCWX.grid()(x, y, z) == serialCWX.grid()(x, y, z));
+            }
+        }
+
+        // sparse grid, for a background with a box and a voxel in it
+        {
+            typedef cwx::CWX<Label, Coordinate, cwx::SparseLayout<4> > SparseCWX;
+            size_t size[] = {24, 20, 22};
+            andres::Marray<Label> seg(size, size + 3);
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                seg(x, y, z) = x >= 5 && x < 9 && y >= 6 && y < 11 && z >= 4 && z < 8 ? 2 : 1;
+            }
+            seg(20, 15, 18) = 3;
+            CWX denseCWX;
+            denseCWX.build(seg);
+            for(size_t numberOfThreads = 1; numberOfThreads < 4; numberOfThreads += 2) {
+                SparseCWX sparseCWX;
+                sparseCWX.build(seg, false, numberOfThreads);
+                test(sparseCWX.buildStats().gridMemory < denseCWX.buildStats().gridMemory);
+                {
+                    CWX threadedCWX;
+                    threadedCWX.build(seg, false, numberOfThreads);
+                    test(sparseCWX.buildMemory() < threadedCWX.buildMemory());
+                }
+                for(unsigned char order = 0; order < 4; ++order) {
+                    test(sparseCWX.numberOfCells(order) == denseCWX.numberOfCells(order));
+                }
+                const andres::Marray<unsigned char> grid = sparseCWX.grid();
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    test(grid(x, y, z) == denseCWX.grid()(x, y, z));
+                    test(sparseCWX.atVoxel(x, y, z) == denseCWX.atVoxel(x, y, z));
+                }
+                Cell cell;
+                for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+                for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+                for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                    test(sparseCWX.isMarked(cell) == denseCWX.isMarked(cell));
+                    if(cell.order() != 0 || denseCWX.isMarked(cell)) {
+                        test(sparseCWX.atCell(cell) == denseCWX.atCell(cell));
+                    }
+                }
+                andres::Marray<Label> sparseCells;
+                andres::Marray<Label> denseCells;
+                sparseCWX.labeledCellGrid(sparseCells, 2);
+                denseCWX.labeledCellGrid(denseCells, 2);
+                test(std::equal(sparseCells.begin(), sparseCells.end(), denseCells.begin()));
+            }
+
+            // update, removing the box
+            SparseCWX sparseCWX;
+            sparseCWX.build(seg);
+            size_t shape[] = {6, 7, 6};
+            andres::Marray<Label> block(shape, shape + 3, 1);
+            const std::array<Coordinate, 3> offset = {{4, 5, 3}};
+            sparseCWX.update(offset, block);
+            denseCWX.update(offset, block);
+            for(unsigned char order = 0; order < 4; ++order) {
+                test(sparseCWX.numberOfCells(order) == denseCWX.numberOfCells(order));
+            }
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                test(sparseCWX.atVoxel(x, y, z) == denseCWX.atVoxel(x, y, z));
+            }
+        }
+
+        // label caches
+        for(size_t mode = CWX::VoxelLabelCache; mode <= CWX::CellLabelCache; ++mode) {
+            CWX cachedCWX(true, static_cast<CWX::LabelCacheMode>(mode));
+            cachedCWX.build(seg, false, 2);
+            test(serialCWX.labelCacheMemory() == 0);
+            test(cachedCWX.labelCacheMemory() >= size[0] * size[1] * size[2] * sizeof(Label));
+            Cell cell;
+            for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+            for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+            for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                    test(cachedCWX.atCell(cell) == serialCWX.atCell(cell));
+                }
+            }
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                test(cachedCWX.atVoxel(x, y, z) == serialCWX.atVoxel(x, y, z));
+            }
+        }
+
+        // export in parallel
+        for(size_t redundantAnchors = 0; redundantAnchors < 2; ++redundantAnchors) {
+            CWX exportCWX(redundantAnchors == 1);
+            exportCWX.build(seg);
+            for(size_t numberOfThreads = 1; numberOfThreads < 20; numberOfThreads *= 4) {
+                andres::Marray<Label> labeledCellGrid;
+                exportCWX.labeledCellGrid(labeledCellGrid, numberOfThreads);
+                Cell cell;
+                for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+                for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+                for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                    if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                        test(labeledCellGrid(cell[0], cell[1], cell[2]) == serialCWX.atCell(cell));
+                    }
+                    else {
+                        test(labeledCellGrid(cell[0], cell[1], cell[2]) == 0);
+                    }
+                }
+                andres::Marray<Label> labeledVoxelGrid;
+                exportCWX.labeledVoxelGrid(labeledVoxelGrid, numberOfThreads);
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    test(labeledVoxelGrid(x, y, z) == serialCWX.atVoxel(x, y, z));
+                }
+            }
+
+            // slices are labeled by the anchors they contain
+            for(unsigned char d = 0; d < 3; ++d) {
+                const unsigned char d0 = d == 0 ? 1 : 0;
+                const unsigned char d1 = d == 2 ? 1 : 2;
+                for(Coordinate v = 0; v < 2 * size[d] - 1; ++v) {
+                    andres::Marray<Label> labeledCellSlice;
+                    exportCWX.labeledCellSlice(d, v, labeledCellSlice);
+                    Cell cell;
+                    cell[d] = v;
+                    for(cell[d1] = 0; cell[d1] < 2 * size[d1] - 1; ++cell[d1])
+                    for(cell[d0] = 0; cell[d0] < 2 * size[d0] - 1; ++cell[d0]) {
+                        if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                            test(labeledCellSlice(cell[d0], cell[d1]) == serialCWX.atCell(cell));
+                        }
+                        else {
+                            test(labeledCellSlice(cell[d0], cell[d1]) == 0);
+                        }
+                    }
+                }
+            }
+        }
+
+        // process in parallel
+        for(size_t redundantAnchors = 0; redundantAnchors < 2; ++redundantAnchors) {
+            CWX processCWX(redundantAnchors == 1);
+            processCWX.build(seg);
+            auto factory = []() { return LabeledCellCollector(); };
+            for(unsigned char order = 0; order < 4; ++order) {
+                const Label n = processCWX.numberOfCells(order);
+                std::vector<std::set<Cell> > serialCells(n + 1);
+                for(Label label = 1; label <= n; ++label) {
+                    cwx::CellCollector<Coordinate> collector;
+                    processCWX.process(order, label, collector);
+                    serialCells[label].insert(collector.cells().begin(), collector.cells().end());
+                }
+                if(order > 0) { // for 0-cells, only preprocess is called
+                    ComponentCollector components;
+                    processCWX.process(order, components);
+                    std::set<std::set<Cell> > expected(serialCells.begin() + 1, serialCells.end());
+                    test(components.components().size() == n);
+                    test(components.components() == expected);
+                }
+                for(size_t numberOfThreads = 1; numberOfThreads < 20; numberOfThreads *= 4) {
+                    std::vector<LabeledCellCollector> collectors;
+                    processCWX.parallelProcess(order, 1, n + 1, factory, collectors, numberOfThreads);
+                    test(collectors.size() == std::min<size_t>(numberOfThreads, n));
+                    std::vector<std::set<Cell> > parallelCells(n + 1);
+                    for(size_t j = 0; j < collectors.size(); ++j) {
+                        for(size_t k = 0; k < collectors[j].cells().size(); ++k) {
+                            const std::pair<Label, Cell>& p = collectors[j].cells()[k];
+                            test(parallelCells[p.first].insert(p.second).second); // each cell once
+                        }
+                    }
+                    test(parallelCells == serialCells);
+                }
+                // 0 threads means the number of hardware threads
+                {
+                    std::vector<LabeledCellCollector> collectors;
+                    processCWX.parallelProcess(order, 1, n + 1, factory, collectors, 0);
+                    test(collectors.size() == std::min<size_t>(cwx::hardwareConcurrency(), n));
+                    std::vector<std::set<Cell> > parallelCells(n + 1);
+                    for(size_t j = 0; j < collectors.size(); ++j) {
+                        for(size_t k = 0; k < collectors[j].cells().size(); ++k) {
+                            const std::pair<Label, Cell>& p = collectors[j].cells()[k];
+                            test(parallelCells[p.first].insert(p.second).second);
+                        }
+                    }
+                    test(parallelCells == serialCells);
+                }
+                // sub-range
+                if(n > 2) {
+                    std::vector<LabeledCellCollector> collectors;
+                    processCWX.parallelProcess(order, 2, n, factory, collectors, 3);
+                    for(size_t j = 0; j < collectors.size(); ++j) {
+                        for(size_t k = 0; k < collectors[j].cells().size(); ++k) {
+                            test(collectors[j].cells()[k].first >= 2);
+                            test(collectors[j].cells()[k].first < n);
+                        }
+                    }
+                }
+                std::vector<LabeledCellCollector> collectors;
+                bool thrown = false;
+                try {
+                    processCWX.parallelProcess(order, 0, n, factory, collectors, 2);
+                }
+                catch(std::runtime_error&) {
+                    thrown = true;
+                }
+                test(thrown);
+                thrown = false;
+                try {
+                    processCWX.parallelProcess(order, 1, n + 2, factory, collectors, 2);
+                }
+                catch(std::runtime_error&) {
+                    thrown = true;
+                }
+                test(thrown);
+            }
+        }
+
+        // concurrent const queries
+        {
+            CWX sharedCWX;
+            sharedCWX.build(seg);
+            cwx::parallelFor(4, [&](const size_t thread) {
+                Cell cell;
+                for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+                for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+                for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                    test(sharedCWX.isMarked(cell) == serialCWX.isMarked(cell));
+                    if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                        test(sharedCWX.atCell(cell) == serialCWX.atCell(cell));
+                    }
+                }
+                for(unsigned char order = 1; order < 4; ++order) {
+                    for(Label label = 1 + thread; label <= sharedCWX.numberOfCells(order); label += 4) {
+                        cwx::CellCollector<Coordinate> collector;
+                        sharedCWX.process(order, label, collector);
+                        for(size_t k = 0; k < collector.cells().size(); ++k) {
+                            test(sharedCWX.atCell(collector.cells()[k]) == label);
+                        }
+                        for(size_t k = 0; k < sharedCWX.sizeBelow(order, label); ++k) {
+                            test(sharedCWX.below(order, label, k) == serialCWX.below(order, label, k));
+                        }
+                    }
+                }
+            });
+        }
+
+        // merge 3-cells and compare to a build from the merged segmentation.
+        // label caches are compared to the labels of a CWX without cache.
+        for(size_t variant = 0; variant < 4; ++variant) {
+            const bool redundantAnchors = variant % 2 == 1;
+            const CWX::LabelCacheMode mode = variant < 2 ? CWX::NoLabelCache
+                : (variant == 2 ? CWX::VoxelLabelCache : CWX::CellLabelCache);
+            CWX mergedCWX(redundantAnchors, mode);
+            mergedCWX.build(seg);
+            CWX uncachedCWX(redundantAnchors);
+            if(mode != CWX::NoLabelCache) {
+                uncachedCWX.build(seg);
+            }
+            andres::Marray<Label> components(size, size + 3);
+            for(size_t z = 0; z < size[2]; ++z)
+            for(size_t y = 0; y < size[1]; ++y)
+            for(size_t x = 0; x < size[0]; ++x) {
+                components(x, y, z) = mergedCWX.atVoxel(x, y, z);
+            }
+            std::vector<Label> componentOfLabel(mergedCWX.numberOfCells(3) + 1);
+            for(Label label = 0; label < componentOfLabel.size(); ++label) {
+                componentOfLabel[label] = label;
+            }
+            for(size_t j = 0; j < 12 && mergedCWX.numberOfCells(2) > 0; ++j) {
+                const Label twoCell = 1 + (7 * j) % mergedCWX.numberOfCells(2);
+                const Label a = mergedCWX.above(2, twoCell, j % 2);
+                const Label b = mergedCWX.above(2, twoCell, 1 - j % 2);
+                const Label last = mergedCWX.numberOfCells(3);
+                const Label mergedLabel = mergedCWX.merge(a, b);
+                mergedCWX.testInvariant();
+                test(mergedLabel == (a == last ? b : a));
+                if(mode != CWX::NoLabelCache) {
+                    test(uncachedCWX.merge(a, b) == mergedLabel);
+                }
+                test(mergedCWX.numberOfCells(3) == last - 1);
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    if(components(x, y, z) == componentOfLabel[b]) {
+                        components(x, y, z) = componentOfLabel[a];
+                    }
+                }
+                componentOfLabel[b] = componentOfLabel[last];
+                componentOfLabel.pop_back();
+
+                CWX rebuiltCWX;
+                rebuiltCWX.build(components);
+                for(unsigned char order = 0; order < 4; ++order) {
+                    test(mergedCWX.numberOfCells(order) == rebuiltCWX.numberOfCells(order));
+                }
+                // labels are equal up to a bijection
+                std::vector<Label> labelMaps[4];
+                std::vector<Label> inverseLabelMaps[4];
+                for(unsigned char order = 0; order < 4; ++order) {
+                    labelMaps[order].resize(mergedCWX.numberOfCells(order) + 1, 0);
+                    inverseLabelMaps[order].resize(mergedCWX.numberOfCells(order) + 1, 0);
+                }
+                Cell cell;
+                for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+                for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+                for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                    test(cell.order() == 3 || mergedCWX.isMarked(cell) == rebuiltCWX.isMarked(cell));
+                    if(cell.order() == 3 || mergedCWX.isMarked(cell)) {
+                        const Label label = mergedCWX.atCell(cell);
+                        if(mode != CWX::NoLabelCache) {
+                            test(label == uncachedCWX.atCell(cell));
+                        }
+                        const Label rebuiltLabel = rebuiltCWX.atCell(cell);
+                        if(labelMaps[cell.order()][label] == 0) {
+                            test(inverseLabelMaps[cell.order()][rebuiltLabel] == 0);
+                            labelMaps[cell.order()][label] = rebuiltLabel;
+                            inverseLabelMaps[cell.order()][rebuiltLabel] = label;
+                        }
+                        test(labelMaps[cell.order()][label] == rebuiltLabel);
+                    }
+                }
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    test(componentOfLabel[mergedCWX.atVoxel(x, y, z)] == components(x, y, z));
+                }
+                // the CW-complexes are equal up to the bijection
+                for(unsigned char order = 0; order < 3; ++order) {
+                    for(Label label = 1; label <= mergedCWX.numberOfCells(order); ++label) {
+                        const Label rebuiltLabel = labelMaps[order][label];
+                        test(mergedCWX.sizeAbove(order, label) == rebuiltCWX.sizeAbove(order, rebuiltLabel));
+                        std::vector<Label> labelsAbove;
+                        for(size_t k = 0; k < mergedCWX.sizeAbove(order, label); ++k) {
+                            labelsAbove.push_back(labelMaps[order + 1][mergedCWX.above(order, label, k)]);
+                        }
+                        std::sort(labelsAbove.begin(), labelsAbove.end());
+                        for(size_t k = 0; k < labelsAbove.size(); ++k) {
+                            test(labelsAbove[k] == rebuiltCWX.above(order, rebuiltLabel, k));
+                        }
+                    }
+                }
+            }
+        }
+
+        // update boxes of voxels and compare to a build from the updated
+        // segmentation. label caches are compared to the labels of a CWX
+        // without cache.
+        std::mt19937 randomEngine(42);
+        for(size_t variant = 0; variant < 4; ++variant) {
+            const bool redundantAnchors = variant % 2 == 1;
+            const CWX::LabelCacheMode mode = variant < 2 ? CWX::NoLabelCache
+                : (variant == 2 ? CWX::VoxelLabelCache : CWX::CellLabelCache);
+            CWX updatedCWX(redundantAnchors, mode);
+            updatedCWX.build(seg);
+            CWX uncachedCWX(redundantAnchors);
+            if(mode != CWX::NoLabelCache) {
+                uncachedCWX.build(seg);
+            }
+            andres::Marray<Label> edited = seg;
+            for(size_t j = 0; j < 24; ++j) {
+                // the box is filled with a new label, with the label of a
+                // voxel next to it or with random labels
+                size_t begin[3];
+                size_t end[3];
+                for(size_t d = 0; d < 3; ++d) {
+                    begin[d] = randomEngine() % size[d];
+                    end[d] = std::min(size[d], begin[d] + 1 + randomEngine() % 4);
+                }
+                const Label neighborLabel = edited(std::min(end[0], size[0] - 1), begin[1], begin[2]);
+                for(size_t z = begin[2]; z < end[2]; ++z)
+                for(size_t y = begin[1]; y < end[1]; ++y)
+                for(size_t x = begin[0]; x < end[0]; ++x) {
+                    if(j % 3 == 0) {
+                        edited(x, y, z) = static_cast<Label>(100 + j);
+                    }
+                    else if(j % 3 == 1) {
+                        edited(x, y, z) = neighborLabel;
+                    }
+                    else {
+                        edited(x, y, z) = 1 + randomEngine() % 3;
+                    }
+                }
+
+                // labels before the update
+                andres::Marray<Label> oldLabels(size, size + 3);
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    oldLabels(x, y, z) = updatedCWX.atVoxel(x, y, z);
+                }
+
+                // the box with a margin of one voxel
+                std::array<Coordinate, 3> offset;
+                size_t shape[3];
+                for(size_t d = 0; d < 3; ++d) {
+                    offset[d] = begin[d] == 0 ? 0 : static_cast<Coordinate>(begin[d] - 1);
+                    shape[d] = std::min(end[d] + 1, size[d]) - offset[d];
+                }
+                andres::Marray<Label> block(shape, shape + 3);
+                std::set<Label> touchedLabels;
+                for(size_t z = 0; z < shape[2]; ++z)
+                for(size_t y = 0; y < shape[1]; ++y)
+                for(size_t x = 0; x < shape[0]; ++x) {
+                    block(x, y, z) = edited(offset[0] + x, offset[1] + y, offset[2] + z);
+                    touchedLabels.insert(oldLabels(offset[0] + x, offset[1] + y, offset[2] + z));
+                }
+                updatedCWX.update(offset, block);
+                updatedCWX.testInvariant();
+                if(mode != CWX::NoLabelCache) {
+                    uncachedCWX.update(offset, block);
+                }
+
+                CWX rebuiltCWX;
+                rebuiltCWX.build(edited);
+                for(unsigned char order = 0; order < 4; ++order) {
+                    test(updatedCWX.numberOfCells(order) == rebuiltCWX.numberOfCells(order));
+                }
+                // labels are equal up to a bijection
+                std::vector<Label> labelMaps[4];
+                std::vector<Label> inverseLabelMaps[4];
+                for(unsigned char order = 0; order < 4; ++order) {
+                    labelMaps[order].resize(updatedCWX.numberOfCells(order) + 1, 0);
+                    inverseLabelMaps[order].resize(updatedCWX.numberOfCells(order) + 1, 0);
+                }
+                Cell cell;
+                for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+                for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+                for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+                    test(cell.order() == 3 || updatedCWX.isMarked(cell) == rebuiltCWX.isMarked(cell));
+                    if(cell.order() == 3 || updatedCWX.isMarked(cell)) {
+                        const Label label = updatedCWX.atCell(cell);
+                        if(mode != CWX::NoLabelCache) {
+                            test(label == uncachedCWX.atCell(cell));
+                        }
+                        const Label rebuiltLabel = rebuiltCWX.atCell(cell);
+                        if(labelMaps[cell.order()][label] == 0) {
+                            test(inverseLabelMaps[cell.order()][rebuiltLabel] == 0);
+                            labelMaps[cell.order()][label] = rebuiltLabel;
+                            inverseLabelMaps[cell.order()][rebuiltLabel] = label;
+                        }
+                        test(labelMaps[cell.order()][label] == rebuiltLabel);
+                    }
+                }
+                // the CW-complexes are equal up to the bijection
+                for(unsigned char order = 0; order < 3; ++order) {
+                    for(Label label = 1; label <= updatedCWX.numberOfCells(order); ++label) {
+                        const Label rebuiltLabel = labelMaps[order][label];
+                        test(updatedCWX.sizeAbove(order, label) == rebuiltCWX.sizeAbove(order, rebuiltLabel));
+                        std::vector<Label> labelsAbove;
+                        for(size_t k = 0; k < updatedCWX.sizeAbove(order, label); ++k) {
+                            labelsAbove.push_back(labelMaps[order + 1][updatedCWX.above(order, label, k)]);
+                        }
+                        std::sort(labelsAbove.begin(), labelsAbove.end());
+                        for(size_t k = 0; k < labelsAbove.size(); ++k) {
+                            test(labelsAbove[k] == rebuiltCWX.above(order, rebuiltLabel, k));
+                        }
+                    }
+                }
+                // 3-cells away from the box keep their labels unless these
+                // are taken by the last 3-cells
+                for(size_t z = 0; z < size[2]; ++z)
+                for(size_t y = 0; y < size[1]; ++y)
+                for(size_t x = 0; x < size[0]; ++x) {
+                    const Label label = oldLabels(x, y, z);
+                    if(touchedLabels.count(label) == 0 && label <= updatedCWX.numberOfCells(3)) {
+                        test(updatedCWX.atVoxel(x, y, z) == label);
+                    }
+                }
+            }
+        }
+        {
+            CWX otherCWX;
+            otherCWX.build(seg);
+            const std::array<Coordinate, 3> otherOffset = {{1, 0, 0}};
+            bool thrown = false;
+            try {
+                otherCWX.update(otherOffset, seg);
+            }
+            catch(std::runtime_error&) {
+                thrown = true;
+            }
+            test(thrown);
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,81 @@
+#include <stdexcept>
+
+#include "cwx/cwx.hxx"
+#include "cwx/frozen-cwcomplex.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+template<class COMPLEX, class FROZEN_COMPLEX>
+void testEqual(const COMPLEX& complex, const FROZEN_COMPLEX& frozen) {
+    typedef typename FROZEN_COMPLEX::Label Label;
+    for(unsigned char order = 0; order < 4; ++order) {
+        test(frozen.numberOfCells(order) == complex.numberOfCells(order));
+        for(Label label = 1; label <= complex.numberOfCells(order); ++label) {
+            test(frozen.sizeAbove(order, label) == complex.sizeAbove(order, label));
+            test(frozen.sizeBelow(order, label) == complex.sizeBelow(order, label));
+            test(frozen.aboveEnd(order, label) - frozen.aboveBegin(order, label)
+                == static_cast<long>(complex.sizeAbove(order, label)));
+            test(frozen.belowEnd(order, label) - frozen.belowBegin(order, label)
+                == static_cast<long>(complex.sizeBelow(order, label)));
+            for(size_t j = 0; j < complex.sizeAbove(order, label); ++j) {
+                test(frozen.above(order, label, j) == complex.above(order, label, j));
+                test(frozen.aboveBegin(order, label)[j] == complex.above(order, label, j));
+            }
+            if(order < 3) {
+                test(frozen.above(order, label, complex.sizeAbove(order, label)) == 0);
+            }
+            for(size_t j = 0; j < complex.sizeBelow(order, label); ++j) {
+                test(frozen.below(order, label, j) == complex.below(order, label, j));
+                test(frozen.belowBegin(order, label)[j] == complex.below(order, label, j));
+            }
+        }
+    }
+}
+
+int main() {
+    typedef unsigned int Label;
+    typedef unsigned int Coordinate;
+    typedef cwx::CWComplex<Label> CWComplex;
+    typedef cwx::FrozenCWComplex<Label> FrozenCWComplex;
+
+    {
+        FrozenCWComplex frozen;
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(frozen.numberOfCells(order) == 0);
+        }
+    }
+    {
+        CWComplex complex(1, 2, 3, 2);
+        complex.connect(0, 1, 1);
+        complex.connect(0, 1, 2);
+        complex.connect(1, 1, 3);
+        complex.connect(1, 1, 1);
+        complex.connect(1, 2, 2);
+        complex.connect(2, 1, 1);
+        complex.connect(2, 1, 2);
+        complex.connect(2, 2, 2);
+        complex.connect(2, 3, 1);
+        const FrozenCWComplex frozen(complex);
+        testEqual(complex, frozen);
+        test(frozen.sizeBelow(3, 1) == 2);
+        test(frozen.below(3, 1, 0) == 1);
+        test(frozen.below(3, 1, 1) == 3);
+    }
+    {
+        size_t size[] = {5, 4, 3};
+        andres::Marray<Label> seg(size, size + 3);
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            seg(x, y, z) = (x / 2) + 3 * (y / 2) + (x + z > 4);
+        }
+        cwx::CWX<Label, Coordinate> cwx;
+        cwx.build(seg);
+        const FrozenCWComplex frozen(cwx);
+        testEqual(cwx, frozen);
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "cwx/generator.hxx"
+#include "cwx/cwx.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+typedef unsigned int Label;
+typedef cwx::CWX<Label, unsigned int> CWX;
+
+// generates a segmentation with one and with several threads, tests that
+// both are equal and that all labels are positive, and builds a CWX
+template<class GENERATOR>
+void testGenerator(GENERATOR generator, const size_t minNumberOfLabels) {
+    const size_t shape[] = {21, 18, 23};
+    andres::Marray<Label> seg(shape, shape + 3);
+    andres::Marray<Label> parallelSeg(shape, shape + 3);
+    generator(seg, 1);
+    generator(parallelSeg, 4);
+    std::set<Label> labels;
+    for(size_t j = 0; j < seg.size(); ++j) {
+        test(seg(j) == parallelSeg(j));
+        test(seg(j) != 0);
+        labels.insert(seg(j));
+    }
+    test(labels.size() >= minNumberOfLabels);
+
+    CWX cwx;
+    cwx.build(seg, false, 2);
+    test(cwx.numberOfCells(3) >= labels.size());
+    test(cwx.numberOfCells(2) > 0);
+}
+
+int main() {
+    testGenerator([](andres::Marray<Label>& seg, const size_t numberOfThreads) {
+        cwx::generateVoronoi(seg, 6, 42, numberOfThreads);
+    }, 20);
+    testGenerator([](andres::Marray<Label>& seg, const size_t numberOfThreads) {
+        cwx::generateShells(seg, 3, 42, numberOfThreads);
+    }, 4);
+    testGenerator([](andres::Marray<Label>& seg, const size_t numberOfThreads) {
+        cwx::generateSheets(seg, 5, 42, numberOfThreads);
+    }, 8);
+    testGenerator([](andres::Marray<Label>& seg, const size_t numberOfThreads) {
+        cwx::generateTunnels(seg, 7, 1, 42, numberOfThreads);
+    }, 20);
+    testGenerator([](andres::Marray<Label>& seg, const size_t numberOfThreads) {
+        cwx::generateFragments(seg, 4, 42, numberOfThreads);
+    }, 100);
+
+    // labels of fragments are bounded by the number of cubes, including the
+    // cubes that are reached by shifts beyond the volume
+    for(size_t fragmentSize = 1; fragmentSize < 6; ++fragmentSize) {
+        const size_t shape[] = {11, 12, 13};
+        andres::Marray<Label> seg(shape, shape + 3);
+        cwx::generateFragments(seg, fragmentSize, 42);
+        size_t maxLabel = 1;
+        for(size_t d = 0; d < 3; ++d) {
+            maxLabel *= (shape[d] + fragmentSize - 1) / fragmentSize + 2;
+        }
+        for(size_t j = 0; j < seg.size(); ++j) {
+            test(seg(j) <= maxLabel);
+        }
+    }
+    { // the label type is checked against the largest label
+        const size_t shape[] = {16, 16, 23};
+        andres::Marray<Label> seg(shape, shape + 3);
+        cwx::generateFragments(seg, 4, 42);
+        andres::Marray<unsigned char> smallSeg(shape, shape + 3);
+        bool thrown = false;
+        try {
+            cwx::generateFragments(smallSeg, 4, 42);
+        }
+        catch(std::runtime_error&) {
+            thrown = true;
+        }
+        test(thrown || *std::max_element(seg.begin(), seg.end()) <= 255);
+    }
+
+    // seeds
+    {
+        const size_t shape[] = {16, 16, 16};
+        andres::Marray<Label> seg(shape, shape + 3);
+        andres::Marray<Label> otherSeg(shape, shape + 3);
+        cwx::generateVoronoi(seg, 5, 1);
+        cwx::generateVoronoi(otherSeg, 5, 2);
+        bool different = false;
+        for(size_t j = 0; j < seg.size(); ++j) {
+            different = different || seg(j) != otherSeg(j);
+        }
+        test(different);
+    }
+
+    // label type too small
+    {
+        const size_t shape[] = {64, 64, 64};
+        andres::Marray<unsigned char> seg(shape, shape + 3);
+        bool thrown = false;
+        try {
+            cwx::generateFragments(seg, 2);
+        }
+        catch(std::runtime_error&) {
+            thrown = true;
+        }
+        test(thrown);
+    }
+
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "andres/marray_hdf5.hxx"
+#include "cwx/hdf5.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+int main() {
+    typedef unsigned int Label;
+    typedef unsigned int Coordinate;
+    typedef cwx::Cell<Coordinate> Cell;
+    typedef cwx::CWX<Label, Coordinate> CWX;
+
+    const std::string fileName = "test-hdf5.h5";
+    size_t size[] = {11, 9, 13};
+    andres::Marray<Label> seg(size, size + 3);
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<Label> distribution(1, 4);
+    std::vector<Label> blockLabels(4 * 4 * 5);
+    for(size_t j = 0; j < blockLabels.size(); ++j) {
+        blockLabels[j] = distribution(generator);
+    }
+    for(size_t z = 0; z < size[2]; ++z)
+    for(size_t y = 0; y < size[1]; ++y)
+    for(size_t x = 0; x < size[0]; ++x) {
+        seg(x, y, z) = blockLabels[x / 3 + 4 * (y / 3) + 16 * (z / 3)];
+    }
+    {
+        hid_t file = andres::hdf5::createFile(fileName);
+        andres::hdf5::save(file, "seg", seg);
+        andres::hdf5::closeFile(file);
+    }
+
+    CWX serialCWX;
+    serialCWX.build(seg);
+
+    // slab loader
+    {
+        hid_t file = andres::hdf5::openFile(fileName);
+        cwx::HDF5SlabLoader<Label> loader(file, "seg");
+        for(size_t j = 0; j < 3; ++j) {
+            test(loader.shape(j) == size[j]);
+        }
+        andres::Marray<Label> slab;
+        loader(4, 7, slab);
+        test(slab.dimension() == 3);
+        test(slab.shape(0) == size[0] && slab.shape(1) == size[1] && slab.shape(2) == 3);
+        for(size_t z = 4; z < 7; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(slab(x, y, z - 4) == seg(x, y, z));
+        }
+        andres::hdf5::closeFile(file);
+    }
+
+    // build from HDF5
+    {
+        const size_t numberOfVoxels = size[0] * size[1] * size[2];
+        bool thrown = false;
+        try {
+            CWX hdf5CWX;
+            cwx::buildFromHDF5<Label>(hdf5CWX, fileName, "seg", numberOfVoxels);
+        }
+        catch(std::runtime_error&) {
+            thrown = true;
+        }
+        test(thrown);
+
+        CWX hdf5CWX;
+        cwx::buildFromHDF5<Label>(hdf5CWX, fileName, "seg", 64 * numberOfVoxels, false, 2);
+        test(hdf5CWX.buildMemory() <= 64 * numberOfVoxels);
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(hdf5CWX.numberOfCells(order) == serialCWX.numberOfCells(order));
+        }
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(hdf5CWX.grid()(x, y, z) == serialCWX.grid()(x, y, z));
+        }
+        Cell cell;
+        for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+        for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+        for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+            if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                test(hdf5CWX.atCell(cell) == serialCWX.atCell(cell));
+            }
+        }
+    }
+
+    // save and load
+    for(size_t redundantAnchors = 0; redundantAnchors < 2; ++redundantAnchors) {
+        CWX savedCWX(redundantAnchors == 1);
+        savedCWX.build(seg, false, 2);
+        {
+            hid_t file = andres::hdf5::createFile(fileName);
+            cwx::save(file, "cwx", savedCWX);
+            andres::hdf5::closeFile(file);
+        }
+        { // offsets are 64-bit unsigned integers in little endian
+            hid_t file = andres::hdf5::openFile(fileName);
+            hid_t dataset = H5Dopen(file, "cwx/above-offsets-0", H5P_DEFAULT);
+            test(dataset >= 0);
+            hid_t type = H5Dget_type(dataset);
+            test(H5Tequal(type, H5T_STD_U64LE) > 0);
+            H5Tclose(type);
+            H5Dclose(dataset);
+            andres::hdf5::closeFile(file);
+        }
+        CWX loadedCWX(false, CWX::VoxelLabelCache);
+        {
+            hid_t file = andres::hdf5::openFile(fileName);
+            cwx::load(file, "cwx", loadedCWX);
+            andres::hdf5::closeFile(file);
+        }
+        test(loadedCWX.labelCacheMemory() == 0);
+        for(unsigned char d = 0; d < 3; ++d) {
+            test(loadedCWX.shape(d) == savedCWX.shape(d));
+        }
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(loadedCWX.numberOfCells(order) == savedCWX.numberOfCells(order));
+            for(Label label = 1; label <= savedCWX.numberOfCells(order); ++label) {
+                if(order < 3) {
+                    test(loadedCWX.sizeAbove(order, label) == savedCWX.sizeAbove(order, label));
+                    for(size_t j = 0; j < savedCWX.sizeAbove(order, label); ++j) {
+                        test(loadedCWX.above(order, label, j) == savedCWX.above(order, label, j));
+                    }
+                }
+                if(order > 0) {
+                    test(loadedCWX.sizeBelow(order, label) == savedCWX.sizeBelow(order, label));
+                    for(size_t j = 0; j < savedCWX.sizeBelow(order, label); ++j) {
+                        test(loadedCWX.below(order, label, j) == savedCWX.below(order, label, j));
+                    }
+                }
+            }
+        }
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(loadedCWX.grid()(x, y, z) == savedCWX.grid()(x, y, z));
+        }
+        Cell cell;
+        for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+        for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+        for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+            if(cell.order() != 0 || savedCWX.isMarked(cell)) {
+                test(loadedCWX.atCell(cell) == savedCWX.atCell(cell));
+            }
+        }
+    }
+
+    // load of corrupt labels and anchors
+    for(size_t j = 0; j < 4; ++j) {
+        CWX savedCWX(true);
+        savedCWX.build(seg);
+        {
+            hid_t file = andres::hdf5::createFile(fileName);
+            cwx::save(file, "cwx", savedCWX);
+            andres::hdf5::closeFile(file);
+        }
+        const char* datasetNames[] = {"cwx/above-labels-0", "cwx/anchored-cells", "cwx/anchor-labels", "cwx/anchor-cells"};
+        const unsigned int values[] = {0, 0,
+            savedCWX.numberOfCells(0) + savedCWX.numberOfCells(1) + savedCWX.numberOfCells(2) + savedCWX.numberOfCells(3) + 1,
+            2 * static_cast<unsigned int>(size[0])};
+        {
+            // overwrite the first element of the dataset
+            hid_t file = andres::hdf5::openFile(fileName, andres::hdf5::READ_WRITE);
+            hid_t dataset = H5Dopen(file, datasetNames[j], H5P_DEFAULT);
+            test(dataset >= 0);
+            hid_t dataspace = H5Dget_space(dataset);
+            std::vector<unsigned int> data(static_cast<size_t>(H5Sget_simple_extent_npoints(dataspace)));
+            test(!data.empty());
+            test(H5Dread(dataset, H5T_NATIVE_UINT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0]) >= 0);
+            data[0] = values[j];
+            test(H5Dwrite(dataset, H5T_NATIVE_UINT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &data[0]) >= 0);
+            H5Sclose(dataspace);
+            H5Dclose(dataset);
+            andres::hdf5::closeFile(file);
+        }
+        bool thrown = false;
+        try {
+            CWX loadedCWX;
+            hid_t file = andres::hdf5::openFile(fileName);
+            try {
+                cwx::load(file, "cwx", loadedCWX);
+            }
+            catch(...) {
+                andres::hdf5::closeFile(file);
+                throw;
+            }
+            andres::hdf5::closeFile(file);
+        }
+        catch(std::runtime_error&) {
+            thrown = true;
+        }
+        test(thrown);
+    }
+
+    // save and load across layouts
+    {
+        typedef cwx::CWX<Label, Coordinate, cwx::SparseLayout<4> > SparseCWX;
+        SparseCWX sparseCWX;
+        sparseCWX.build(seg);
+        {
+            hid_t file = andres::hdf5::createFile(fileName);
+            cwx::save(file, "sparse", sparseCWX);
+            cwx::save(file, "dense", serialCWX);
+            andres::hdf5::closeFile(file);
+        }
+        CWX loadedCWX;
+        SparseCWX loadedSparseCWX;
+        {
+            hid_t file = andres::hdf5::openFile(fileName);
+            cwx::load(file, "sparse", loadedCWX);
+            cwx::load(file, "dense", loadedSparseCWX);
+            andres::hdf5::closeFile(file);
+        }
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(loadedCWX.grid()(x, y, z) == serialCWX.grid()(x, y, z));
+        }
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(loadedCWX.numberOfCells(order) == serialCWX.numberOfCells(order));
+            test(loadedSparseCWX.numberOfCells(order) == serialCWX.numberOfCells(order));
+        }
+        Cell cell;
+        for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+        for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+        for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+            if(cell.order() != 0 || serialCWX.isMarked(cell)) {
+                test(loadedCWX.atCell(cell) == sparseCWX.atCell(cell));
+                test(loadedSparseCWX.atCell(cell) == serialCWX.atCell(cell));
+            }
+        }
+    }
+
+    std::remove(fileName.c_str());
+    return 0;
+}
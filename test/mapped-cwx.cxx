@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "cwx/mapped-cwx.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+struct CellCollector {
+    bool operator()(const cwx::Cell<unsigned int>& cell) {
+        cells.push_back(cell);
+        return true;
+    }
+    std::vector<cwx::Cell<unsigned int> > cells;
+};
+
+int main() {
+    typedef unsigned int Label;
+    typedef unsigned int Coordinate;
+    typedef cwx::Cell<Coordinate> Cell;
+    typedef cwx::CWX<Label, Coordinate> CWX;
+    typedef cwx::MappedCWX<Label, Coordinate> MappedCWX;
+
+    const std::string fileName = "test-mapped-cwx.bin";
+    size_t size[] = {11, 9, 13};
+    andres::Marray<Label> seg(size, size + 3);
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<Label> distribution(1, 4);
+    std::vector<Label> blockLabels(4 * 4 * 5);
+    for(size_t j = 0; j < blockLabels.size(); ++j) {
+        blockLabels[j] = distribution(generator);
+    }
+    for(size_t z = 0; z < size[2]; ++z)
+    for(size_t y = 0; y < size[1]; ++y)
+    for(size_t x = 0; x < size[0]; ++x) {
+        seg(x, y, z) = blockLabels[x / 3 + 4 * (y / 3) + 16 * (z / 3)];
+    }
+
+    for(size_t redundantAnchors = 0; redundantAnchors < 2; ++redundantAnchors) {
+        CWX cwx(redundantAnchors == 1);
+        cwx.build(seg);
+        cwx::saveMapped(fileName, cwx);
+        MappedCWX mapped(fileName);
+
+        test(mapped.redundantAnchors() == (redundantAnchors == 1));
+        for(unsigned char d = 0; d < 3; ++d) {
+            test(mapped.shape(d) == cwx.shape(d));
+        }
+        for(unsigned char order = 0; order < 4; ++order) {
+            test(mapped.numberOfCells(order) == cwx.numberOfCells(order));
+            for(Label label = 1; label <= cwx.numberOfCells(order); ++label) {
+                if(order < 3) {
+                    test(mapped.sizeAbove(order, label) == cwx.sizeAbove(order, label));
+                    for(size_t j = 0; j < cwx.sizeAbove(order, label); ++j) {
+                        test(mapped.above(order, label, j) == cwx.above(order, label, j));
+                    }
+                }
+                if(order > 0) {
+                    test(mapped.sizeBelow(order, label) == cwx.sizeBelow(order, label));
+                    for(size_t j = 0; j < cwx.sizeBelow(order, label); ++j) {
+                        test(mapped.below(order, label, j) == cwx.below(order, label, j));
+                    }
+                }
+                CellCollector mappedCells;
+                CellCollector cells;
+                mapped.process(order, label, mappedCells);
+                cwx.process(order, label, cells);
+                test(mappedCells.cells == cells.cells);
+            }
+        }
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(mapped.grid()(x, y, z) == cwx.grid()(x, y, z));
+            test(mapped.atVoxel(x, y, z) == cwx.atVoxel(x, y, z));
+        }
+        Cell cell;
+        for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+        for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+        for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+            test(mapped.isMarked(cell) == cwx.isMarked(cell));
+            if(cell.order() != 0 || cwx.isMarked(cell)) {
+                test(mapped.atCell(cell) == cwx.atCell(cell));
+            }
+        }
+    }
+
+    // sparse layout
+    {
+        CWX cwx;
+        cwx.build(seg);
+        cwx::CWX<Label, Coordinate, cwx::SparseLayout<4> > sparseCWX;
+        sparseCWX.build(seg);
+        cwx::saveMapped(fileName, sparseCWX);
+        MappedCWX mapped(fileName);
+        for(size_t z = 0; z < size[2]; ++z)
+        for(size_t y = 0; y < size[1]; ++y)
+        for(size_t x = 0; x < size[0]; ++x) {
+            test(mapped.grid()(x, y, z) == cwx.grid()(x, y, z));
+        }
+        Cell cell;
+        for(cell[2] = 0; cell[2] < 2 * size[2] - 1; ++cell[2])
+        for(cell[1] = 0; cell[1] < 2 * size[1] - 1; ++cell[1])
+        for(cell[0] = 0; cell[0] < 2 * size[0] - 1; ++cell[0]) {
+            if(cell.order() != 0 || cwx.isMarked(cell)) {
+                test(mapped.atCell(cell) == sparseCWX.atCell(cell));
+            }
+        }
+    }
+
+    // invalid files
+    {
+        std::ofstream file(fileName.c_str(), std::ios::binary | std::ios::trunc);
+        file << "this is not a binary CWX file.";
+    }
+    bool thrown = false;
+    try {
+        MappedCWX mapped(fileName);
+    }
+    catch(std::runtime_error&) {
+        thrown = true;
+    }
+    test(thrown);
+
+    // corrupt offsets, labels and anchor keys
+    for(size_t j = 0; j < 5; ++j) {
+        typedef cwx::detail::MappedHeader Header;
+        CWX cwx;
+        cwx.build(seg);
+        cwx::saveMapped(fileName, cwx);
+        Header header;
+        {
+            std::ifstream file(fileName.c_str(), std::ios::binary);
+            file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+        }
+        // overwrite an element of a section
+        const size_t sections[] = {Header::AboveOffsetsSection, Header::AboveOffsetsSection,
+            Header::AboveLabelsSection, Header::BelowLabelsSection + 2, Header::AnchorKeysSection};
+        const size_t elementSizes[] = {sizeof(uint64_t), sizeof(uint64_t), sizeof(Label), sizeof(Label), sizeof(uint64_t)};
+        const size_t positions[] = {0, 1, 0, 0, 1};
+        uint64_t anchorKey = 0;
+        {
+            std::ifstream file(fileName.c_str(), std::ios::binary);
+            file.seekg(header.sectionOffsets[Header::AnchorKeysSection]);
+            file.read(reinterpret_cast<char*>(&anchorKey), sizeof(uint64_t));
+        }
+        const uint64_t values[] = {1, header.sectionSizes[Header::AboveLabelsSection] + 1, 0,
+            header.numberOfCells[2] + 1, anchorKey};
+        {
+            std::fstream file(fileName.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(header.sectionOffsets[sections[j]] + positions[j] * elementSizes[j]);
+            if(elementSizes[j] == sizeof(uint64_t)) {
+                file.write(reinterpret_cast<const char*>(&values[j]), sizeof(uint64_t));
+            }
+            else {
+                const Label value = static_cast<Label>(values[j]);
+                file.write(reinterpret_cast<const char*>(&value), sizeof(Label));
+            }
+        }
+        bool thrown = false;
+        try {
+            MappedCWX mapped(fileName);
+        }
+        catch(std::runtime_error&) {
+            thrown = true;
+        }
+        test(thrown);
+    }
+
+    std::remove(fileName.c_str());
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdexcept>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "cwx/packed-cell.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+int main() {
+    typedef cwx::Cell<unsigned int> Cell;
+    typedef cwx::PackedCell PackedCell;
+
+    // order and parity
+    {
+        PackedCell cell(Cell(0, 0, 0));
+        test(cell.order() == 3);
+        cell = PackedCell(Cell(0, 0, 1));
+        test(cell.order() == 2);
+        test(!cell.isOdd(0) && !cell.isOdd(1) && cell.isOdd(2));
+        cell = PackedCell(Cell(0, 1, 1));
+        test(cell.order() == 1);
+        cell = PackedCell(Cell(1, 1, 1));
+        test(cell.order() == 0);
+    }
+
+    // coordinates, unpacking and stepping
+    {
+        const unsigned int maximum = (1u << 21) - 1;
+        const Cell cell(maximum, 7, maximum - 1);
+        PackedCell packed(cell);
+        test(packed[0] == maximum);
+        test(packed[1] == 7);
+        test(packed[2] == maximum - 1);
+        test(packed.key() == cwx::detail::packCell(cell));
+        test(PackedCell(packed.key()) == packed);
+        Cell unpacked;
+        packed.unpack(unpacked);
+        test(unpacked == cell);
+
+        packed.decrement(0);
+        packed.increment(1);
+        packed.increment(2);
+        test(packed[0] == maximum - 1);
+        test(packed[1] == 8);
+        test(packed[2] == maximum);
+        test(cell.order() == 1);
+        test(packed.order() == 2);
+        packed.decrement(1);
+        test(packed.order() == 1);
+    }
+
+    // packed cells are ordered like cells
+    {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<unsigned int> distribution(0, 5);
+        std::vector<Cell> cells(200);
+        for(size_t j = 0; j < cells.size(); ++j) {
+            cells[j].assign(distribution(generator), distribution(generator), distribution(generator));
+        }
+        for(size_t j = 0; j < cells.size(); ++j)
+        for(size_t k = 0; k < cells.size(); ++k) {
+            const PackedCell a(cells[j]);
+            const PackedCell b(cells[k]);
+            test((a < b) == (cells[j] < cells[k]));
+            test((a == b) == (cells[j] == cells[k]));
+            test((a != b) == (cells[j] != cells[k]));
+            test(a.order() == cells[j].order());
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdexcept>
+#include <vector>
+
+#include "cwx/parallel.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+int main() {
+    // slab partition
+    for(size_t size = 0; size < 20; ++size)
+    for(size_t numberOfSlabs = 1; numberOfSlabs < 25; ++numberOfSlabs) {
+        cwx::SlabPartition slabs(size, numberOfSlabs);
+        test(slabs.numberOfSlabs() == (size < numberOfSlabs ? size : numberOfSlabs));
+        size_t end = 0;
+        for(size_t j = 0; j < slabs.numberOfSlabs(); ++j) {
+            test(slabs.begin(j) == end);
+            test(slabs.end(j) > slabs.begin(j));
+            test(slabs.end(j) - slabs.begin(j) <= size / slabs.numberOfSlabs() + 1);
+            end = slabs.end(j);
+        }
+        test(end == size);
+    }
+
+    // parallel for
+    {
+        std::vector<size_t> out(7, 0);
+        cwx::parallelFor(out.size(), [&](const size_t j) {
+            out[j] = j + 1;
+        });
+        for(size_t j = 0; j < out.size(); ++j) {
+            test(out[j] == j + 1);
+        }
+    }
+
+    // exceptions are rethrown in the calling thread
+    {
+        bool caught = false;
+        try {
+            cwx::parallelFor(4, [](const size_t j) {
+                if(j == 2) {
+                    throw std::runtime_error("expected");
+                }
+            });
+        }
+        catch(std::runtime_error&) {
+            caught = true;
+        }
+        test(caught);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <stdexcept>
+
+#include "cwx/traversal-workspace.hxx"
+
+inline void test(const bool& pred) {
+    if(!pred) throw std::runtime_error("Test failed.");
+}
+
+int main() {
+    typedef cwx::TraversalWorkspace<unsigned int> TraversalWorkspace;
+    typedef TraversalWorkspace::CellType CellType;
+
+    TraversalWorkspace workspace;
+
+    // visited set
+    for(size_t traversal = 0; traversal < 3; ++traversal) {
+        workspace.begin();
+        test(workspace.numberOfVisitedCells() == 0);
+        CellType c;
+        size_t n = 0;
+        for(c[2] = 0; c[2] < 9; ++c[2])
+        for(c[1] = 0; c[1] < 9; ++c[1])
+        for(c[0] = 0; c[0] < 9; ++c[0]) {
+            if((c[0] + c[1] + c[2] + traversal) % 2 == 0) {
+                test(!workspace.isVisited(c));
+                test(workspace.visit(c));
+                test(!workspace.visit(c));
+                ++n;
+            }
+        }
+        test(workspace.numberOfVisitedCells() == n);
+        for(c[2] = 0; c[2] < 9; ++c[2])
+        for(c[1] = 0; c[1] < 9; ++c[1])
+        for(c[0] = 0; c[0] < 9; ++c[0]) {
+            test(workspace.isVisited(c) == ((c[0] + c[1] + c[2] + traversal) % 2 == 0));
+            test(workspace.isVisited(cwx::PackedCell(c)) == workspace.isVisited(c));
+        }
+        c.assign(10, 11, 12);
+        test(workspace.visit(cwx::PackedCell(c)));
+        test(!workspace.visit(c));
+        test(workspace.isVisited(c));
+    }
+
+    // queue
+    {
+        workspace.begin();
+        test(workspace.empty());
+        unsigned int pushed = 0;
+        unsigned int popped = 0;
+        for(size_t j = 0; j < 100; ++j) {
+            // push three, pop two, such that the ring buffer wraps and grows
+            for(size_t k = 0; k < 3; ++k) {
+                workspace.push(CellType(pushed, 0, 0));
+                ++pushed;
+            }
+            for(size_t k = 0; k < 2; ++k) {
+                test(workspace.front()[0] == popped);
+                workspace.pop();
+                ++popped;
+            }
+        }
+        while(!workspace.empty()) {
+            test(workspace.front()[0] == popped);
+            workspace.pop();
+            ++popped;
+        }
+        test(popped == pushed);
+        workspace.push(cwx::PackedCell(CellType(4, 5, 6)));
+        workspace.push(CellType(7, 8, 9));
+        test(workspace.front() == CellType(4, 5, 6));
+        workspace.pop();
+        test(workspace.packedFront() == cwx::PackedCell(CellType(7, 8, 9)));
+        workspace.pop();
+        test(workspace.empty());
+        workspace.push(CellType(1, 2, 3));
+        workspace.begin();
+        test(workspace.empty());
+    }
+
+    return 0;
+}